@@ -0,0 +1,262 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_BANDPARALLELRENDERER_HH
+#define VGXX_BANDPARALLELRENDERER_HH
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include <vgxx/cell_processor.hh>
+#include <vgxx/fill_rule.hh>
+#include <vgxx/offset_blender.hh>
+#include <vgxx/pixel_box.hh>
+#include <vgxx/rasterizer.hh>
+#include <vgxx/segment_list.hh>
+#include <vgxx/thread_pool.hh>
+
+namespace vgxx
+{
+
+// Fills a single large outline on all workers of a thread pool. The
+// canvas is split into bands of rows; each worker rasterizes only the
+// lines that touch its band into a band-sized cell processor and swipes
+// its own rows. Every row is computed exactly as Renderer computes it, so
+// the output is bit-identical to a serial fill.
+template<class B, class P = Cell_processor>
+struct Band_parallel_renderer
+{
+  using Blender = B;
+  using Cell_processor = P;
+  using Coord = typename Cell_processor::Coord;
+  using Int_32 = ::std::int32_t;
+  using Size = ::std::size_t;
+
+private:
+  template<class T, class... Args>
+  using Is_constructible_ = typename ::std::is_constructible<T, Args...>::type;
+
+  template<bool, class = void>
+  struct Enable_if_
+  {};
+
+  template<class T>
+  struct Enable_if_<true, T>
+  {
+    using Type = T;
+  };
+
+public:
+  // A band height of zero picks one that gives each worker a few bands.
+  template<
+    class... Blender_args,
+    bool e = Is_constructible_<Blender, Blender_args&&...>::value,
+    class = typename Enable_if_<e>::Type>
+  explicit Band_parallel_renderer(
+    Thread_pool& pool,
+    Coord const width,
+    Coord const height,
+    Coord const band_height,
+    Blender_args&&... blender_args) :
+    pool_(pool),
+    blender_(static_cast<Blender_args&&>(blender_args)...),
+    width_(width),
+    height_(height),
+    band_height_(
+      0u < band_height ? band_height : auto_band_height_(pool, height))
+  {
+    assert(0u < width);
+    assert(0u < height);
+
+    workers_.reserve(pool.worker_count());
+    for(Size i = pool.worker_count(); 0u < i; --i)
+    {
+      workers_.push_back(
+        Worker_{Rasterizer(), Cell_processor(width, band_height_)});
+    }
+  }
+
+  [[nodiscard]] Blender& blender() noexcept
+  {
+    return blender_;
+  }
+
+  [[nodiscard]] Blender const& blender() const noexcept
+  {
+    return blender_;
+  }
+
+  void move_to(float const x, float const y)
+  {
+    segments_.move_to(x, y);
+  }
+
+  void line_to(float const x, float const y)
+  {
+    segments_.line_to(x, y);
+  }
+
+  void bezier_to(
+    float const x_1,
+    float const y_1,
+    float const x_2,
+    float const y_2,
+    float const x_3,
+    float const y_3)
+  {
+    segments_.bezier_to(x_1, y_1, x_2, y_2, x_3, y_3);
+  }
+
+  void close_outline()
+  {
+    segments_.close_outline();
+  }
+
+  // Fills the current outline and returns the bounds of the pixels it
+  // has blended.
+  Pixel_box fill(Fill_rule const fill_rule)
+  {
+    segments_.close_outline();
+    Pixel_box box = fill(segments_, fill_rule);
+    segments_.clear();
+    return box;
+  }
+
+  Pixel_box fill(Segment_list const& segments, Fill_rule const fill_rule)
+  {
+    Pixel_box box;
+
+    if(!segments.empty())
+    {
+      Int_32 const height = static_cast<Int_32>(height_);
+      Int_32 const band_height = static_cast<Int_32>(band_height_);
+      Int_32 row_min = segments.row_min();
+      Int_32 row_max = segments.row_max();
+      if(0 > row_min)
+      {
+        row_min = 0;
+      }
+      if(height <= row_max)
+      {
+        row_max = height - 1;
+      }
+
+      if(row_min <= row_max)
+      {
+        Int_32 const band_min = row_min / band_height;
+        Int_32 const band_max = row_max / band_height;
+        auto const band_count = static_cast<Size>(band_max - band_min + 1);
+        band_boxes_.assign(band_count, Pixel_box());
+
+        pool_.run(
+          band_count,
+          [&, band_min, band_height](Size const i, Size const worker_index)
+          {
+            auto& worker = workers_[worker_index];
+            Int_32 const band_y = (band_min + static_cast<Int_32>(i)) *
+              band_height;
+            Int_32 const row_count = height - band_y < band_height ?
+              height - band_y : band_height;
+            Offset_blender<Blender> blender(blender_, 0, band_y);
+
+            // The last band may be shorter.
+            if(static_cast<Int_32>(worker.cell_proc.height()) != row_count)
+            {
+              worker.cell_proc.resize(width_, static_cast<Coord>(row_count));
+            }
+
+            segments.rasterize(
+              worker.rasterizer,
+              worker.cell_proc,
+              0,
+              -band_y,
+              band_y,
+              band_y + row_count - 1);
+            Pixel_box band_box = worker.cell_proc.swipe(blender, fill_rule);
+
+            if(band_box)
+            {
+              band_box.y_min += band_y;
+              band_box.y_max += band_y;
+            }
+
+            band_boxes_[i] = band_box;
+          });
+
+        for(auto const& band_box : band_boxes_)
+        {
+          box.unite(band_box);
+        }
+      }
+    }
+
+    return box;
+  }
+
+private:
+  template<class T>
+  using Vector_ = ::std::vector<T>;
+
+  struct Worker_
+  {
+    Rasterizer rasterizer;
+    Cell_processor cell_proc;
+  };
+
+  [[nodiscard]] static Coord auto_band_height_(
+    Thread_pool const& pool,
+    Coord const height) noexcept
+  {
+    Size const band_count = pool.worker_count() * 4u;
+    Size band_height = (static_cast<Size>(height) + band_count - 1u) /
+      band_count;
+    band_height = (band_height + 15u) & ~Size{15u};
+    if(32u > band_height)
+    {
+      band_height = 32u;
+    }
+    if(height < band_height)
+    {
+      band_height = height;
+    }
+
+    return static_cast<Coord>(band_height);
+  }
+
+  Thread_pool& pool_;
+  Blender blender_;
+  Segment_list segments_;
+  Vector_<Worker_> workers_;
+  Vector_<Pixel_box> band_boxes_;
+  Coord width_;
+  Coord height_;
+  Coord band_height_;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_BANDPARALLELRENDERER_HH
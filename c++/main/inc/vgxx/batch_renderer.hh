@@ -0,0 +1,167 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_BATCHRENDERER_HH
+#define VGXX_BATCHRENDERER_HH
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include <vgxx/latency_histogram.hh>
+#include <vgxx/thread_pool.hh>
+
+namespace vgxx
+{
+
+struct Batch_stats
+{
+  using Size = ::std::size_t;
+  using Unt_64 = ::std::uint64_t;
+
+  [[nodiscard]] double jobs_per_second() const noexcept
+  {
+    return 0u < wall_nanoseconds ?
+      static_cast<double>(job_count) * 1e9 /
+        static_cast<double>(wall_nanoseconds) :
+      0.;
+  }
+
+  Size job_count = 0u;
+  Unt_64 wall_nanoseconds = 0u;
+
+  // Time each job spent running, from start to return.
+  Latency_histogram latency;
+};
+
+// Runs many small independent render jobs on a thread pool. Every worker
+// keeps its own renderer, so after the first job the cell processor rows
+// and cell stash are warm and no job pays for constructing one. Jobs run
+// on per-worker ranges of the batch and idle workers steal from the
+// others.
+template<class R>
+struct Batch_renderer
+{
+  using Renderer = R;
+  using Blender = typename Renderer::Blender;
+  using Coord = typename Renderer::Coord;
+  using Size = ::std::size_t;
+
+  // State of one worker, handed to the jobs it runs.
+  struct alignas(64) Worker
+  {
+    // Returns the renderer of this worker resized to the requested canvas,
+    // with a blender constructed from the arguments. Constructs the
+    // renderer on first use.
+    template<class... Blender_args>
+    [[nodiscard]] Renderer& renderer(
+      Coord const width,
+      Coord const height,
+      Blender_args&&... blender_args)
+    {
+      if(!renderer_)
+      {
+        return renderer_.emplace(
+          width, height, static_cast<Blender_args&&>(blender_args)...);
+      }
+
+      renderer_->resize(width, height);
+      renderer_->blender() =
+        Blender(static_cast<Blender_args&&>(blender_args)...);
+      return *renderer_;
+    }
+
+  private:
+    friend Batch_renderer;
+
+    ::std::optional<Renderer> renderer_;
+    Latency_histogram latency_;
+  };
+
+  Batch_renderer(Batch_renderer&&) = delete;
+  Batch_renderer(Batch_renderer const&) = delete;
+
+  explicit Batch_renderer(Thread_pool& pool) :
+    pool_(pool),
+    workers_(pool.worker_count())
+  {}
+
+  Batch_renderer& operator =(Batch_renderer&&) = delete;
+  Batch_renderer& operator =(Batch_renderer const&) = delete;
+
+  // Calls job(job_index, worker) for every job index below job_count and
+  // returns the throughput and latency of the batch. Rethrows the first
+  // exception thrown by a job.
+  template<class Job>
+  Batch_stats run(Size const job_count, Job&& job)
+  {
+    for(auto& worker : workers_)
+    {
+      worker.latency_.clear();
+    }
+
+    auto const start = Clock_::now();
+    pool_.run(job_count, [&](Size const i, Size const worker_index)
+      {
+        auto& worker = workers_[worker_index];
+        auto const job_start = Clock_::now();
+        job(i, worker);
+        worker.latency_.add(nanoseconds_(Clock_::now() - job_start));
+      });
+
+    Batch_stats stats;
+    stats.job_count = job_count;
+    stats.wall_nanoseconds = nanoseconds_(Clock_::now() - start);
+    for(auto const& worker : workers_)
+    {
+      stats.latency.merge(worker.latency_);
+    }
+
+    return stats;
+  }
+
+private:
+  using Clock_ = ::std::chrono::steady_clock;
+
+  template<class T>
+  using Vector_ = ::std::vector<T>;
+
+  template<class Duration>
+  [[nodiscard]] static ::std::uint64_t nanoseconds_(
+    Duration const& duration) noexcept
+  {
+    return static_cast<::std::uint64_t>(
+      ::std::chrono::duration_cast<::std::chrono::nanoseconds>(
+        duration).count());
+  }
+
+  Thread_pool& pool_;
+  Vector_<Worker> workers_;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_BATCHRENDERER_HH
@@ -0,0 +1,348 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_BLEND565_HH
+#define VGXX_BLEND565_HH
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <vgxx/simd.hh>
+#include <vgxx/util.hh>
+
+namespace vgxx
+{
+
+// Span kernels for RGB565 pixels, red in the top bits. Pixels are widened
+// to 8 bits per channel by bit replication, blended like the 32-bit
+// kernels and quantized back with a per-column bias from a dithering row
+// (see Dither_map); channels the blend leaves unchanged keep their level,
+// so blending again never drifts a pixel. The SSE2 variant handles 8
+// pixels per iteration and is bit-exact with blend_pixel().
+//
+// Colors are 32-bit with red in the low byte and alpha in the top one, as
+// for Color_blender_rgba_8888.
+class Blend_565
+{
+  using Unt_8_ = ::std::uint8_t;
+  using Unt_16_ = ::std::uint16_t;
+  using Unt_32_ = ::std::uint32_t;
+  using Int_32_ = ::std::int32_t;
+
+public:
+  using Size = ::std::size_t;
+
+  // Quantizes 8-bit channels: level = (v * max + bias) / 255.
+  [[nodiscard]] static Unt_16_ pack(
+    Unt_32_ const r,
+    Unt_32_ const g,
+    Unt_32_ const b,
+    Unt_32_ const bias) noexcept
+  {
+    return static_cast<Unt_16_>(
+      ((r * 31u + bias) / 255u) << 11u |
+      ((g * 63u + bias) / 255u) << 5u |
+      ((b * 31u + bias) / 255u));
+  }
+
+  static void unpack(
+    Unt_16_ const pixel,
+    Unt_32_& r,
+    Unt_32_& g,
+    Unt_32_& b) noexcept
+  {
+    Unt_32_ const r_5 = pixel >> 11u;
+    Unt_32_ const g_6 = (pixel >> 5u) & 0x3fu;
+    Unt_32_ const b_5 = pixel & 0x1fu;
+    r = (r_5 << 3u) | (r_5 >> 2u);
+    g = (g_6 << 2u) | (g_6 >> 4u);
+    b = (b_5 << 3u) | (b_5 >> 2u);
+  }
+
+  static void blend_pixel(
+    Unt_16_& dst,
+    Unt_32_ const color,
+    Unt_32_ alpha,
+    Unt_32_ const bias) noexcept
+  {
+    alpha *= color >> 24u;
+    alpha = (alpha + 1u + (alpha >> 8u)) >> 8u; // alpha /= 255
+    if(0u == alpha)
+    {
+      return;
+    }
+
+    Unt_32_ r, g, b;
+    unpack(dst, r, g, b);
+    auto const a = static_cast<Int_32_>(alpha);
+    dst = static_cast<Unt_16_>(
+      requantize_(
+        blend_channel_(color & 0xffu, r, a), r, dst >> 11u, 31u, bias) <<
+        11u |
+      requantize_(
+        blend_channel_((color >> 8u) & 0xffu, g, a), g, (dst >> 5u) & 0x3fu,
+        63u, bias) << 5u |
+      requantize_(
+        blend_channel_((color >> 16u) & 0xffu, b, a), b, dst & 0x1fu, 31u,
+        bias));
+  }
+
+  // Blends color over count pixels at dst with the coverage of each.
+  // biases holds the dithering bias of every pixel, see Dither_map::row().
+  static void blend_span(
+    Unt_16_* dst,
+    Unt_8_ const* coverage,
+    Size count,
+    Unt_32_ const color,
+    Unt_8_ const* const bias_row,
+    unsigned const bias_mask,
+    Int_32_ x,
+    Simd_level const level = Simd::level()) noexcept
+  {
+    if(0u == color >> 24u)
+    {
+      return;
+    }
+
+#if defined(VGXX_SIMD_X86)
+    if(Simd_level::sse2 <= Simd::clamp(level))
+    {
+      for(; 8u <= count; count -= 8u)
+      {
+        blend_8_sse2_<true>(
+          dst, coverage, 0u, color, bias_row + (x & bias_mask));
+        dst += 8u;
+        coverage += 8u;
+        x += 8;
+      }
+    }
+#else
+    static_cast<void>(level);
+#endif
+
+    for(; 0u < count; --count)
+    {
+      blend_pixel(*dst++, color, *coverage++, bias_row[x++ & bias_mask]);
+    }
+  }
+
+  // Blends color over count pixels at dst, all with the same coverage.
+  static void blend_solid(
+    Unt_16_* dst,
+    Unt_32_ const coverage,
+    Size count,
+    Unt_32_ const color,
+    Unt_8_ const* const bias_row,
+    unsigned const bias_mask,
+    Int_32_ x,
+    Simd_level const level = Simd::level()) noexcept
+  {
+    Unt_32_ const alpha = coverage * (color >> 24u);
+    if(0u == (alpha + 1u + (alpha >> 8u)) >> 8u) // alpha / 255
+    {
+      return;
+    }
+
+    if(0xffu * 0xffu == alpha)
+    {
+      // The result only depends on the column, so quantize one period of
+      // the dithering row and repeat it.
+      Unt_16_ pattern[16];
+      assert(16u > bias_mask);
+      for(unsigned i = 0u; bias_mask >= i; ++i)
+      {
+        pattern[i] = pack(
+          color & 0xffu, (color >> 8u) & 0xffu, (color >> 16u) & 0xffu,
+          bias_row[i]);
+      }
+
+      for(; 0u < count; --count)
+      {
+        *dst++ = pattern[x++ & bias_mask];
+      }
+      return;
+    }
+
+#if defined(VGXX_SIMD_X86)
+    if(Simd_level::sse2 <= Simd::clamp(level))
+    {
+      for(; 8u <= count; count -= 8u)
+      {
+        blend_8_sse2_<false>(
+          dst, nullptr, coverage, color, bias_row + (x & bias_mask));
+        dst += 8u;
+        x += 8;
+      }
+    }
+#else
+    static_cast<void>(level);
+#endif
+
+    for(; 0u < count; --count)
+    {
+      blend_pixel(*dst++, color, coverage, bias_row[x++ & bias_mask]);
+    }
+  }
+
+private:
+  // Quantizes a blended channel, keeping the level of the destination when
+  // the blend left the channel unchanged: quantizing that level again with
+  // the bias of another pixel could move it, so repeated blends would
+  // drift.
+  [[nodiscard]] static Unt_32_ requantize_(
+    Unt_32_ const v,
+    Unt_32_ const dst,
+    Unt_32_ const dst_level,
+    Unt_32_ const max,
+    Unt_32_ const bias) noexcept
+  {
+    return v == dst ? dst_level : (v * max + bias) / 255u;
+  }
+
+  [[nodiscard]] static Unt_32_ blend_channel_(
+    Unt_32_ const src,
+    Unt_32_ const dst,
+    Int_32_ const alpha) noexcept
+  {
+    return static_cast<Unt_32_>(Util::blend(
+      static_cast<Int_32_>(src), static_cast<Int_32_>(dst), alpha));
+  }
+
+#if defined(VGXX_SIMD_X86)
+  VGXX_SIMD_TARGET("sse2")
+  [[nodiscard]] static __m128i div_255_sse2_(__m128i const val) noexcept
+  {
+    __m128i const one = _mm_set1_epi16(1);
+    return _mm_srli_epi16(
+      _mm_add_epi16(_mm_add_epi16(val, one), _mm_srli_epi16(val, 8)), 8);
+  }
+
+  // dst * 255 + alpha * (src - dst), divided by 255.
+  VGXX_SIMD_TARGET("sse2")
+  [[nodiscard]] static __m128i blend_sse2_(
+    __m128i const src,
+    __m128i const dst,
+    __m128i const alpha) noexcept
+  {
+    __m128i val = _mm_sub_epi16(_mm_slli_epi16(dst, 8), dst);
+    val = _mm_add_epi16(
+      val, _mm_mullo_epi16(alpha, _mm_sub_epi16(src, dst)));
+    return div_255_sse2_(val);
+  }
+
+  // (v * max + bias) / 255, exact for values below 65536.
+  VGXX_SIMD_TARGET("sse2")
+  [[nodiscard]] static __m128i quantize_sse2_(
+    __m128i const v,
+    __m128i const max,
+    __m128i const bias) noexcept
+  {
+    __m128i const val = _mm_add_epi16(_mm_mullo_epi16(v, max), bias);
+    return _mm_srli_epi16(
+      _mm_mulhi_epu16(val, _mm_set1_epi16(static_cast<short>(0x8081))), 7);
+  }
+
+  // See requantize_().
+  VGXX_SIMD_TARGET("sse2")
+  [[nodiscard]] static __m128i requantize_sse2_(
+    __m128i const v,
+    __m128i const dst,
+    __m128i const dst_level,
+    __m128i const max,
+    __m128i const bias) noexcept
+  {
+    __m128i const same = _mm_cmpeq_epi16(v, dst);
+    return _mm_or_si128(
+      _mm_and_si128(same, dst_level),
+      _mm_andnot_si128(same, quantize_sse2_(v, max, bias)));
+  }
+
+  template<bool coverage_span>
+  VGXX_SIMD_TARGET("sse2")
+  static void blend_8_sse2_(
+    Unt_16_* const dst,
+    Unt_8_ const* const coverage,
+    Unt_32_ const solid_coverage,
+    Unt_32_ const color,
+    Unt_8_ const* const biases) noexcept
+  {
+    __m128i const zero = _mm_setzero_si128();
+    __m128i cov;
+    if constexpr(coverage_span)
+    {
+      cov = _mm_unpacklo_epi8(
+        _mm_loadl_epi64(reinterpret_cast<__m128i const*>(coverage)), zero);
+    }
+    else
+    {
+      cov = _mm_set1_epi16(static_cast<short>(solid_coverage));
+    }
+
+    __m128i const a = div_255_sse2_(_mm_mullo_epi16(
+      cov, _mm_set1_epi16(static_cast<short>(color >> 24u))));
+    if(0xffff == _mm_movemask_epi8(_mm_cmpeq_epi16(a, zero)))
+    {
+      return;
+    }
+
+    __m128i const d = _mm_loadu_si128(reinterpret_cast<__m128i*>(dst));
+    __m128i const mask_5 = _mm_set1_epi16(0x1f);
+    __m128i const mask_6 = _mm_set1_epi16(0x3f);
+    __m128i const r_5 = _mm_srli_epi16(d, 11);
+    __m128i const g_6 = _mm_and_si128(_mm_srli_epi16(d, 5), mask_6);
+    __m128i const b_5 = _mm_and_si128(d, mask_5);
+    __m128i const r =
+      _mm_or_si128(_mm_slli_epi16(r_5, 3), _mm_srli_epi16(r_5, 2));
+    __m128i const g =
+      _mm_or_si128(_mm_slli_epi16(g_6, 2), _mm_srli_epi16(g_6, 4));
+    __m128i const b =
+      _mm_or_si128(_mm_slli_epi16(b_5, 3), _mm_srli_epi16(b_5, 2));
+
+    __m128i const bias = _mm_unpacklo_epi8(
+      _mm_loadl_epi64(reinterpret_cast<__m128i const*>(biases)), zero);
+
+    __m128i const src_r = _mm_set1_epi16(static_cast<short>(color & 0xffu));
+    __m128i const src_g =
+      _mm_set1_epi16(static_cast<short>((color >> 8u) & 0xffu));
+    __m128i const src_b =
+      _mm_set1_epi16(static_cast<short>((color >> 16u) & 0xffu));
+
+    __m128i const q_r = requantize_sse2_(
+      blend_sse2_(src_r, r, a), r, r_5, mask_5, bias);
+    __m128i const q_g = requantize_sse2_(
+      blend_sse2_(src_g, g, a), g, g_6, mask_6, bias);
+    __m128i const q_b = requantize_sse2_(
+      blend_sse2_(src_b, b, a), b, b_5, mask_5, bias);
+    __m128i const result = _mm_or_si128(
+      _mm_or_si128(_mm_slli_epi16(q_r, 11), _mm_slli_epi16(q_g, 5)), q_b);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), result);
+  }
+#endif
+};
+
+} // namespace vgxx
+
+#endif // VGXX_BLEND565_HH
@@ -0,0 +1,810 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef VGXX_BLEND8888_HH
+#define VGXX_BLEND8888_HH
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <vgxx/simd.hh>
+
+namespace vgxx
+{
+
+// Span kernels shared by the 32-bit color blenders. The three color
+// channels go through the same math and the alpha byte is always set to
+// 0xff, so one kernel serves both RGBA and BGRA layouts.
+//
+// On x86 every kernel has SSE2, SSSE3 and AVX2 variants besides the
+// scalar one. The variant is picked at run time from Simd::level(), so
+// the header works in translation units built for the baseline ISA. All
+// the variants are bit-exact with blend_pixel().
+class Blend_8888
+{
+  using Unt_8_ = ::std::uint8_t;
+  using Unt_32_ = ::std::uint32_t;
+  using Unt_64_ = ::std::uint64_t;
+  using Int_32_ = ::std::int32_t;
+
+public:
+  using Size = ::std::size_t;
+
+  // Blends color over count pixels at dst, scaling the alpha of color by
+  // the coverage of each pixel.
+  static void blend_span(
+    Unt_32_* const dst,
+    Unt_8_ const* const coverage,
+    Size const count,
+    Unt_32_ const color) noexcept
+  {
+    blend_span(dst, coverage, count, color, Simd::level());
+  }
+
+  // Same as above with the variant for the given level, or the highest
+  // supported one below it. Meant for benchmarks and tests.
+  static void blend_span(
+    Unt_32_* dst,
+    Unt_8_ const* coverage,
+    Size count,
+    Unt_32_ const color,
+    Simd_level const level) noexcept
+  {
+    Unt_32_ const alpha = color >> 24u;
+    if(0u == alpha)
+    {
+      return;
+    }
+
+#if defined(VGXX_SIMD_X86)
+    Size simd_count = 0u;
+    switch(Simd::clamp(level))
+    {
+    case Simd_level::avx2:
+      simd_count = count & ~Size{7u};
+      blend_span_avx2_(dst, coverage, simd_count, color);
+      break;
+    case Simd_level::ssse3:
+      simd_count = count & ~Size{3u};
+      blend_span_ssse3_(dst, coverage, simd_count, color);
+      break;
+    case Simd_level::sse2:
+      simd_count = count & ~Size{3u};
+      blend_span_sse2_(dst, coverage, simd_count, color);
+      break;
+    default:
+      break;
+    }
+
+    dst += simd_count;
+    coverage += simd_count;
+    count -= simd_count;
+#else
+    static_cast<void>(level);
+#endif
+
+    for(; 0u < count; --count)
+    {
+      blend_pixel(*dst, color, *coverage);
+      ++dst;
+      ++coverage;
+    }
+  }
+
+  // Blends color over count pixels at dst, all with the same coverage.
+  static void blend_solid(
+    Unt_32_* const dst,
+    Unt_32_ const coverage,
+    Size const count,
+    Unt_32_ const color) noexcept
+  {
+    blend_solid(dst, coverage, count, color, Simd::level());
+  }
+
+  // Same as above with the variant for the given level, or the highest
+  // supported one below it.
+  static void blend_solid(
+    Unt_32_* dst,
+    Unt_32_ const coverage,
+    Size count,
+    Unt_32_ const color,
+    Simd_level const level) noexcept
+  {
+    Unt_32_ alpha = coverage * (color >> 24u);
+    if(0u == alpha)
+    {
+      return;
+    }
+
+    if(0xffu * 0xffu == alpha)
+    {
+      // Renderers blend one row at a time, so the size of a run says
+      // nothing about the size of the fill: keep runs in the cache.
+      fill_(dst, count, color, level, false);
+      return;
+    }
+
+    alpha = (alpha + 1u + (alpha >> 8u)) >> 8u; // alpha /= 255
+    auto const src_a = static_cast<Int_32_>(alpha);
+
+#if defined(VGXX_SIMD_X86)
+    Size simd_count = 0u;
+    switch(Simd::clamp(level))
+    {
+    case Simd_level::avx2:
+      simd_count = count & ~Size{7u};
+      blend_solid_avx2_(dst, src_a, simd_count, color);
+      break;
+    case Simd_level::ssse3:
+    case Simd_level::sse2:
+      // Nothing for SSSE3 to add with one alpha for all the pixels.
+      simd_count = count & ~Size{3u};
+      blend_solid_sse2_(dst, src_a, simd_count, color);
+      break;
+    default:
+      break;
+    }
+
+    dst += simd_count;
+    count -= simd_count;
+#else
+    static_cast<void>(level);
+#endif
+
+    for(; 0u < count; --count)
+    {
+      Unt_32_ const d = *dst;
+      *dst++ =
+        Unt_32_{0xff000000u} |
+        blend_channel_(color, d, src_a, 0u) |
+        blend_channel_(color, d, src_a, 8u) |
+        blend_channel_(color, d, src_a, 16u);
+    }
+  }
+
+  // Blends count source colors, each with its own alpha, over the pixels
+  // at dst, scaling every source alpha by the coverage of its pixel.
+  static void blend_colors(
+    Unt_32_* dst,
+    Unt_32_ const* colors,
+    Unt_8_ const* coverage,
+    Size count,
+    Simd_level const level = Simd::level()) noexcept
+  {
+#if defined(VGXX_SIMD_X86)
+    if(Simd_level::sse2 <= Simd::clamp(level))
+    {
+      Size const simd_count = count & ~Size{3u};
+      blend_colors_sse2_<true>(dst, colors, coverage, 0u, simd_count);
+      dst += simd_count;
+      colors += simd_count;
+      coverage += simd_count;
+      count -= simd_count;
+    }
+#else
+    static_cast<void>(level);
+#endif
+
+    for(; 0u < count; --count)
+    {
+      blend_pixel(*dst++, *colors++, *coverage++);
+    }
+  }
+
+  // Same as above with one coverage for all the pixels.
+  static void blend_colors(
+    Unt_32_* dst,
+    Unt_32_ const* colors,
+    Unt_32_ const coverage,
+    Size count,
+    Simd_level const level = Simd::level()) noexcept
+  {
+    if(0u == coverage)
+    {
+      return;
+    }
+
+#if defined(VGXX_SIMD_X86)
+    if(Simd_level::sse2 <= Simd::clamp(level))
+    {
+      Size const simd_count = count & ~Size{3u};
+      blend_colors_sse2_<false>(dst, colors, nullptr, coverage, simd_count);
+      dst += simd_count;
+      colors += simd_count;
+      count -= simd_count;
+    }
+#else
+    static_cast<void>(level);
+#endif
+
+    for(; 0u < count; --count)
+    {
+      blend_pixel(*dst++, *colors++, coverage);
+    }
+  }
+
+  // Calls to fill() and fill_rect() of at least this many bytes use
+  // non-temporal stores, which go around the cache, so that clearing a
+  // large image does not evict the cells and the rest of the working set.
+  // The decision is made per call, so it only applies to whole-image
+  // fills such as Mapped_canvas::clear(); solid runs blended by renderers
+  // always use regular stores.
+  static Size constexpr non_temporal_bytes = Size{1u} << 20u;
+
+  // Writes color to count pixels at dst.
+  static void fill(
+    Unt_32_* const dst,
+    Size const count,
+    Unt_32_ const color) noexcept
+  {
+    fill(dst, count, color, Simd::level());
+  }
+
+  static void fill(
+    Unt_32_* const dst,
+    Size const count,
+    Unt_32_ const color,
+    Simd_level const level) noexcept
+  {
+    fill_(dst, count, color, level, non_temporal_bytes / 4u <= count);
+  }
+
+  // Writes color to a width by height rectangle. Whether to bypass the
+  // cache depends on the size of the whole rectangle.
+  static void fill_rect(
+    Unt_32_* dst,
+    Size const bytes_per_row,
+    Size const width,
+    Size height,
+    Unt_32_ const color,
+    Simd_level const level = Simd::level()) noexcept
+  {
+    bool const stream = non_temporal_bytes / 4u <= width * height;
+    if(width * sizeof(Unt_32_) == bytes_per_row)
+    {
+      fill_(dst, width * height, color, level, stream);
+      return;
+    }
+
+    for(; 0u < height; --height)
+    {
+      fill_(dst, width, color, level, stream);
+      dst = reinterpret_cast<Unt_32_*>(
+        reinterpret_cast<char*>(dst) + bytes_per_row);
+    }
+  }
+
+  static void blend_pixel(
+    Unt_32_& dst,
+    Unt_32_ const color,
+    Unt_32_ alpha) noexcept
+  {
+    Unt_32_ const color_alpha = color >> 24u;
+
+    if(0xffu > alpha || 0xffu > color_alpha)
+    {
+      alpha *= color_alpha;
+      if(0u < alpha)
+      {
+        alpha = (alpha + 1u + (alpha >> 8u)) >> 8u; // alpha /= 255
+        auto const src_a = static_cast<Int_32_>(alpha);
+        dst =
+          Unt_32_{0xff000000u} |
+          blend_channel_(color, dst, src_a, 0u) |
+          blend_channel_(color, dst, src_a, 8u) |
+          blend_channel_(color, dst, src_a, 16u);
+      }
+    }
+    else
+    {
+      dst = color;
+    }
+  }
+
+private:
+  [[nodiscard]] static Unt_32_ blend_channel_(
+    Unt_32_ const src,
+    Unt_32_ const dst,
+    Int_32_ const alpha,
+    Unt_32_ const shift) noexcept
+  {
+    auto const s = static_cast<Int_32_>((src >> shift) & 0xffu);
+    auto const d = static_cast<Int_32_>((dst >> shift) & 0xffu);
+    Int_32_ val = (d << 8u) - d + alpha * (s - d);
+    val = (val + 1 + (val >> 8u)) >> 8u; // val / 255
+    return static_cast<Unt_32_>(val) << shift;
+  }
+
+  static void fill_(
+    Unt_32_* dst,
+    Size count,
+    Unt_32_ const color,
+    Simd_level const level,
+    bool const stream) noexcept
+  {
+#if defined(VGXX_SIMD_X86)
+    if(16u <= count)
+    {
+      switch(Simd::clamp(level))
+      {
+      case Simd_level::avx2:
+        fill_avx2_(dst, count, color, stream);
+        return;
+      case Simd_level::ssse3:
+      case Simd_level::sse2:
+        fill_sse2_(dst, count, color, stream);
+        return;
+      default:
+        break;
+      }
+    }
+#else
+    static_cast<void>(level);
+    static_cast<void>(stream);
+#endif
+
+    for(; 0u < count; --count)
+    {
+      *dst++ = color;
+    }
+  }
+
+#if defined(VGXX_SIMD_X86)
+  // The vector kernels work on 16-bit lanes. Those hold values up to
+  // 65280, so the unsigned intermediate results of the scalar formula fit
+  // without widening; the signed product alpha * (src - dst) wraps, but
+  // the sum it is added to does not.
+
+  VGXX_SIMD_TARGET("sse2")
+  static void blend_span_sse2_(
+    Unt_32_* dst,
+    Unt_8_ const* coverage,
+    Size count,
+    Unt_32_ const color) noexcept
+  {
+    assert(0u == count % 4u);
+
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const one = _mm_set1_epi16(1);
+    __m128i const opaque = _mm_set1_epi32(static_cast<int>(0xff000000u));
+    __m128i const color_alpha = _mm_set1_epi16(
+      static_cast<short>(color >> 24u));
+    __m128i const src = _mm_unpacklo_epi8(
+      _mm_set1_epi32(static_cast<int>(color)), zero);
+
+    for(; 0u < count; count -= 4u)
+    {
+      Unt_32_ cov_4;
+      ::std::memcpy(&cov_4, coverage, sizeof(cov_4));
+
+      if(0u != cov_4)
+      {
+        __m128i const d = _mm_loadu_si128(reinterpret_cast<__m128i*>(dst));
+        __m128i cov = _mm_unpacklo_epi8(
+          _mm_cvtsi32_si128(static_cast<int>(cov_4)), zero);
+
+        // alpha = (cov * color_alpha) / 255
+        __m128i a = _mm_mullo_epi16(cov, color_alpha);
+
+        // Pixels with a zero product are left untouched.
+        __m128i const keep = _mm_cmpeq_epi32(_mm_unpacklo_epi16(a, a), zero);
+
+        a = div_255_sse2_(a, one);
+
+        // Broadcast the alpha of each pixel to its four channels.
+        a = _mm_unpacklo_epi16(a, a);
+        __m128i const a_lo = _mm_unpacklo_epi32(a, a);
+        __m128i const a_hi = _mm_unpackhi_epi32(a, a);
+
+        __m128i const d_lo = _mm_unpacklo_epi8(d, zero);
+        __m128i const d_hi = _mm_unpackhi_epi8(d, zero);
+        __m128i const r_lo = blend_sse2_(src, d_lo, a_lo, one);
+        __m128i const r_hi = blend_sse2_(src, d_hi, a_hi, one);
+        __m128i r = _mm_or_si128(_mm_packus_epi16(r_lo, r_hi), opaque);
+
+        r = _mm_or_si128(_mm_and_si128(keep, d), _mm_andnot_si128(keep, r));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), r);
+      }
+
+      dst += 4u;
+      coverage += 4u;
+    }
+  }
+
+  // Same as the SSE2 kernel, with the per-pixel alpha spread to the
+  // channels by one byte shuffle per half instead of three unpacks.
+  VGXX_SIMD_TARGET("ssse3")
+  static void blend_span_ssse3_(
+    Unt_32_* dst,
+    Unt_8_ const* coverage,
+    Size count,
+    Unt_32_ const color) noexcept
+  {
+    assert(0u == count % 4u);
+
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const one = _mm_set1_epi16(1);
+    __m128i const opaque = _mm_set1_epi32(static_cast<int>(0xff000000u));
+    __m128i const color_alpha = _mm_set1_epi16(
+      static_cast<short>(color >> 24u));
+    __m128i const src = _mm_unpacklo_epi8(
+      _mm_set1_epi32(static_cast<int>(color)), zero);
+    __m128i const spread_lo = _mm_setr_epi8(
+      0, 1, 0, 1, 0, 1, 0, 1, 2, 3, 2, 3, 2, 3, 2, 3);
+    __m128i const spread_hi = _mm_setr_epi8(
+      4, 5, 4, 5, 4, 5, 4, 5, 6, 7, 6, 7, 6, 7, 6, 7);
+
+    for(; 0u < count; count -= 4u)
+    {
+      Unt_32_ cov_4;
+      ::std::memcpy(&cov_4, coverage, sizeof(cov_4));
+
+      if(0u != cov_4)
+      {
+        __m128i const d = _mm_loadu_si128(reinterpret_cast<__m128i*>(dst));
+        __m128i cov = _mm_unpacklo_epi8(
+          _mm_cvtsi32_si128(static_cast<int>(cov_4)), zero);
+
+        __m128i a = _mm_mullo_epi16(cov, color_alpha);
+        __m128i const keep = _mm_cmpeq_epi32(_mm_unpacklo_epi16(a, a), zero);
+        a = div_255_sse2_(a, one);
+
+        __m128i const a_lo = _mm_shuffle_epi8(a, spread_lo);
+        __m128i const a_hi = _mm_shuffle_epi8(a, spread_hi);
+
+        __m128i const d_lo = _mm_unpacklo_epi8(d, zero);
+        __m128i const d_hi = _mm_unpackhi_epi8(d, zero);
+        __m128i const r_lo = blend_sse2_(src, d_lo, a_lo, one);
+        __m128i const r_hi = blend_sse2_(src, d_hi, a_hi, one);
+        __m128i r = _mm_or_si128(_mm_packus_epi16(r_lo, r_hi), opaque);
+
+        r = _mm_or_si128(_mm_and_si128(keep, d), _mm_andnot_si128(keep, r));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), r);
+      }
+
+      dst += 4u;
+      coverage += 4u;
+    }
+  }
+
+  VGXX_SIMD_TARGET("avx2")
+  static void blend_span_avx2_(
+    Unt_32_* dst,
+    Unt_8_ const* coverage,
+    Size count,
+    Unt_32_ const color) noexcept
+  {
+    assert(0u == count % 8u);
+
+    __m256i const zero = _mm256_setzero_si256();
+    __m256i const one = _mm256_set1_epi16(1);
+    __m256i const opaque = _mm256_set1_epi32(static_cast<int>(0xff000000u));
+    __m128i const color_alpha = _mm_set1_epi16(
+      static_cast<short>(color >> 24u));
+    __m256i const src = _mm256_unpacklo_epi8(
+      _mm256_set1_epi32(static_cast<int>(color)), zero);
+
+    for(; 0u < count; count -= 8u)
+    {
+      Unt_64_ cov_8;
+      ::std::memcpy(&cov_8, coverage, sizeof(cov_8));
+
+      if(0u != cov_8)
+      {
+        __m256i const d = _mm256_loadu_si256(reinterpret_cast<__m256i*>(dst));
+        __m128i const cov = _mm_cvtepu8_epi16(
+          _mm_loadl_epi64(reinterpret_cast<__m128i const*>(coverage)));
+
+        // Alpha of pixels 0 to 3 in the low lane, 4 to 7 in the high one.
+        __m256i a = _mm256_cvtepu16_epi32(_mm_mullo_epi16(cov, color_alpha));
+        __m256i const keep = _mm256_cmpeq_epi32(a, zero);
+        a = _mm256_srli_epi16(
+          _mm256_add_epi16(
+            _mm256_add_epi16(a, one), _mm256_srli_epi16(a, 8)), 8);
+        a = _mm256_or_si256(a, _mm256_slli_epi32(a, 16));
+        __m256i const a_lo = _mm256_unpacklo_epi32(a, a);
+        __m256i const a_hi = _mm256_unpackhi_epi32(a, a);
+
+        __m256i const d_lo = _mm256_unpacklo_epi8(d, zero);
+        __m256i const d_hi = _mm256_unpackhi_epi8(d, zero);
+        __m256i const r_lo = blend_avx2_(src, d_lo, a_lo, one);
+        __m256i const r_hi = blend_avx2_(src, d_hi, a_hi, one);
+        __m256i r = _mm256_or_si256(_mm256_packus_epi16(r_lo, r_hi), opaque);
+
+        r = _mm256_blendv_epi8(r, d, keep);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), r);
+      }
+
+      dst += 8u;
+      coverage += 8u;
+    }
+  }
+
+  // Like blend_span_sse2_() with the color alpha taken per pixel.
+  template<bool coverage_span>
+  VGXX_SIMD_TARGET("sse2")
+  static void blend_colors_sse2_(
+    Unt_32_* dst,
+    Unt_32_ const* colors,
+    Unt_8_ const* coverage,
+    Unt_32_ const solid_coverage,
+    Size count) noexcept
+  {
+    assert(0u == count % 4u);
+
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const one = _mm_set1_epi16(1);
+    __m128i const opaque = _mm_set1_epi32(static_cast<int>(0xff000000u));
+    __m128i cov = _mm_set1_epi32(static_cast<int>(solid_coverage));
+
+    for(; 0u < count; count -= 4u)
+    {
+      if constexpr(coverage_span)
+      {
+        Unt_32_ cov_4;
+        ::std::memcpy(&cov_4, coverage, sizeof(cov_4));
+        coverage += 4u;
+        if(0u == cov_4)
+        {
+          dst += 4u;
+          colors += 4u;
+          continue;
+        }
+
+        cov = _mm_unpacklo_epi16(
+          _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(cov_4)), zero),
+          zero);
+      }
+
+      __m128i const src =
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(colors));
+      __m128i const d = _mm_loadu_si128(reinterpret_cast<__m128i*>(dst));
+
+      // alpha = (cov * color_alpha) / 255 in the low half of each pixel.
+      __m128i a = _mm_mullo_epi16(cov, _mm_srli_epi32(src, 24));
+      __m128i const keep = _mm_cmpeq_epi32(a, zero);
+      a = div_255_sse2_(a, one);
+
+      // Broadcast the alpha of each pixel to its four channels.
+      a = _mm_shufflehi_epi16(
+        _mm_shufflelo_epi16(a, _MM_SHUFFLE(2, 2, 0, 0)),
+        _MM_SHUFFLE(2, 2, 0, 0));
+      __m128i const a_lo = _mm_unpacklo_epi32(a, a);
+      __m128i const a_hi = _mm_unpackhi_epi32(a, a);
+
+      __m128i const r_lo = blend_sse2_(
+        _mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(d, zero), a_lo, one);
+      __m128i const r_hi = blend_sse2_(
+        _mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(d, zero), a_hi, one);
+      __m128i r = _mm_or_si128(_mm_packus_epi16(r_lo, r_hi), opaque);
+
+      r = _mm_or_si128(_mm_and_si128(keep, d), _mm_andnot_si128(keep, r));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), r);
+
+      dst += 4u;
+      colors += 4u;
+    }
+  }
+
+  VGXX_SIMD_TARGET("sse2")
+  static void blend_solid_sse2_(
+    Unt_32_* dst,
+    Int_32_ const alpha,
+    Size count,
+    Unt_32_ const color) noexcept
+  {
+    assert(0u == count % 4u);
+
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const one = _mm_set1_epi16(1);
+    __m128i const opaque = _mm_set1_epi32(static_cast<int>(0xff000000u));
+    __m128i const a = _mm_set1_epi16(static_cast<short>(alpha));
+    __m128i const src = _mm_unpacklo_epi8(
+      _mm_set1_epi32(static_cast<int>(color)), zero);
+
+    for(; 0u < count; count -= 4u)
+    {
+      __m128i const d = _mm_loadu_si128(reinterpret_cast<__m128i*>(dst));
+      __m128i const r_lo = blend_sse2_(src, _mm_unpacklo_epi8(d, zero), a, one);
+      __m128i const r_hi = blend_sse2_(src, _mm_unpackhi_epi8(d, zero), a, one);
+      _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(dst),
+        _mm_or_si128(_mm_packus_epi16(r_lo, r_hi), opaque));
+      dst += 4u;
+    }
+  }
+
+  VGXX_SIMD_TARGET("avx2")
+  static void blend_solid_avx2_(
+    Unt_32_* dst,
+    Int_32_ const alpha,
+    Size count,
+    Unt_32_ const color) noexcept
+  {
+    assert(0u == count % 8u);
+
+    __m256i const zero = _mm256_setzero_si256();
+    __m256i const one = _mm256_set1_epi16(1);
+    __m256i const opaque = _mm256_set1_epi32(static_cast<int>(0xff000000u));
+    __m256i const a = _mm256_set1_epi16(static_cast<short>(alpha));
+    __m256i const src = _mm256_unpacklo_epi8(
+      _mm256_set1_epi32(static_cast<int>(color)), zero);
+
+    for(; 0u < count; count -= 8u)
+    {
+      __m256i const d = _mm256_loadu_si256(reinterpret_cast<__m256i*>(dst));
+      __m256i const r_lo =
+        blend_avx2_(src, _mm256_unpacklo_epi8(d, zero), a, one);
+      __m256i const r_hi =
+        blend_avx2_(src, _mm256_unpackhi_epi8(d, zero), a, one);
+      _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(dst),
+        _mm256_or_si256(_mm256_packus_epi16(r_lo, r_hi), opaque));
+      dst += 8u;
+    }
+  }
+
+  // Aligns dst with scalar stores, then writes 64 bytes per iteration.
+  VGXX_SIMD_TARGET("sse2")
+  static void fill_sse2_(
+    Unt_32_* dst,
+    Size count,
+    Unt_32_ const color,
+    bool const stream) noexcept
+  {
+    for(; 0u != (reinterpret_cast<::std::uintptr_t>(dst) & 15u); --count)
+    {
+      *dst++ = color;
+    }
+
+    __m128i const c = _mm_set1_epi32(static_cast<int>(color));
+    auto* v = reinterpret_cast<__m128i*>(dst);
+    Size block_count = count / 16u;
+    if(stream)
+    {
+      for(; 0u < block_count; --block_count, v += 4)
+      {
+        _mm_stream_si128(v, c);
+        _mm_stream_si128(v + 1, c);
+        _mm_stream_si128(v + 2, c);
+        _mm_stream_si128(v + 3, c);
+      }
+      _mm_sfence();
+    }
+    else
+    {
+      for(; 0u < block_count; --block_count, v += 4)
+      {
+        _mm_store_si128(v, c);
+        _mm_store_si128(v + 1, c);
+        _mm_store_si128(v + 2, c);
+        _mm_store_si128(v + 3, c);
+      }
+    }
+
+    for(count &= 15u; 4u <= count; count -= 4u)
+    {
+      _mm_store_si128(v++, c);
+    }
+
+    for(dst = reinterpret_cast<Unt_32_*>(v); 0u < count; --count)
+    {
+      *dst++ = color;
+    }
+  }
+
+  // Aligns dst with scalar stores, then writes 128 bytes per iteration.
+  VGXX_SIMD_TARGET("avx2")
+  static void fill_avx2_(
+    Unt_32_* dst,
+    Size count,
+    Unt_32_ const color,
+    bool const stream) noexcept
+  {
+    for(; 0u != (reinterpret_cast<::std::uintptr_t>(dst) & 31u); --count)
+    {
+      *dst++ = color;
+    }
+
+    __m256i const c = _mm256_set1_epi32(static_cast<int>(color));
+    auto* v = reinterpret_cast<__m256i*>(dst);
+    Size block_count = count / 32u;
+    if(stream)
+    {
+      for(; 0u < block_count; --block_count, v += 4)
+      {
+        _mm256_stream_si256(v, c);
+        _mm256_stream_si256(v + 1, c);
+        _mm256_stream_si256(v + 2, c);
+        _mm256_stream_si256(v + 3, c);
+      }
+      _mm_sfence();
+    }
+    else
+    {
+      for(; 0u < block_count; --block_count, v += 4)
+      {
+        _mm256_store_si256(v, c);
+        _mm256_store_si256(v + 1, c);
+        _mm256_store_si256(v + 2, c);
+        _mm256_store_si256(v + 3, c);
+      }
+    }
+
+    for(count &= 31u; 8u <= count; count -= 8u)
+    {
+      _mm256_store_si256(v++, c);
+    }
+
+    for(dst = reinterpret_cast<Unt_32_*>(v); 0u < count; --count)
+    {
+      *dst++ = color;
+    }
+  }
+
+  // val / 255 rounded as in the scalar code.
+  VGXX_SIMD_TARGET("sse2")
+  [[nodiscard]] static __m128i div_255_sse2_(
+    __m128i const val,
+    __m128i const one) noexcept
+  {
+    return _mm_srli_epi16(
+      _mm_add_epi16(_mm_add_epi16(val, one), _mm_srli_epi16(val, 8)), 8);
+  }
+
+  VGXX_SIMD_TARGET("sse2")
+  [[nodiscard]] static __m128i blend_sse2_(
+    __m128i const src,
+    __m128i const dst,
+    __m128i const alpha,
+    __m128i const one) noexcept
+  {
+    // val = dst * 255 + alpha * (src - dst)
+    __m128i val = _mm_sub_epi16(_mm_slli_epi16(dst, 8), dst);
+    val = _mm_add_epi16(
+      val, _mm_mullo_epi16(alpha, _mm_sub_epi16(src, dst)));
+    return div_255_sse2_(val, one);
+  }
+
+  VGXX_SIMD_TARGET("avx2")
+  [[nodiscard]] static __m256i blend_avx2_(
+    __m256i const src,
+    __m256i const dst,
+    __m256i const alpha,
+    __m256i const one) noexcept
+  {
+    __m256i val = _mm256_sub_epi16(_mm256_slli_epi16(dst, 8), dst);
+    val = _mm256_add_epi16(
+      val, _mm256_mullo_epi16(alpha, _mm256_sub_epi16(src, dst)));
+    return _mm256_srli_epi16(
+      _mm256_add_epi16(_mm256_add_epi16(val, one), _mm256_srli_epi16(val, 8)),
+      8);
+  }
+#endif
+};
+
+} // namespace vgxx
+
+#endif // VGXX_BLEND8888_HH
@@ -0,0 +1,304 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_BLENDA8_HH
+#define VGXX_BLENDA8_HH
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <vgxx/simd.hh>
+
+namespace vgxx
+{
+
+// How coverage is combined with the value already in an 8-bit mask.
+enum class Mask_mode
+{
+  // Coverage replaces the mask value.
+  replace = 0,
+
+  // m + c - m * c: the mask grows by the coverage.
+  union_ = 1,
+
+  // m * c: the mask shrinks to the coverage. Only for the kernels and
+  // Clipped_blender; Mask_blender_a8 does not take it.
+  intersect = 2
+};
+
+// Span kernels for 8-bit alpha masks, scalar and SSE2, 16 pixels per
+// iteration. Coverage 0 leaves replace and union untouched. Products are
+// divided by 255 with the same rounding as the color kernels.
+class Blend_a8
+{
+  using Unt_8_ = ::std::uint8_t;
+  using Unt_32_ = ::std::uint32_t;
+
+public:
+  using Size = ::std::size_t;
+
+  [[nodiscard]] static Unt_8_ combine(
+    Unt_32_ const mask,
+    Unt_32_ const coverage,
+    Mask_mode const mode) noexcept
+  {
+    switch(mode)
+    {
+    case Mask_mode::replace:
+      return static_cast<Unt_8_>(0u < coverage ? coverage : mask);
+    case Mask_mode::union_:
+      return static_cast<Unt_8_>(mask + coverage - mul_(mask, coverage));
+    case Mask_mode::intersect:
+      return static_cast<Unt_8_>(mul_(mask, coverage));
+    default:
+      assert(false);
+      return static_cast<Unt_8_>(mask);
+    }
+  }
+
+  // Combines count coverage values into the mask at dst.
+  static void blend_span(
+    Unt_8_* const dst,
+    Unt_8_ const* const coverage,
+    Size const count,
+    Mask_mode const mode,
+    Simd_level const level = Simd::level()) noexcept
+  {
+    with_mode_(mode, dst, dst, coverage, 0u, count, level);
+  }
+
+  // Combines the same coverage into count mask values at dst.
+  static void blend_solid(
+    Unt_8_* const dst,
+    Unt_32_ const coverage,
+    Size const count,
+    Mask_mode const mode,
+    Simd_level const level = Simd::level()) noexcept
+  {
+    with_mode_(mode, dst, dst, nullptr, coverage, count, level);
+  }
+
+  // out = a * b / 255. out may be a or b.
+  static void multiply(
+    Unt_8_* const out,
+    Unt_8_ const* const a,
+    Unt_8_ const* const b,
+    Size const count,
+    Simd_level const level = Simd::level()) noexcept
+  {
+    combine_<Mask_mode::intersect, false>(out, a, b, 0u, count, level);
+  }
+
+  // out = a * b / 255 for a constant b.
+  static void multiply(
+    Unt_8_* const out,
+    Unt_8_ const* const a,
+    Unt_32_ const b,
+    Size const count,
+    Simd_level const level = Simd::level()) noexcept
+  {
+    combine_<Mask_mode::intersect, true>(out, a, nullptr, b, count, level);
+  }
+
+private:
+  [[nodiscard]] static Unt_32_ mul_(
+    Unt_32_ const a,
+    Unt_32_ const b) noexcept
+  {
+    Unt_32_ const val = a * b;
+    return (val + 1u + (val >> 8u)) >> 8u; // val / 255
+  }
+
+  static void with_mode_(
+    Mask_mode const mode,
+    Unt_8_* const out,
+    Unt_8_ const* const mask,
+    Unt_8_ const* const coverage,
+    Unt_32_ const solid_coverage,
+    Size const count,
+    Simd_level const level) noexcept
+  {
+    bool const solid = nullptr == coverage;
+    switch(mode)
+    {
+    case Mask_mode::replace:
+      if(solid)
+      {
+        combine_<Mask_mode::replace, true>(
+          out, mask, coverage, solid_coverage, count, level);
+      }
+      else
+      {
+        combine_<Mask_mode::replace, false>(
+          out, mask, coverage, solid_coverage, count, level);
+      }
+      break;
+    case Mask_mode::union_:
+      if(solid)
+      {
+        combine_<Mask_mode::union_, true>(
+          out, mask, coverage, solid_coverage, count, level);
+      }
+      else
+      {
+        combine_<Mask_mode::union_, false>(
+          out, mask, coverage, solid_coverage, count, level);
+      }
+      break;
+    case Mask_mode::intersect:
+      if(solid)
+      {
+        combine_<Mask_mode::intersect, true>(
+          out, mask, coverage, solid_coverage, count, level);
+      }
+      else
+      {
+        combine_<Mask_mode::intersect, false>(
+          out, mask, coverage, solid_coverage, count, level);
+      }
+      break;
+    default:
+      assert(false);
+    }
+  }
+
+  template<Mask_mode mode, bool solid>
+  static void combine_(
+    Unt_8_* out,
+    Unt_8_ const* mask,
+    Unt_8_ const* coverage,
+    Unt_32_ const solid_coverage,
+    Size count,
+    Simd_level const level) noexcept
+  {
+#if defined(VGXX_SIMD_X86)
+    if(Simd_level::sse2 <= Simd::clamp(level))
+    {
+      Size const simd_count = count & ~Size{15u};
+      combine_sse2_<mode, solid>(
+        out, mask, coverage, solid_coverage, simd_count);
+      out += simd_count;
+      mask += simd_count;
+      if constexpr(!solid)
+      {
+        coverage += simd_count;
+      }
+      count -= simd_count;
+    }
+#else
+    static_cast<void>(level);
+#endif
+
+    for(; 0u < count; --count)
+    {
+      Unt_32_ c;
+      if constexpr(solid)
+      {
+        c = solid_coverage;
+      }
+      else
+      {
+        c = *coverage++;
+      }
+
+      *out++ = combine(*mask++, c, mode);
+    }
+  }
+
+#if defined(VGXX_SIMD_X86)
+  VGXX_SIMD_TARGET("sse2")
+  [[nodiscard]] static __m128i mul_sse2_(
+    __m128i const a,
+    __m128i const b) noexcept
+  {
+    __m128i const one = _mm_set1_epi16(1);
+    __m128i const val = _mm_mullo_epi16(a, b);
+    return _mm_srli_epi16(
+      _mm_add_epi16(_mm_add_epi16(val, one), _mm_srli_epi16(val, 8)), 8);
+  }
+
+  template<Mask_mode mode>
+  VGXX_SIMD_TARGET("sse2")
+  [[nodiscard]] static __m128i combine_sse2_(
+    __m128i const m,
+    __m128i const c) noexcept
+  {
+    __m128i const zero = _mm_setzero_si128();
+    if constexpr(Mask_mode::replace == mode)
+    {
+      __m128i const keep = _mm_cmpeq_epi8(c, zero);
+      return _mm_or_si128(_mm_and_si128(keep, m), _mm_andnot_si128(keep, c));
+    }
+    else
+    {
+      __m128i const m_lo = _mm_unpacklo_epi8(m, zero);
+      __m128i const m_hi = _mm_unpackhi_epi8(m, zero);
+      __m128i const c_lo = _mm_unpacklo_epi8(c, zero);
+      __m128i const c_hi = _mm_unpackhi_epi8(c, zero);
+      __m128i r_lo = mul_sse2_(m_lo, c_lo);
+      __m128i r_hi = mul_sse2_(m_hi, c_hi);
+      if constexpr(Mask_mode::union_ == mode)
+      {
+        r_lo = _mm_sub_epi16(_mm_add_epi16(m_lo, c_lo), r_lo);
+        r_hi = _mm_sub_epi16(_mm_add_epi16(m_hi, c_hi), r_hi);
+      }
+      return _mm_packus_epi16(r_lo, r_hi);
+    }
+  }
+
+  template<Mask_mode mode, bool solid>
+  VGXX_SIMD_TARGET("sse2")
+  static void combine_sse2_(
+    Unt_8_* out,
+    Unt_8_ const* mask,
+    Unt_8_ const* coverage,
+    Unt_32_ const solid_coverage,
+    Size count) noexcept
+  {
+    assert(0u == count % 16u);
+
+    __m128i c = _mm_set1_epi8(static_cast<char>(solid_coverage));
+    for(; 0u < count; count -= 16u)
+    {
+      if constexpr(!solid)
+      {
+        c = _mm_loadu_si128(reinterpret_cast<__m128i const*>(coverage));
+        coverage += 16u;
+      }
+
+      __m128i const m =
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(mask));
+      _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(out), combine_sse2_<mode>(m, c));
+      out += 16u;
+      mask += 16u;
+    }
+  }
+#endif
+};
+
+} // namespace vgxx
+
+#endif // VGXX_BLENDA8_HH
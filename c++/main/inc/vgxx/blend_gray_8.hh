@@ -0,0 +1,232 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_BLENDGRAY8_HH
+#define VGXX_BLENDGRAY8_HH
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <vgxx/simd.hh>
+#include <vgxx/util.hh>
+
+namespace vgxx
+{
+
+// Span kernels for 8-bit grayscale pixels. The SSE2 variant handles 16
+// pixels per iteration and is bit-exact with blend_pixel().
+class Blend_gray_8
+{
+  using Unt_8_ = ::std::uint8_t;
+  using Unt_32_ = ::std::uint32_t;
+  using Int_32_ = ::std::int32_t;
+
+public:
+  using Size = ::std::size_t;
+
+  // Rec. 601 luma of a color with red in the low byte, in 8.8 fixed point.
+  [[nodiscard]] static Unt_8_ luma(Unt_32_ const color) noexcept
+  {
+    Unt_32_ const r = color & 0xffu;
+    Unt_32_ const g = (color >> 8u) & 0xffu;
+    Unt_32_ const b = (color >> 16u) & 0xffu;
+    return static_cast<Unt_8_>((r * 77u + g * 150u + b * 29u + 128u) >> 8u);
+  }
+
+  static void blend_pixel(
+    Unt_8_& dst,
+    Unt_32_ const gray,
+    Unt_32_ alpha,
+    Unt_32_ const src_alpha) noexcept
+  {
+    alpha *= src_alpha;
+    if(0u < alpha)
+    {
+      alpha = (alpha + 1u + (alpha >> 8u)) >> 8u; // alpha /= 255
+      dst = static_cast<Unt_8_>(Util::blend(
+        static_cast<Int_32_>(gray),
+        static_cast<Int_32_>(dst),
+        static_cast<Int_32_>(alpha)));
+    }
+  }
+
+  // Blends gray with src_alpha over count pixels at dst with the coverage
+  // of each.
+  static void blend_span(
+    Unt_8_* dst,
+    Unt_8_ const* coverage,
+    Size count,
+    Unt_32_ const gray,
+    Unt_32_ const src_alpha,
+    Simd_level const level = Simd::level()) noexcept
+  {
+    if(0u == src_alpha)
+    {
+      return;
+    }
+
+#if defined(VGXX_SIMD_X86)
+    if(Simd_level::sse2 <= Simd::clamp(level))
+    {
+      Size const done = count & ~Size{15u};
+      blend_span_sse2_(dst, coverage, done, gray, src_alpha);
+      dst += done;
+      coverage += done;
+      count -= done;
+    }
+#else
+    static_cast<void>(level);
+#endif
+
+    for(; 0u < count; --count)
+    {
+      blend_pixel(*dst++, gray, *coverage++, src_alpha);
+    }
+  }
+
+  // Blends gray with src_alpha over count pixels at dst, all with the same
+  // coverage.
+  static void blend_solid(
+    Unt_8_* dst,
+    Unt_32_ const coverage,
+    Size count,
+    Unt_32_ const gray,
+    Unt_32_ const src_alpha,
+    Simd_level const level = Simd::level()) noexcept
+  {
+    Unt_32_ alpha = coverage * src_alpha;
+    if(0u == alpha || 0u == count)
+    {
+      return;
+    }
+
+    if(0xffu * 0xffu == alpha)
+    {
+      ::std::memset(dst, static_cast<int>(gray), count);
+      return;
+    }
+
+#if defined(VGXX_SIMD_X86)
+    if(Simd_level::sse2 <= Simd::clamp(level))
+    {
+      Size const done = count & ~Size{15u};
+      alpha = (alpha + 1u + (alpha >> 8u)) >> 8u; // alpha /= 255
+      blend_solid_sse2_(dst, done, gray, alpha);
+      dst += done;
+      count -= done;
+    }
+#else
+    static_cast<void>(level);
+#endif
+
+    for(; 0u < count; --count)
+    {
+      blend_pixel(*dst++, gray, coverage, src_alpha);
+    }
+  }
+
+private:
+#if defined(VGXX_SIMD_X86)
+  VGXX_SIMD_TARGET("sse2")
+  [[nodiscard]] static __m128i div_255_sse2_(__m128i const val) noexcept
+  {
+    __m128i const one = _mm_set1_epi16(1);
+    return _mm_srli_epi16(
+      _mm_add_epi16(_mm_add_epi16(val, one), _mm_srli_epi16(val, 8)), 8);
+  }
+
+  // dst * 255 + alpha * (src - dst), divided by 255.
+  VGXX_SIMD_TARGET("sse2")
+  [[nodiscard]] static __m128i blend_sse2_(
+    __m128i const src,
+    __m128i const dst,
+    __m128i const alpha) noexcept
+  {
+    __m128i val = _mm_sub_epi16(_mm_slli_epi16(dst, 8), dst);
+    val = _mm_add_epi16(
+      val, _mm_mullo_epi16(alpha, _mm_sub_epi16(src, dst)));
+    return div_255_sse2_(val);
+  }
+
+  VGXX_SIMD_TARGET("sse2")
+  static void blend_span_sse2_(
+    Unt_8_* const dst,
+    Unt_8_ const* const coverage,
+    Size const count,
+    Unt_32_ const gray,
+    Unt_32_ const src_alpha) noexcept
+  {
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const src = _mm_set1_epi16(static_cast<short>(gray));
+    __m128i const src_a = _mm_set1_epi16(static_cast<short>(src_alpha));
+
+    for(Size i = 0u; count > i; i += 16u)
+    {
+      __m128i const cov =
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(coverage + i));
+      if(0xffff == _mm_movemask_epi8(_mm_cmpeq_epi8(cov, zero)))
+      {
+        continue;
+      }
+
+      auto const d_ptr = reinterpret_cast<__m128i*>(dst + i);
+      __m128i const d = _mm_loadu_si128(d_ptr);
+      __m128i const a_lo =
+        div_255_sse2_(_mm_mullo_epi16(_mm_unpacklo_epi8(cov, zero), src_a));
+      __m128i const a_hi =
+        div_255_sse2_(_mm_mullo_epi16(_mm_unpackhi_epi8(cov, zero), src_a));
+      __m128i const lo = blend_sse2_(src, _mm_unpacklo_epi8(d, zero), a_lo);
+      __m128i const hi = blend_sse2_(src, _mm_unpackhi_epi8(d, zero), a_hi);
+      _mm_storeu_si128(d_ptr, _mm_packus_epi16(lo, hi));
+    }
+  }
+
+  VGXX_SIMD_TARGET("sse2")
+  static void blend_solid_sse2_(
+    Unt_8_* const dst,
+    Size const count,
+    Unt_32_ const gray,
+    Unt_32_ const alpha) noexcept
+  {
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const src = _mm_set1_epi16(static_cast<short>(gray));
+    __m128i const a = _mm_set1_epi16(static_cast<short>(alpha));
+
+    for(Size i = 0u; count > i; i += 16u)
+    {
+      auto const d_ptr = reinterpret_cast<__m128i*>(dst + i);
+      __m128i const d = _mm_loadu_si128(d_ptr);
+      __m128i const lo = blend_sse2_(src, _mm_unpacklo_epi8(d, zero), a);
+      __m128i const hi = blend_sse2_(src, _mm_unpackhi_epi8(d, zero), a);
+      _mm_storeu_si128(d_ptr, _mm_packus_epi16(lo, hi));
+    }
+  }
+#endif
+};
+
+} // namespace vgxx
+
+#endif // VGXX_BLENDGRAY8_HH
@@ -0,0 +1,187 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_BLENDLCD8888_HH
+#define VGXX_BLENDLCD8888_HH
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <vgxx/simd.hh>
+#include <vgxx/util.hh>
+
+namespace vgxx
+{
+
+// Span kernels that blend a color into 32-bit pixels with a separate
+// coverage for each of red, green and blue, as produced by LCD subpixel
+// rendering. Coverage comes as consecutive red, green, blue triples.
+//
+// Pixels and colors have red in the low byte and alpha in the top one.
+// Blended pixels become opaque, like with Blend_8888. The SSSE3 variant
+// handles 4 pixels per iteration and is bit-exact with blend_pixel().
+class Blend_lcd_8888
+{
+  using Unt_8_ = ::std::uint8_t;
+  using Unt_32_ = ::std::uint32_t;
+  using Int_32_ = ::std::int32_t;
+
+public:
+  using Size = ::std::size_t;
+
+  static void blend_pixel(
+    Unt_32_& dst,
+    Unt_32_ const color,
+    Unt_8_ const* const coverage) noexcept
+  {
+    if(0u == (coverage[0] | coverage[1] | coverage[2]))
+    {
+      return;
+    }
+
+    Unt_32_ const src_alpha = color >> 24u;
+    Unt_32_ result = 0xff000000u;
+    for(unsigned i = 0u; 3u > i; ++i)
+    {
+      Unt_32_ alpha = coverage[i] * src_alpha;
+      alpha = (alpha + 1u + (alpha >> 8u)) >> 8u; // alpha /= 255
+      unsigned const shift = i * 8u;
+      auto const channel = Util::blend(
+        static_cast<Int_32_>((color >> shift) & 0xffu),
+        static_cast<Int_32_>((dst >> shift) & 0xffu),
+        static_cast<Int_32_>(alpha));
+      result |= static_cast<Unt_32_>(channel) << shift;
+    }
+    dst = result;
+  }
+
+  // Blends color over count pixels at dst with the 3 * count coverage
+  // values at coverage.
+  static void blend_span(
+    Unt_32_* dst,
+    Unt_8_ const* coverage,
+    Size count,
+    Unt_32_ const color,
+    Simd_level const level = Simd::level()) noexcept
+  {
+    if(0u == color >> 24u)
+    {
+      return;
+    }
+
+#if defined(VGXX_SIMD_X86)
+    if(Simd_level::ssse3 <= Simd::clamp(level) && 6u <= count)
+    {
+      // Every iteration loads 16 coverage values and uses 12, so stop
+      // while 16 are left.
+      Size const done = (count - 2u) & ~Size{3u};
+      blend_span_ssse3_(dst, coverage, done, color);
+      dst += done;
+      coverage += done * 3u;
+      count -= done;
+    }
+#else
+    static_cast<void>(level);
+#endif
+
+    for(; 0u < count; --count)
+    {
+      blend_pixel(*dst++, color, coverage);
+      coverage += 3u;
+    }
+  }
+
+private:
+#if defined(VGXX_SIMD_X86)
+  VGXX_SIMD_TARGET("ssse3")
+  [[nodiscard]] static __m128i div_255_ssse3_(__m128i const val) noexcept
+  {
+    __m128i const one = _mm_set1_epi16(1);
+    return _mm_srli_epi16(
+      _mm_add_epi16(_mm_add_epi16(val, one), _mm_srli_epi16(val, 8)), 8);
+  }
+
+  // dst * 255 + alpha * (src - dst), divided by 255.
+  VGXX_SIMD_TARGET("ssse3")
+  [[nodiscard]] static __m128i blend_ssse3_(
+    __m128i const src,
+    __m128i const dst,
+    __m128i const alpha) noexcept
+  {
+    __m128i val = _mm_sub_epi16(_mm_slli_epi16(dst, 8), dst);
+    val = _mm_add_epi16(
+      val, _mm_mullo_epi16(alpha, _mm_sub_epi16(src, dst)));
+    return div_255_ssse3_(val);
+  }
+
+  VGXX_SIMD_TARGET("ssse3")
+  static void blend_span_ssse3_(
+    Unt_32_* const dst,
+    Unt_8_ const* const coverage,
+    Size const count,
+    Unt_32_ const color) noexcept
+  {
+    __m128i const zero = _mm_setzero_si128();
+    // Red, green, blue triples to pixels with a zero alpha byte.
+    __m128i const spread = _mm_setr_epi8(
+      0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    __m128i const src_a = _mm_set1_epi16(static_cast<short>(color >> 24u));
+    __m128i const src =
+      _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(color)), zero);
+    __m128i const opaque = _mm_set1_epi32(static_cast<int>(0xff000000u));
+
+    for(Size i = 0u; count > i; i += 4u)
+    {
+      __m128i const cov = _mm_shuffle_epi8(
+        _mm_loadu_si128(
+          reinterpret_cast<__m128i const*>(coverage + i * 3u)),
+        spread);
+      __m128i const keep = _mm_cmpeq_epi32(cov, zero);
+      if(0xffff == _mm_movemask_epi8(keep))
+      {
+        continue;
+      }
+
+      auto const d_ptr = reinterpret_cast<__m128i*>(dst + i);
+      __m128i const d = _mm_loadu_si128(d_ptr);
+      __m128i const a_lo =
+        div_255_ssse3_(_mm_mullo_epi16(_mm_unpacklo_epi8(cov, zero), src_a));
+      __m128i const a_hi =
+        div_255_ssse3_(_mm_mullo_epi16(_mm_unpackhi_epi8(cov, zero), src_a));
+      __m128i const lo = blend_ssse3_(src, _mm_unpacklo_epi8(d, zero), a_lo);
+      __m128i const hi = blend_ssse3_(src, _mm_unpackhi_epi8(d, zero), a_hi);
+      __m128i const result = _mm_or_si128(_mm_packus_epi16(lo, hi), opaque);
+      _mm_storeu_si128(
+        d_ptr,
+        _mm_or_si128(
+          _mm_and_si128(keep, d), _mm_andnot_si128(keep, result)));
+    }
+  }
+#endif
+};
+
+} // namespace vgxx
+
+#endif // VGXX_BLENDLCD8888_HH
@@ -0,0 +1,627 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_BLENDPREMUL8888_HH
+#define VGXX_BLENDPREMUL8888_HH
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include <vgxx/composite_op.hh>
+#include <vgxx/simd.hh>
+#include <vgxx/util.hh>
+
+namespace vgxx
+{
+
+// Span kernels for 32-bit premultiplied colors with alpha in the top byte,
+// which covers both RGBA and BGRA layouts. Unlike Blend_8888 they keep
+// the destination alpha, so they can render into transparent layers and
+// composite those layers with any Composite_op.
+//
+// Colors must be premultiplied: no channel may exceed the alpha. The SSE2
+// variants are bit-exact with blend_pixel() for such colors.
+class Blend_premul_8888
+{
+  using Unt_8_ = ::std::uint8_t;
+  using Unt_32_ = ::std::uint32_t;
+  using Int_32_ = ::std::int32_t;
+
+  template<Composite_op op>
+  using Op_ = ::std::integral_constant<Composite_op, op>;
+
+public:
+  using Size = ::std::size_t;
+
+  [[nodiscard]] static Unt_32_ premultiply(Unt_32_ const color) noexcept
+  {
+    Unt_32_ const alpha = color >> 24u;
+    Unt_32_ result = alpha << 24u;
+    for(Unt_32_ shift = 0u; 24u > shift; shift += 8u)
+    {
+      result |= div_255_(((color >> shift) & 0xffu) * alpha) << shift;
+    }
+
+    return result;
+  }
+
+  // Inverse of premultiply(), up to rounding. Fully transparent colors
+  // become transparent black.
+  [[nodiscard]] static Unt_32_ unpremultiply(Unt_32_ const color) noexcept
+  {
+    Unt_32_ const alpha = color >> 24u;
+    if(0u == alpha)
+    {
+      return 0u;
+    }
+
+    // n / alpha is (n * ceil(2^24 / alpha)) >> 24 for every n up to
+    // 255 * 255 + 127, so one division serves all three channels.
+    auto const reciprocal =
+      static_cast<::std::uint64_t>((0xffffffu + alpha) / alpha);
+    Unt_32_ result = alpha << 24u;
+    for(Unt_32_ shift = 0u; 24u > shift; shift += 8u)
+    {
+      auto c = static_cast<Unt_32_>(
+        ((((color >> shift) & 0xffu) * 0xffu + (alpha >> 1u)) *
+          reciprocal) >> 24u);
+      if(0xffu < c)
+      {
+        c = 0xffu;
+      }
+      result |= c << shift;
+    }
+
+    return result;
+  }
+
+  // Composites src onto dst with the operator, then mixes the result with
+  // dst by the coverage.
+  static void blend_pixel(
+    Unt_32_& dst,
+    Unt_32_ const src,
+    Unt_32_ const coverage,
+    Composite_op const op) noexcept
+  {
+    with_op_(op, [&](auto const op_tag)
+      {
+        blend_pixel_<decltype(op_tag)::value>(dst, src, coverage);
+      });
+  }
+
+  // Blends color over count pixels at dst with the coverage of each
+  // pixel.
+  static void blend_span(
+    Unt_32_* const dst,
+    Unt_8_ const* const coverage,
+    Size const count,
+    Unt_32_ const color,
+    Composite_op const op,
+    Simd_level const level = Simd::level()) noexcept
+  {
+    if(Composite_op::dst == op)
+    {
+      return;
+    }
+
+    with_op_(op, [&](auto const op_tag)
+      {
+        blend_span_<decltype(op_tag)::value>(
+          dst, coverage, count, color, level);
+      });
+  }
+
+  // Blends color over count pixels at dst, all with the same coverage.
+  static void blend_solid(
+    Unt_32_* const dst,
+    Unt_32_ const coverage,
+    Size const count,
+    Unt_32_ const color,
+    Composite_op const op,
+    Simd_level const level = Simd::level()) noexcept
+  {
+    if(0u == coverage || Composite_op::dst == op)
+    {
+      return;
+    }
+
+    with_op_(op, [&](auto const op_tag)
+      {
+        composite_<decltype(op_tag)::value, false>(
+          dst, &color, count, coverage, level);
+      });
+  }
+
+  // Composites count premultiplied pixels of src onto dst, scaled by the
+  // opacity. This is how a layer is put back onto the canvas.
+  static void composite(
+    Unt_32_* const dst,
+    Unt_32_ const* const src,
+    Size const count,
+    Composite_op const op,
+    Unt_32_ const opacity = 0xffu,
+    Simd_level const level = Simd::level()) noexcept
+  {
+    if(0u == opacity || Composite_op::dst == op)
+    {
+      return;
+    }
+
+    with_op_(op, [&](auto const op_tag)
+      {
+        composite_<decltype(op_tag)::value, true>(
+          dst, src, count, opacity, level);
+      });
+  }
+
+  // Same as above for a width by height rectangle.
+  static void composite_rect(
+    Unt_32_* dst,
+    Size const dst_bytes_per_row,
+    Unt_32_ const* src,
+    Size const src_bytes_per_row,
+    Size const width,
+    Size height,
+    Composite_op const op,
+    Unt_32_ const opacity = 0xffu,
+    Simd_level const level = Simd::level()) noexcept
+  {
+    for(; 0u < height; --height)
+    {
+      composite(dst, src, width, op, opacity, level);
+      dst = reinterpret_cast<Unt_32_*>(
+        reinterpret_cast<char*>(dst) + dst_bytes_per_row);
+      src = reinterpret_cast<Unt_32_ const*>(
+        reinterpret_cast<char const*>(src) + src_bytes_per_row);
+    }
+  }
+
+private:
+  // Porter-Duff factors.
+  enum class Factor_
+  {
+    zero,
+    one,
+    src_alpha,
+    inv_src_alpha,
+    dst_alpha,
+    inv_dst_alpha
+  };
+
+  template<Composite_op op>
+  [[nodiscard]] static constexpr Factor_ src_factor_() noexcept
+  {
+    switch(op)
+    {
+    case Composite_op::src:
+    case Composite_op::src_over:
+    case Composite_op::plus:
+      return Factor_::one;
+    case Composite_op::dst_over:
+    case Composite_op::src_out:
+    case Composite_op::dst_atop:
+    case Composite_op::xor_:
+      return Factor_::inv_dst_alpha;
+    case Composite_op::src_in:
+    case Composite_op::src_atop:
+      return Factor_::dst_alpha;
+    default:
+      return Factor_::zero;
+    }
+  }
+
+  template<Composite_op op>
+  [[nodiscard]] static constexpr Factor_ dst_factor_() noexcept
+  {
+    switch(op)
+    {
+    case Composite_op::dst:
+    case Composite_op::dst_over:
+    case Composite_op::plus:
+      return Factor_::one;
+    case Composite_op::src_over:
+    case Composite_op::dst_out:
+    case Composite_op::src_atop:
+    case Composite_op::xor_:
+      return Factor_::inv_src_alpha;
+    case Composite_op::dst_in:
+    case Composite_op::dst_atop:
+      return Factor_::src_alpha;
+    default:
+      return Factor_::zero;
+    }
+  }
+
+  template<class F>
+  static void with_op_(Composite_op const op, F&& f)
+  {
+    switch(op)
+    {
+    case Composite_op::clear:
+      f(Op_<Composite_op::clear>());
+      break;
+    case Composite_op::src:
+      f(Op_<Composite_op::src>());
+      break;
+    case Composite_op::dst:
+      f(Op_<Composite_op::dst>());
+      break;
+    case Composite_op::src_over:
+      f(Op_<Composite_op::src_over>());
+      break;
+    case Composite_op::dst_over:
+      f(Op_<Composite_op::dst_over>());
+      break;
+    case Composite_op::src_in:
+      f(Op_<Composite_op::src_in>());
+      break;
+    case Composite_op::dst_in:
+      f(Op_<Composite_op::dst_in>());
+      break;
+    case Composite_op::src_out:
+      f(Op_<Composite_op::src_out>());
+      break;
+    case Composite_op::dst_out:
+      f(Op_<Composite_op::dst_out>());
+      break;
+    case Composite_op::src_atop:
+      f(Op_<Composite_op::src_atop>());
+      break;
+    case Composite_op::dst_atop:
+      f(Op_<Composite_op::dst_atop>());
+      break;
+    case Composite_op::xor_:
+      f(Op_<Composite_op::xor_>());
+      break;
+    case Composite_op::plus:
+      f(Op_<Composite_op::plus>());
+      break;
+    default:
+      assert(false);
+    }
+  }
+
+  [[nodiscard]] static Unt_32_ div_255_(Unt_32_ const val) noexcept
+  {
+    return (val + 1u + (val >> 8u)) >> 8u;
+  }
+
+  [[nodiscard]] static Unt_32_ factor_value_(
+    Factor_ const factor,
+    Unt_32_ const src_alpha,
+    Unt_32_ const dst_alpha) noexcept
+  {
+    switch(factor)
+    {
+    case Factor_::one:
+      return 0xffu;
+    case Factor_::src_alpha:
+      return src_alpha;
+    case Factor_::inv_src_alpha:
+      return 0xffu - src_alpha;
+    case Factor_::dst_alpha:
+      return dst_alpha;
+    case Factor_::inv_dst_alpha:
+      return 0xffu - dst_alpha;
+    default:
+      return 0u;
+    }
+  }
+
+  template<Composite_op op>
+  static void blend_pixel_(
+    Unt_32_& dst,
+    Unt_32_ const src,
+    Unt_32_ const coverage) noexcept
+  {
+    Unt_32_ const src_factor =
+      factor_value_(src_factor_<op>(), src >> 24u, dst >> 24u);
+    Unt_32_ const dst_factor =
+      factor_value_(dst_factor_<op>(), src >> 24u, dst >> 24u);
+
+    Unt_32_ result = 0u;
+    for(Unt_32_ shift = 0u; 32u > shift; shift += 8u)
+    {
+      Unt_32_ const s = (src >> shift) & 0xffu;
+      Unt_32_ const d = (dst >> shift) & 0xffu;
+      Unt_32_ r;
+      if constexpr(Composite_op::plus == op)
+      {
+        r = s + d;
+        if(0xffu < r)
+        {
+          r = 0xffu;
+        }
+      }
+      else
+      {
+        r = div_255_(s * src_factor + d * dst_factor);
+      }
+
+      if(0xffu > coverage)
+      {
+        r = static_cast<Unt_32_>(Util::blend(
+          static_cast<Int_32_>(r),
+          static_cast<Int_32_>(d),
+          static_cast<Int_32_>(coverage)));
+      }
+
+      result |= r << shift;
+    }
+
+    dst = result;
+  }
+
+  template<Composite_op op>
+  static void blend_span_(
+    Unt_32_* dst,
+    Unt_8_ const* coverage,
+    Size count,
+    Unt_32_ const color,
+    Simd_level const level) noexcept
+  {
+#if defined(VGXX_SIMD_X86)
+    if(Simd_level::sse2 <= Simd::clamp(level))
+    {
+      Size const simd_count = count & ~Size{3u};
+      blend_span_sse2_<op>(dst, coverage, simd_count, color);
+      dst += simd_count;
+      coverage += simd_count;
+      count -= simd_count;
+    }
+#else
+    static_cast<void>(level);
+#endif
+
+    for(; 0u < count; --count)
+    {
+      if(0u < *coverage)
+      {
+        blend_pixel_<op>(*dst, color, *coverage);
+      }
+      ++dst;
+      ++coverage;
+    }
+  }
+
+  // With src_span, src holds count pixels; otherwise a single color.
+  template<Composite_op op, bool src_span>
+  static void composite_(
+    Unt_32_* dst,
+    Unt_32_ const* src,
+    Size count,
+    Unt_32_ const coverage,
+    Simd_level const level) noexcept
+  {
+#if defined(VGXX_SIMD_X86)
+    if(Simd_level::sse2 <= Simd::clamp(level))
+    {
+      Size const simd_count = count & ~Size{3u};
+      composite_sse2_<op, src_span>(dst, src, simd_count, coverage);
+      dst += simd_count;
+      if constexpr(src_span)
+      {
+        src += simd_count;
+      }
+      count -= simd_count;
+    }
+#else
+    static_cast<void>(level);
+#endif
+
+    for(; 0u < count; --count)
+    {
+      blend_pixel_<op>(*dst, *src, coverage);
+      ++dst;
+      if constexpr(src_span)
+      {
+        ++src;
+      }
+    }
+  }
+
+#if defined(VGXX_SIMD_X86)
+  // Works on 16-bit lanes like the Blend_8888 kernels. For premultiplied
+  // colors S * Fa + D * Fb stays below 65536.
+
+  VGXX_SIMD_TARGET("sse2")
+  [[nodiscard]] static __m128i div_255_sse2_(__m128i const val) noexcept
+  {
+    __m128i const one = _mm_set1_epi16(1);
+    return _mm_srli_epi16(
+      _mm_add_epi16(_mm_add_epi16(val, one), _mm_srli_epi16(val, 8)), 8);
+  }
+
+  // Spreads the alpha of the two pixels in 16-bit lanes to all of their
+  // channels.
+  VGXX_SIMD_TARGET("sse2")
+  [[nodiscard]] static __m128i alpha_sse2_(__m128i const color) noexcept
+  {
+    return _mm_shufflehi_epi16(
+      _mm_shufflelo_epi16(color, _MM_SHUFFLE(3, 3, 3, 3)),
+      _MM_SHUFFLE(3, 3, 3, 3));
+  }
+
+  // x * factor, or nothing for a zero factor.
+  template<Factor_ factor>
+  VGXX_SIMD_TARGET("sse2")
+  [[nodiscard]] static __m128i term_sse2_(
+    __m128i const x,
+    __m128i const src_alpha,
+    __m128i const dst_alpha) noexcept
+  {
+    __m128i const mask = _mm_set1_epi16(0xff);
+    if constexpr(Factor_::one == factor)
+    {
+      return _mm_sub_epi16(_mm_slli_epi16(x, 8), x);
+    }
+    else if constexpr(Factor_::src_alpha == factor)
+    {
+      return _mm_mullo_epi16(x, src_alpha);
+    }
+    else if constexpr(Factor_::inv_src_alpha == factor)
+    {
+      return _mm_mullo_epi16(x, _mm_xor_si128(src_alpha, mask));
+    }
+    else if constexpr(Factor_::dst_alpha == factor)
+    {
+      return _mm_mullo_epi16(x, dst_alpha);
+    }
+    else if constexpr(Factor_::inv_dst_alpha == factor)
+    {
+      return _mm_mullo_epi16(x, _mm_xor_si128(dst_alpha, mask));
+    }
+    else
+    {
+      return _mm_setzero_si128();
+    }
+  }
+
+  // Two pixels of src and dst in 16-bit lanes, with the coverage of each
+  // spread to its channels.
+  template<Composite_op op>
+  VGXX_SIMD_TARGET("sse2")
+  [[nodiscard]] static __m128i blend_2_sse2_(
+    __m128i const src,
+    __m128i const dst,
+    __m128i const coverage) noexcept
+  {
+    __m128i r;
+    if constexpr(Composite_op::plus == op)
+    {
+      r = _mm_min_epi16(_mm_add_epi16(src, dst), _mm_set1_epi16(0xff));
+    }
+    else
+    {
+      __m128i const src_alpha = alpha_sse2_(src);
+      __m128i const dst_alpha = alpha_sse2_(dst);
+      r = _mm_add_epi16(
+        term_sse2_<src_factor_<op>()>(src, src_alpha, dst_alpha),
+        term_sse2_<dst_factor_<op>()>(dst, src_alpha, dst_alpha));
+      r = div_255_sse2_(r);
+    }
+
+    // dst * 255 + coverage * (r - dst)
+    __m128i val = _mm_sub_epi16(_mm_slli_epi16(dst, 8), dst);
+    val = _mm_add_epi16(val, _mm_mullo_epi16(coverage, _mm_sub_epi16(r, dst)));
+    return div_255_sse2_(val);
+  }
+
+  template<Composite_op op>
+  VGXX_SIMD_TARGET("sse2")
+  [[nodiscard]] static __m128i blend_4_sse2_(
+    __m128i const src,
+    __m128i const dst,
+    __m128i const coverage_lo,
+    __m128i const coverage_hi) noexcept
+  {
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const r_lo = blend_2_sse2_<op>(
+      _mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(dst, zero),
+      coverage_lo);
+    __m128i const r_hi = blend_2_sse2_<op>(
+      _mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(dst, zero),
+      coverage_hi);
+    return _mm_packus_epi16(r_lo, r_hi);
+  }
+
+  template<Composite_op op>
+  VGXX_SIMD_TARGET("sse2")
+  static void blend_span_sse2_(
+    Unt_32_* dst,
+    Unt_8_ const* coverage,
+    Size count,
+    Unt_32_ const color) noexcept
+  {
+    assert(0u == count % 4u);
+
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const src = _mm_set1_epi32(static_cast<int>(color));
+
+    for(; 0u < count; count -= 4u)
+    {
+      Unt_32_ cov_4;
+      ::std::memcpy(&cov_4, coverage, sizeof(cov_4));
+
+      if(0u != cov_4)
+      {
+        __m128i cov = _mm_cvtsi32_si128(static_cast<int>(cov_4));
+        cov = _mm_unpacklo_epi8(cov, cov);
+        cov = _mm_unpacklo_epi16(cov, cov);
+
+        __m128i const d = _mm_loadu_si128(reinterpret_cast<__m128i*>(dst));
+        _mm_storeu_si128(
+          reinterpret_cast<__m128i*>(dst),
+          blend_4_sse2_<op>(
+            src, d,
+            _mm_unpacklo_epi8(cov, zero),
+            _mm_unpackhi_epi8(cov, zero)));
+      }
+
+      dst += 4u;
+      coverage += 4u;
+    }
+  }
+
+  template<Composite_op op, bool src_span>
+  VGXX_SIMD_TARGET("sse2")
+  static void composite_sse2_(
+    Unt_32_* dst,
+    Unt_32_ const* src,
+    Size count,
+    Unt_32_ const coverage) noexcept
+  {
+    assert(0u == count % 4u);
+    if(0u == count)
+    {
+      return;
+    }
+
+    __m128i const cov = _mm_set1_epi16(static_cast<short>(coverage));
+    __m128i s = _mm_set1_epi32(static_cast<int>(*src));
+
+    for(; 0u < count; count -= 4u)
+    {
+      if constexpr(src_span)
+      {
+        s = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src));
+        src += 4u;
+      }
+
+      __m128i const d = _mm_loadu_si128(reinterpret_cast<__m128i*>(dst));
+      _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(dst),
+        blend_4_sse2_<op>(s, d, cov, cov));
+      dst += 4u;
+    }
+  }
+#endif
+};
+
+} // namespace vgxx
+
+#endif // VGXX_BLENDPREMUL8888_HH
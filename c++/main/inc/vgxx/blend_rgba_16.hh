@@ -0,0 +1,324 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_BLENDRGBA16_HH
+#define VGXX_BLENDRGBA16_HH
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <vgxx/simd.hh>
+
+namespace vgxx
+{
+
+// Span kernels for 64-bit pixels with 16 bits per channel, red in the low
+// bits and alpha in the top ones. Colors have the same layout, straight
+// alpha. Pixels are premultiplied: blending moves every channel, alpha
+// included, towards the color with full alpha, which over an opaque pixel
+// is the same as blending straight colors.
+//
+// The 8-bit coverage of a span is first expanded to 16-bit blend factors,
+// so the per-pixel work is all 16-bit. The SSE2 variants handle 8
+// factors or 2 pixels per instruction and are bit-exact with
+// blend_pixel().
+class Blend_rgba_16
+{
+  using Unt_8_ = ::std::uint8_t;
+  using Unt_16_ = ::std::uint16_t;
+  using Unt_32_ = ::std::uint32_t;
+  using Unt_64_ = ::std::uint64_t;
+
+public:
+  using Size = ::std::size_t;
+
+  // Widens an 8-bit color with red in the low byte, such as those of
+  // Color_blender_rgba_8888.
+  [[nodiscard]] static Unt_64_ from_8888(Unt_32_ const color) noexcept
+  {
+    Unt_64_ result = 0u;
+    for(unsigned i = 0u; 4u > i; ++i)
+    {
+      result |= Unt_64_{((color >> (i * 8u)) & 0xffu) * 0x101u} << (i * 16u);
+    }
+    return result;
+  }
+
+  // Blend factor of a pixel with the given 8-bit coverage and 16-bit
+  // source alpha.
+  [[nodiscard]] static Unt_32_ factor(
+    Unt_32_ const coverage,
+    Unt_32_ const alpha) noexcept
+  {
+    return div_65535_(coverage * 0x101u * alpha);
+  }
+
+  // Moves dst towards color with full alpha by factor / 65535.
+  static void blend_pixel(
+    Unt_64_& dst,
+    Unt_64_ const color,
+    Unt_32_ const factor) noexcept
+  {
+    Unt_32_ const inv_factor = 0xffffu - factor;
+    Unt_64_ const src = color | Unt_64_{0xffffu} << 48u;
+    Unt_64_ result = 0u;
+    for(unsigned i = 0u; 64u > i; i += 16u)
+    {
+      auto const s = static_cast<Unt_32_>((src >> i) & 0xffffu);
+      auto const d = static_cast<Unt_32_>((dst >> i) & 0xffffu);
+      result |= Unt_64_{div_65535_(s * factor + d * inv_factor)} << i;
+    }
+    dst = result;
+  }
+
+  // Blends color over count pixels at dst with the coverage of each.
+  static void blend_span(
+    Unt_64_* dst,
+    Unt_8_ const* coverage,
+    Size count,
+    Unt_64_ const color,
+    Simd_level const level = Simd::level()) noexcept
+  {
+    auto const alpha = static_cast<Unt_32_>(color >> 48u);
+    if(0u == alpha)
+    {
+      return;
+    }
+
+#if defined(VGXX_SIMD_X86)
+    if(Simd_level::sse2 <= Simd::clamp(level))
+    {
+      Unt_16_ factors[chunk_size_];
+      while(0u < count)
+      {
+        Size const n = chunk_size_ < count ? chunk_size_ : count;
+        expand_sse2_(factors, coverage, n, alpha);
+        blend_span_sse2_(dst, factors, n, color);
+        dst += n;
+        coverage += n;
+        count -= n;
+      }
+      return;
+    }
+#else
+    static_cast<void>(level);
+#endif
+
+    for(; 0u < count; --count, ++dst)
+    {
+      Unt_32_ const f = factor(*coverage++, alpha);
+      if(0u < f)
+      {
+        blend_pixel(*dst, color, f);
+      }
+    }
+  }
+
+  // Blends color over count pixels at dst, all with the same coverage.
+  static void blend_solid(
+    Unt_64_* dst,
+    Unt_32_ const coverage,
+    Size count,
+    Unt_64_ const color,
+    Simd_level const level = Simd::level()) noexcept
+  {
+    Unt_32_ const f = factor(coverage, static_cast<Unt_32_>(color >> 48u));
+    if(0u == f)
+    {
+      return;
+    }
+
+    if(0xffffu == f)
+    {
+      Unt_64_ const src = color | Unt_64_{0xffffu} << 48u;
+      for(; 0u < count; --count)
+      {
+        *dst++ = src;
+      }
+      return;
+    }
+
+#if defined(VGXX_SIMD_X86)
+    if(Simd_level::sse2 <= Simd::clamp(level))
+    {
+      Size const done = count & ~Size{1u};
+      blend_solid_sse2_(dst, f, done, color);
+      dst += done;
+      count -= done;
+    }
+#else
+    static_cast<void>(level);
+#endif
+
+    for(; 0u < count; --count)
+    {
+      blend_pixel(*dst++, color, f);
+    }
+  }
+
+private:
+  static Size constexpr chunk_size_ = 64u;
+
+  // Rounds val / 65535 for val up to 65535 * 65535.
+  [[nodiscard]] static Unt_32_ div_65535_(Unt_32_ val) noexcept
+  {
+    val += 0x8000u;
+    return (val + (val >> 16u)) >> 16u;
+  }
+
+#if defined(VGXX_SIMD_X86)
+  VGXX_SIMD_TARGET("sse2")
+  [[nodiscard]] static __m128i div_65535_sse2_(__m128i val) noexcept
+  {
+    val = _mm_add_epi32(val, _mm_set1_epi32(0x8000));
+    return _mm_srli_epi32(_mm_add_epi32(val, _mm_srli_epi32(val, 16)), 16);
+  }
+
+  // Packs unsigned 32-bit lanes below 65536 into 16-bit ones.
+  VGXX_SIMD_TARGET("sse2")
+  [[nodiscard]] static __m128i pack_32_sse2_(
+    __m128i const lo,
+    __m128i const hi) noexcept
+  {
+    return _mm_packs_epi32(
+      _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16),
+      _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16));
+  }
+
+  // a * b + c * d on unsigned 16-bit lanes, divided by 65535.
+  VGXX_SIMD_TARGET("sse2")
+  [[nodiscard]] static __m128i mul_add_sse2_(
+    __m128i const a,
+    __m128i const b,
+    __m128i const c,
+    __m128i const d) noexcept
+  {
+    __m128i const ab_lo = _mm_mullo_epi16(a, b);
+    __m128i const ab_hi = _mm_mulhi_epu16(a, b);
+    __m128i const cd_lo = _mm_mullo_epi16(c, d);
+    __m128i const cd_hi = _mm_mulhi_epu16(c, d);
+    __m128i const lo = _mm_add_epi32(
+      _mm_unpacklo_epi16(ab_lo, ab_hi), _mm_unpacklo_epi16(cd_lo, cd_hi));
+    __m128i const hi = _mm_add_epi32(
+      _mm_unpackhi_epi16(ab_lo, ab_hi), _mm_unpackhi_epi16(cd_lo, cd_hi));
+    return pack_32_sse2_(div_65535_sse2_(lo), div_65535_sse2_(hi));
+  }
+
+  // Blend factors of count pixels into factors, rounded up to a multiple
+  // of 8 entries.
+  VGXX_SIMD_TARGET("sse2")
+  static void expand_sse2_(
+    Unt_16_* const factors,
+    Unt_8_ const* const coverage,
+    Size const count,
+    Unt_32_ const alpha) noexcept
+  {
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const a = _mm_set1_epi16(static_cast<short>(alpha));
+    __m128i const scale = _mm_set1_epi16(0x101);
+    Size i = 0u;
+    for(; count >= i + 8u; i += 8u)
+    {
+      __m128i const cov = _mm_mullo_epi16(
+        _mm_unpacklo_epi8(
+          _mm_loadl_epi64(reinterpret_cast<__m128i const*>(coverage + i)),
+          zero),
+        scale);
+      _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(factors + i),
+        mul_add_sse2_(cov, a, zero, zero));
+    }
+
+    for(; count > i; ++i)
+    {
+      factors[i] = static_cast<Unt_16_>(factor(coverage[i], alpha));
+    }
+  }
+
+  // Blends 2 pixels with the factors in the low 2 lanes of f.
+  VGXX_SIMD_TARGET("sse2")
+  static void blend_2_sse2_(
+    Unt_64_* const dst,
+    __m128i f,
+    __m128i const src) noexcept
+  {
+    f = _mm_unpacklo_epi16(f, f);
+    f = _mm_unpacklo_epi32(f, f);
+    auto const d_ptr = reinterpret_cast<__m128i*>(dst);
+    __m128i const d = _mm_loadu_si128(d_ptr);
+    __m128i const inv_f = _mm_xor_si128(f, _mm_set1_epi16(-1));
+    _mm_storeu_si128(d_ptr, mul_add_sse2_(src, f, d, inv_f));
+  }
+
+  VGXX_SIMD_TARGET("sse2")
+  static void blend_span_sse2_(
+    Unt_64_* const dst,
+    Unt_16_ const* const factors,
+    Size const count,
+    Unt_64_ const color) noexcept
+  {
+    __m128i const src = _mm_set1_epi64x(
+      static_cast<long long>(color | Unt_64_{0xffffu} << 48u));
+    Size i = 0u;
+    for(; count >= i + 2u; i += 2u)
+    {
+      Unt_32_ f;
+      static_assert(sizeof(f) == 2u * sizeof(*factors));
+      ::std::memcpy(&f, factors + i, sizeof(f));
+      if(0u != f)
+      {
+        blend_2_sse2_(
+          dst + i, _mm_cvtsi32_si128(static_cast<int>(f)), src);
+      }
+    }
+
+    if(count > i && 0u < factors[i])
+    {
+      blend_pixel(dst[i], color, factors[i]);
+    }
+  }
+
+  VGXX_SIMD_TARGET("sse2")
+  static void blend_solid_sse2_(
+    Unt_64_* const dst,
+    Unt_32_ const factor,
+    Size const count,
+    Unt_64_ const color) noexcept
+  {
+    __m128i const src = _mm_set1_epi64x(
+      static_cast<long long>(color | Unt_64_{0xffffu} << 48u));
+    __m128i const f = _mm_set1_epi16(static_cast<short>(factor));
+    for(Size i = 0u; count > i; i += 2u)
+    {
+      blend_2_sse2_(dst + i, f, src);
+    }
+  }
+#endif
+};
+
+} // namespace vgxx
+
+#endif // VGXX_BLENDRGBA16_HH
@@ -0,0 +1,452 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_BLENDRGBAFLOAT_HH
+#define VGXX_BLENDRGBAFLOAT_HH
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <vgxx/simd.hh>
+
+namespace vgxx
+{
+
+// Pixel of 32-bit floats, for HDR rendering and multi-pass compositing.
+// Channels may exceed 1.
+struct Rgba_f32
+{
+  float r;
+  float g;
+  float b;
+  float a;
+};
+
+// Pixel of IEEE half precision floats, stored as their bits.
+struct Rgba_f16
+{
+  ::std::uint16_t r;
+  ::std::uint16_t g;
+  ::std::uint16_t b;
+  ::std::uint16_t a;
+};
+
+// Conversions between half and single precision, rounding to nearest even
+// like the F16C instructions.
+class Half_float
+{
+  using Unt_16_ = ::std::uint16_t;
+  using Unt_32_ = ::std::uint32_t;
+
+public:
+  [[nodiscard]] static float to_float(Unt_16_ const half) noexcept
+  {
+    Unt_32_ const sign = Unt_32_{half & 0x8000u} << 16u;
+    Unt_32_ exp = (half >> 10u) & 0x1fu;
+    Unt_32_ mantissa = half & 0x3ffu;
+    Unt_32_ bits;
+
+    if(0x1fu == exp)
+    {
+      // Infinity or NaN, quieted.
+      bits = sign | 0x7f800000u | (mantissa << 13u);
+      if(0u != mantissa)
+      {
+        bits |= 0x400000u;
+      }
+    }
+    else if(0u == exp)
+    {
+      if(0u == mantissa)
+      {
+        bits = sign;
+      }
+      else
+      {
+        // Subnormal, normalize it.
+        exp = 113u;
+        while(0u == (mantissa & 0x400u))
+        {
+          mantissa <<= 1u;
+          --exp;
+        }
+        bits = sign | (exp << 23u) | ((mantissa & 0x3ffu) << 13u);
+      }
+    }
+    else
+    {
+      bits = sign | ((exp + 112u) << 23u) | (mantissa << 13u);
+    }
+
+    float result;
+    ::std::memcpy(&result, &bits, sizeof(result));
+    return result;
+  }
+
+  [[nodiscard]] static Unt_16_ from_float(float const value) noexcept
+  {
+    Unt_32_ bits;
+    ::std::memcpy(&bits, &value, sizeof(bits));
+    auto const sign = static_cast<Unt_16_>((bits >> 16u) & 0x8000u);
+    bits &= 0x7fffffffu;
+
+    if(0x7f800000u <= bits)
+    {
+      // Infinity or NaN, quieted.
+      Unt_32_ const nan = 0x7f800000u < bits ? 0x200u | (bits >> 13u) : 0u;
+      return static_cast<Unt_16_>(sign | 0x7c00u | (nan & 0x3ffu));
+    }
+    if(0x47800000u <= bits)
+    {
+      return static_cast<Unt_16_>(sign | 0x7c00u);
+    }
+
+    Unt_32_ result;
+    Unt_32_ rest;
+    Unt_32_ half_way;
+    if(0x38800000u <= bits)
+    {
+      result = (bits - 0x38000000u) >> 13u;
+      rest = bits & 0x1fffu;
+      half_way = 0x1000u;
+    }
+    else if(0x33000000u <= bits)
+    {
+      // Subnormal half.
+      Unt_32_ const shift = 126u - (bits >> 23u);
+      Unt_32_ const mantissa = (bits & 0x7fffffu) | 0x800000u;
+      result = mantissa >> shift;
+      rest = mantissa & ((1u << shift) - 1u);
+      half_way = 1u << (shift - 1u);
+    }
+    else
+    {
+      return sign;
+    }
+
+    if(half_way < rest || (half_way == rest && 0u != (result & 1u)))
+    {
+      ++result;
+    }
+    return static_cast<Unt_16_>(sign | result);
+  }
+};
+
+// Span kernels for float pixels. Colors are straight Rgba_f32 values with
+// alpha from 0 to 1; pixels are premultiplied. Blending moves every
+// channel, alpha included, towards the color with full alpha, which over
+// an opaque pixel is the same as blending straight colors.
+//
+// The 8-bit coverage of a span is first converted to float blend factors,
+// so the per-pixel work is two multiplications and an addition per
+// channel. The SSE2 variant blends one pixel per instruction and,
+// for half floats, needs F16C; both are bit-exact with blend_pixel().
+class Blend_rgba_float
+{
+  using Unt_8_ = ::std::uint8_t;
+  using Unt_32_ = ::std::uint32_t;
+
+public:
+  using Size = ::std::size_t;
+
+  // Widens an 8-bit color with red in the low byte, such as those of
+  // Color_blender_rgba_8888.
+  [[nodiscard]] static Rgba_f32 from_8888(Unt_32_ const color) noexcept
+  {
+    float constexpr scale = 1.0f / 255.0f;
+    return Rgba_f32{
+      static_cast<float>(color & 0xffu) * scale,
+      static_cast<float>((color >> 8u) & 0xffu) * scale,
+      static_cast<float>((color >> 16u) & 0xffu) * scale,
+      static_cast<float>(color >> 24u) * scale};
+  }
+
+  static void blend_pixel(
+    Rgba_f32& dst,
+    Rgba_f32 const& color,
+    float const factor) noexcept
+  {
+    // Written so that full coverage of an opaque color gives the color.
+    float const inv_factor = 1.0f - factor;
+    dst.r = color.r * factor + dst.r * inv_factor;
+    dst.g = color.g * factor + dst.g * inv_factor;
+    dst.b = color.b * factor + dst.b * inv_factor;
+    dst.a = factor + dst.a * inv_factor;
+  }
+
+  static void blend_pixel(
+    Rgba_f16& dst,
+    Rgba_f32 const& color,
+    float const factor) noexcept
+  {
+    Rgba_f32 pixel = to_f32(dst);
+    blend_pixel(pixel, color, factor);
+    dst = to_f16(pixel);
+  }
+
+  // Blends color over count pixels at dst with the coverage of each.
+  template<class Pixel>
+  static void blend_span(
+    Pixel* dst,
+    Unt_8_ const* coverage,
+    Size count,
+    Rgba_f32 const& color,
+    Simd_level const level = Simd::level()) noexcept
+  {
+    if(!(0.0f < color.a))
+    {
+      return;
+    }
+
+    float const scale = color.a * (1.0f / 255.0f);
+#if defined(VGXX_SIMD_X86)
+    if(has_sse2_(dst, level))
+    {
+      float factors[chunk_size_];
+      while(0u < count)
+      {
+        Size const n = chunk_size_ < count ? chunk_size_ : count;
+        expand_sse2_(factors, coverage, n, scale);
+        blend_span_sse2_(dst, factors, n, color);
+        dst += n;
+        coverage += n;
+        count -= n;
+      }
+      return;
+    }
+#else
+    static_cast<void>(level);
+#endif
+
+    for(; 0u < count; --count, ++dst)
+    {
+      Unt_32_ const cov = *coverage++;
+      if(0u < cov)
+      {
+        blend_pixel(*dst, color, static_cast<float>(cov) * scale);
+      }
+    }
+  }
+
+  // Blends color over count pixels at dst, all with the same coverage.
+  template<class Pixel>
+  static void blend_solid(
+    Pixel* dst,
+    Unt_32_ const coverage,
+    Size count,
+    Rgba_f32 const& color,
+    Simd_level const level = Simd::level()) noexcept
+  {
+    if(0u == coverage || !(0.0f < color.a))
+    {
+      return;
+    }
+
+    float const factor =
+      static_cast<float>(coverage) * (color.a * (1.0f / 255.0f));
+#if defined(VGXX_SIMD_X86)
+    if(has_sse2_(dst, level))
+    {
+      blend_solid_sse2_(dst, factor, count, color);
+      return;
+    }
+#else
+    static_cast<void>(level);
+#endif
+
+    for(; 0u < count; --count)
+    {
+      blend_pixel(*dst++, color, factor);
+    }
+  }
+
+  [[nodiscard]] static Rgba_f32 to_f32(Rgba_f16 const& pixel) noexcept
+  {
+    return Rgba_f32{
+      Half_float::to_float(pixel.r),
+      Half_float::to_float(pixel.g),
+      Half_float::to_float(pixel.b),
+      Half_float::to_float(pixel.a)};
+  }
+
+  [[nodiscard]] static Rgba_f16 to_f16(Rgba_f32 const& pixel) noexcept
+  {
+    return Rgba_f16{
+      Half_float::from_float(pixel.r),
+      Half_float::from_float(pixel.g),
+      Half_float::from_float(pixel.b),
+      Half_float::from_float(pixel.a)};
+  }
+
+private:
+  static Size constexpr chunk_size_ = 64u;
+
+  static_assert(16u == sizeof(Rgba_f32));
+  static_assert(8u == sizeof(Rgba_f16));
+
+#if defined(VGXX_SIMD_X86)
+  [[nodiscard]] static bool has_sse2_(
+    Rgba_f32 const*,
+    Simd_level const level) noexcept
+  {
+    return Simd_level::sse2 <= Simd::clamp(level);
+  }
+
+  [[nodiscard]] static bool has_sse2_(
+    Rgba_f16 const*,
+    Simd_level const level) noexcept
+  {
+    return Simd_level::sse2 <= Simd::clamp(level) && Simd::has_f16c();
+  }
+
+  // Blend factors of count pixels, rounded up to a multiple of 4 entries.
+  VGXX_SIMD_TARGET("sse2")
+  static void expand_sse2_(
+    float* const factors,
+    Unt_8_ const* const coverage,
+    Size const count,
+    float const scale) noexcept
+  {
+    __m128i const zero = _mm_setzero_si128();
+    __m128 const s = _mm_set1_ps(scale);
+    Size i = 0u;
+    for(; count >= i + 4u; i += 4u)
+    {
+      Unt_32_ cov_4;
+      ::std::memcpy(&cov_4, coverage + i, sizeof(cov_4));
+      __m128i cov = _mm_cvtsi32_si128(static_cast<int>(cov_4));
+      cov = _mm_unpacklo_epi16(_mm_unpacklo_epi8(cov, zero), zero);
+      _mm_storeu_ps(factors + i, _mm_mul_ps(_mm_cvtepi32_ps(cov), s));
+    }
+
+    for(; count > i; ++i)
+    {
+      factors[i] = static_cast<float>(coverage[i]) * scale;
+    }
+  }
+
+  VGXX_SIMD_TARGET("sse2")
+  [[nodiscard]] static __m128 blend_sse2_(
+    __m128 const dst,
+    __m128 const src,
+    __m128 const factor) noexcept
+  {
+    __m128 const inv_factor = _mm_sub_ps(_mm_set1_ps(1.0f), factor);
+    return _mm_add_ps(_mm_mul_ps(src, factor), _mm_mul_ps(dst, inv_factor));
+  }
+
+  VGXX_SIMD_TARGET("sse2")
+  [[nodiscard]] static __m128 load_color_sse2_(Rgba_f32 const& color) noexcept
+  {
+    return _mm_set_ps(1.0f, color.b, color.g, color.r);
+  }
+
+  VGXX_SIMD_TARGET("sse2")
+  static void blend_span_sse2_(
+    Rgba_f32* const dst,
+    float const* const factors,
+    Size const count,
+    Rgba_f32 const& color) noexcept
+  {
+    __m128 const src = load_color_sse2_(color);
+    for(Size i = 0u; count > i; ++i)
+    {
+      if(0.0f < factors[i])
+      {
+        auto const d_ptr = reinterpret_cast<float*>(dst + i);
+        _mm_storeu_ps(
+          d_ptr,
+          blend_sse2_(_mm_loadu_ps(d_ptr), src, _mm_set1_ps(factors[i])));
+      }
+    }
+  }
+
+  VGXX_SIMD_TARGET("sse2")
+  static void blend_solid_sse2_(
+    Rgba_f32* const dst,
+    float const factor,
+    Size const count,
+    Rgba_f32 const& color) noexcept
+  {
+    __m128 const src = load_color_sse2_(color);
+    __m128 const f = _mm_set1_ps(factor);
+    for(Size i = 0u; count > i; ++i)
+    {
+      auto const d_ptr = reinterpret_cast<float*>(dst + i);
+      _mm_storeu_ps(d_ptr, blend_sse2_(_mm_loadu_ps(d_ptr), src, f));
+    }
+  }
+
+  VGXX_SIMD_TARGET("sse2,f16c")
+  static void blend_f16c_(
+    Rgba_f16* const dst,
+    __m128 const src,
+    __m128 const factor) noexcept
+  {
+    auto const d_ptr = reinterpret_cast<__m128i*>(dst);
+    __m128 const d = _mm_cvtph_ps(_mm_loadl_epi64(d_ptr));
+    _mm_storel_epi64(
+      d_ptr,
+      _mm_cvtps_ph(blend_sse2_(d, src, factor), _MM_FROUND_TO_NEAREST_INT));
+  }
+
+  VGXX_SIMD_TARGET("sse2,f16c")
+  static void blend_span_sse2_(
+    Rgba_f16* const dst,
+    float const* const factors,
+    Size const count,
+    Rgba_f32 const& color) noexcept
+  {
+    __m128 const src = load_color_sse2_(color);
+    for(Size i = 0u; count > i; ++i)
+    {
+      if(0.0f < factors[i])
+      {
+        blend_f16c_(dst + i, src, _mm_set1_ps(factors[i]));
+      }
+    }
+  }
+
+  VGXX_SIMD_TARGET("sse2,f16c")
+  static void blend_solid_sse2_(
+    Rgba_f16* const dst,
+    float const factor,
+    Size const count,
+    Rgba_f32 const& color) noexcept
+  {
+    __m128 const src = load_color_sse2_(color);
+    __m128 const f = _mm_set1_ps(factor);
+    for(Size i = 0u; count > i; ++i)
+    {
+      blend_f16c_(dst + i, src, f);
+    }
+  }
+#endif
+};
+
+} // namespace vgxx
+
+#endif // VGXX_BLENDRGBAFLOAT_HH
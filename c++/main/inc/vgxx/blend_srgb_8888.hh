@@ -0,0 +1,339 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_BLENDSRGB8888_HH
+#define VGXX_BLENDSRGB8888_HH
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <vgxx/blend_8888.hh>
+#include <vgxx/simd.hh>
+#include <vgxx/srgb.hh>
+
+namespace vgxx
+{
+
+// Span kernels that blend 8-bit sRGB pixels in linear light, so that
+// coverage maps to perceived weight and thin strokes keep their weight
+// whatever the colors. Channels go to 16-bit linear values and back
+// through the Srgb tables instead of per-pixel pow().
+//
+// Pixels and colors have red in the low byte and alpha in the top one;
+// alpha is blended as coverage, like Blend_8888 does. The AVX2 variant
+// handles 8 pixels per iteration with table gathers and is bit-exact
+// with blend_pixel().
+class Blend_srgb_8888
+{
+  using Unt_8_ = ::std::uint8_t;
+  using Unt_32_ = ::std::uint32_t;
+  using Tables_ = Srgb::Tables;
+
+public:
+  using Size = ::std::size_t;
+
+  static void blend_pixel(
+    Unt_32_& dst,
+    Unt_32_ const color,
+    Unt_32_ const coverage) noexcept
+  {
+    blend_pixel_(dst, color, coverage, Srgb::tables());
+  }
+
+  // Blends color over count pixels at dst with the coverage of each.
+  static void blend_span(
+    Unt_32_* dst,
+    Unt_8_ const* coverage,
+    Size count,
+    Unt_32_ const color,
+    Simd_level const level = Simd::level()) noexcept
+  {
+    if(0u == color >> 24u)
+    {
+      return;
+    }
+
+    Tables_ const& tables = Srgb::tables();
+#if defined(VGXX_SIMD_X86)
+    if(Simd_level::avx2 == Simd::clamp(level))
+    {
+      Size const done = count & ~Size{7u};
+      blend_span_avx2_(dst, coverage, done, color, tables);
+      dst += done;
+      coverage += done;
+      count -= done;
+    }
+#else
+    static_cast<void>(level);
+#endif
+
+    for(; 0u < count; --count)
+    {
+      blend_pixel_(*dst++, color, *coverage++, tables);
+    }
+  }
+
+  // Blends color over count pixels at dst, all with the same coverage.
+  static void blend_solid(
+    Unt_32_* dst,
+    Unt_32_ const coverage,
+    Size count,
+    Unt_32_ const color,
+    Simd_level const level = Simd::level()) noexcept
+  {
+    Unt_32_ const alpha = coverage * (color >> 24u);
+    if(0xffu * 0xffu == alpha)
+    {
+      Blend_8888::fill(dst, count, color, level);
+      return;
+    }
+
+    if(0u == (alpha + 1u + (alpha >> 8u)) >> 8u) // alpha / 255
+    {
+      return;
+    }
+
+    Tables_ const& tables = Srgb::tables();
+    if(solid_table_count_ <= count)
+    {
+      blend_solid_table_(dst, coverage, count, color, tables);
+      return;
+    }
+
+#if defined(VGXX_SIMD_X86)
+    if(Simd_level::avx2 == Simd::clamp(level))
+    {
+      Size const done = count & ~Size{7u};
+      blend_solid_avx2_(dst, coverage, done, color, tables);
+      dst += done;
+      count -= done;
+    }
+#else
+    static_cast<void>(level);
+#endif
+
+    for(; 0u < count; --count)
+    {
+      blend_pixel_(*dst++, color, coverage, tables);
+    }
+  }
+
+private:
+  // Solid runs at least this long blend through a table of all the
+  // results for their alpha.
+  static Size constexpr solid_table_count_ = 512u;
+
+  // Rounds val / 65535 for val up to 65535 * 65535.
+  [[nodiscard]] static Unt_32_ div_65535_(Unt_32_ val) noexcept
+  {
+    val += 0x8000u;
+    return (val + (val >> 16u)) >> 16u;
+  }
+
+  static void blend_pixel_(
+    Unt_32_& dst,
+    Unt_32_ const color,
+    Unt_32_ alpha,
+    Tables_ const& tables) noexcept
+  {
+    alpha *= color >> 24u;
+    alpha = (alpha + 1u + (alpha >> 8u)) >> 8u; // alpha /= 255
+    if(0u == alpha)
+    {
+      return;
+    }
+
+    Unt_32_ const weight = alpha * 0x101u;
+    Unt_32_ const inv_weight = 0xffffu - weight;
+    Unt_32_ result = 0xff000000u;
+    for(unsigned shift = 0u; 24u > shift; shift += 8u)
+    {
+      Unt_32_ const src = tables.to_linear[(color >> shift) & 0xffu];
+      Unt_32_ const d = tables.to_linear[(dst >> shift) & 0xffu];
+      Unt_32_ const linear = div_65535_(src * weight + d * inv_weight);
+      result |= Unt_32_{tables.from_linear[linear >> 4u]} << shift;
+    }
+    dst = result;
+  }
+
+  // With one alpha for the whole run, each channel of the result only
+  // depends on the same channel of the pixel.
+  static void blend_solid_table_(
+    Unt_32_* const dst,
+    Unt_32_ const coverage,
+    Size const count,
+    Unt_32_ const color,
+    Tables_ const& tables) noexcept
+  {
+    Unt_32_ table[3u][256u];
+    for(Unt_32_ i = 0u; 256u > i; ++i)
+    {
+      Unt_32_ pixel = i * 0x10101u;
+      blend_pixel_(pixel, color, coverage, tables);
+      table[0u][i] = pixel & 0xffu;
+      table[1u][i] = pixel & 0xff00u;
+      table[2u][i] = pixel & 0xff0000u;
+    }
+
+    // The alpha of the run is not 0, so every pixel gets the blended value.
+    for(Size i = 0u; count > i; ++i)
+    {
+      Unt_32_ const d = dst[i];
+      dst[i] = 0xff000000u |
+        table[0u][d & 0xffu] |
+        table[1u][(d >> 8u) & 0xffu] |
+        table[2u][(d >> 16u) & 0xffu];
+    }
+  }
+
+#if defined(VGXX_SIMD_X86)
+  // Blends one channel of 8 pixels in linear light and returns it back in
+  // sRGB, in place.
+  template<int shift>
+  VGXX_SIMD_TARGET("avx2")
+  [[nodiscard]] static __m256i blend_channel_avx2_(
+    __m256i const dst,
+    __m256i const src,
+    __m256i const weight,
+    __m256i const inv_weight,
+    Tables_ const& tables) noexcept
+  {
+    __m256i const mask_8 = _mm256_set1_epi32(0xff);
+    __m256i const index =
+      _mm256_and_si256(_mm256_srli_epi32(dst, shift), mask_8);
+    __m256i const d = _mm256_and_si256(
+      _mm256_i32gather_epi32(
+        reinterpret_cast<int const*>(tables.to_linear), index, 2),
+      _mm256_set1_epi32(0xffff));
+
+    __m256i val = _mm256_add_epi32(
+      _mm256_mullo_epi32(src, weight), _mm256_mullo_epi32(d, inv_weight));
+    val = _mm256_add_epi32(val, _mm256_set1_epi32(0x8000));
+    val = _mm256_srli_epi32(
+      _mm256_add_epi32(val, _mm256_srli_epi32(val, 16)), 16);
+
+    __m256i const result = _mm256_and_si256(
+      _mm256_i32gather_epi32(
+        reinterpret_cast<int const*>(tables.from_linear),
+        _mm256_srli_epi32(val, 4),
+        1),
+      mask_8);
+    return _mm256_slli_epi32(result, shift);
+  }
+
+  // Blends color into 8 pixels with the given 8-bit alphas.
+  VGXX_SIMD_TARGET("avx2")
+  static void blend_8_avx2_(
+    Unt_32_* const dst,
+    __m256i const alpha,
+    Unt_32_ const color,
+    Tables_ const& tables) noexcept
+  {
+    __m256i const keep = _mm256_cmpeq_epi32(alpha, _mm256_setzero_si256());
+    if(-1 == _mm256_movemask_epi8(keep))
+    {
+      return;
+    }
+
+    __m256i const weight = _mm256_mullo_epi32(alpha, _mm256_set1_epi32(0x101));
+    __m256i const inv_weight =
+      _mm256_sub_epi32(_mm256_set1_epi32(0xffff), weight);
+    auto const d_ptr = reinterpret_cast<__m256i*>(dst);
+    __m256i const d = _mm256_loadu_si256(d_ptr);
+
+    __m256i result = _mm256_set1_epi32(static_cast<int>(0xff000000u));
+    result = _mm256_or_si256(result, blend_channel_avx2_<0>(
+      d,
+      _mm256_set1_epi32(tables.to_linear[color & 0xffu]),
+      weight,
+      inv_weight,
+      tables));
+    result = _mm256_or_si256(result, blend_channel_avx2_<8>(
+      d,
+      _mm256_set1_epi32(tables.to_linear[(color >> 8u) & 0xffu]),
+      weight,
+      inv_weight,
+      tables));
+    result = _mm256_or_si256(result, blend_channel_avx2_<16>(
+      d,
+      _mm256_set1_epi32(tables.to_linear[(color >> 16u) & 0xffu]),
+      weight,
+      inv_weight,
+      tables));
+    _mm256_storeu_si256(d_ptr, _mm256_blendv_epi8(result, d, keep));
+  }
+
+  VGXX_SIMD_TARGET("avx2")
+  [[nodiscard]] static __m256i div_255_avx2_(__m256i const val) noexcept
+  {
+    __m256i const one = _mm256_set1_epi32(1);
+    return _mm256_srli_epi32(
+      _mm256_add_epi32(_mm256_add_epi32(val, one), _mm256_srli_epi32(val, 8)),
+      8);
+  }
+
+  VGXX_SIMD_TARGET("avx2")
+  static void blend_span_avx2_(
+    Unt_32_* const dst,
+    Unt_8_ const* const coverage,
+    Size const count,
+    Unt_32_ const color,
+    Tables_ const& tables) noexcept
+  {
+    __m256i const src_a = _mm256_set1_epi32(static_cast<int>(color >> 24u));
+    for(Size i = 0u; count > i; i += 8u)
+    {
+      __m256i const cov = _mm256_cvtepu8_epi32(
+        _mm_loadl_epi64(reinterpret_cast<__m128i const*>(coverage + i)));
+      blend_8_avx2_(
+        dst + i,
+        div_255_avx2_(_mm256_mullo_epi32(cov, src_a)),
+        color,
+        tables);
+    }
+  }
+
+  VGXX_SIMD_TARGET("avx2")
+  static void blend_solid_avx2_(
+    Unt_32_* const dst,
+    Unt_32_ coverage,
+    Size const count,
+    Unt_32_ const color,
+    Tables_ const& tables) noexcept
+  {
+    coverage *= color >> 24u;
+    coverage = (coverage + 1u + (coverage >> 8u)) >> 8u; // coverage /= 255
+    __m256i const alpha = _mm256_set1_epi32(static_cast<int>(coverage));
+    for(Size i = 0u; count > i; i += 8u)
+    {
+      blend_8_avx2_(dst + i, alpha, color, tables);
+    }
+  }
+#endif
+};
+
+} // namespace vgxx
+
+#endif // VGXX_BLENDSRGB8888_HH
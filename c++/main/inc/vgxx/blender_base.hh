@@ -32,6 +32,10 @@ namespace vgxx
 template<class C>
 struct Blender_base
 {
+private:
+  using Ptrdiff_ = ::std::ptrdiff_t;
+
+public:
   using Color = C;
   using Size = ::std::size_t;
 
@@ -41,7 +45,8 @@ struct Blender_base
     img_data_(img_data),
     row_(nullptr),
     pixel_(nullptr),
-    bytes_per_row_(bytes_per_row)
+    bytes_per_row_(bytes_per_row),
+    y_0_(0)
   {}
 
   [[nodiscard]] Color* pixel() const noexcept
@@ -49,6 +54,27 @@ struct Blender_base
     return pixel_;
   }
 
+  void set_image(Color* const img_data, Size const bytes_per_row) noexcept
+  {
+    set_image(img_data, bytes_per_row, 0);
+  }
+
+  // Makes the first row of the image row y_0 of the canvas, so set_y(y)
+  // selects image row y - y_0. Renderers that produce a band of a larger
+  // canvas use it to keep passing canvas coordinates, which blenders such
+  // as gradients depend on.
+  void set_image(
+    Color* const img_data,
+    Size const bytes_per_row,
+    Ptrdiff_ const y_0) noexcept
+  {
+    img_data_ = img_data;
+    row_ = nullptr;
+    pixel_ = nullptr;
+    bytes_per_row_ = bytes_per_row;
+    y_0_ = y_0;
+  }
+
   template<class X>
   void set_x(X const& x) noexcept
   {
@@ -59,7 +85,8 @@ struct Blender_base
   void set_y(Y const& y) noexcept
   {
     static_assert(1u == sizeof(char));
-    Size const row_offset = bytes_per_row_ * static_cast<Size>(y);
+    Size const row_offset =
+      bytes_per_row_ * static_cast<Size>(static_cast<Ptrdiff_>(y) - y_0_);
     row_ = reinterpret_cast<Color*>(
       reinterpret_cast<char*>(img_data_) + row_offset);
   }
@@ -81,6 +108,7 @@ private:
   Color* row_;
   Color* pixel_;
   Size bytes_per_row_;
+  Ptrdiff_ y_0_;
 };
 
 } // namespace vgxx
@@ -0,0 +1,317 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_CELLLIST_HH
+#define VGXX_CELLLIST_HH
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <vgxx/rasterizer.hh>
+#include <vgxx/util.hh>
+
+namespace vgxx
+{
+
+// Immutable cells of a rasterized outline, sorted by row and column with
+// duplicates merged. Replaying them into a cell processor gives the same
+// coverage as rasterizing the outline again, translated by whole pixels.
+struct Cell_list
+{
+  using Int_32 = ::std::int32_t;
+  using Size = ::std::size_t;
+
+  struct Cell
+  {
+    Int_32 x;
+    Int_32 y;
+    Int_32 cover;
+    Int_32 area;
+  };
+
+  Cell_list() noexcept :
+    x_min_(0),
+    y_min_(0),
+    x_max_(-1),
+    y_max_(-1)
+  {}
+
+  [[nodiscard]] bool empty() const noexcept
+  {
+    return cells_.empty();
+  }
+
+  [[nodiscard]] Size size() const noexcept
+  {
+    return cells_.size();
+  }
+
+  [[nodiscard]] Cell const* data() const noexcept
+  {
+    return cells_.data();
+  }
+
+  // Bounds of the pixels the cells can cover, valid if the list is not
+  // empty.
+  [[nodiscard]] Int_32 x_min() const noexcept
+  {
+    return x_min_;
+  }
+
+  [[nodiscard]] Int_32 y_min() const noexcept
+  {
+    return y_min_;
+  }
+
+  [[nodiscard]] Int_32 x_max() const noexcept
+  {
+    return x_max_;
+  }
+
+  [[nodiscard]] Int_32 y_max() const noexcept
+  {
+    return y_max_;
+  }
+
+  template<class Cell_processor>
+  void replay(
+    Cell_processor&& cell_proc,
+    Int_32 const dx,
+    Int_32 const dy) const
+  {
+    auto const* cell = cells_.data();
+    auto const* const cells_end = cell + cells_.size();
+
+    if(cells_end != cell)
+    {
+      Int_32 y = cell->y;
+      static_cast<Cell_processor&&>(cell_proc).set_y(y + dy);
+
+      for(; cells_end != cell; ++cell)
+      {
+        if(y != cell->y)
+        {
+          y = cell->y;
+          static_cast<Cell_processor&&>(cell_proc).set_y(y + dy);
+        }
+
+        static_cast<Cell_processor&&>(cell_proc).set_x(cell->x + dx);
+        static_cast<Cell_processor&&>(cell_proc).set_cell(
+          cell->cover, cell->area);
+      }
+    }
+  }
+
+private:
+  friend struct Cell_recorder;
+
+  template<class T>
+  using Vector_ = ::std::vector<T>;
+
+  explicit Cell_list(Vector_<Cell>&& cells) noexcept :
+    cells_(::std::move(cells)),
+    x_min_(0),
+    y_min_(0),
+    x_max_(-1),
+    y_max_(-1)
+  {
+    if(!cells_.empty())
+    {
+      y_min_ = cells_.front().y;
+      y_max_ = cells_.back().y;
+      x_min_ = cells_.front().x;
+      x_max_ = x_min_;
+
+      for(auto const& cell : cells_)
+      {
+        if(x_min_ > cell.x)
+        {
+          x_min_ = cell.x;
+        }
+        if(x_max_ < cell.x)
+        {
+          x_max_ = cell.x;
+        }
+      }
+    }
+  }
+
+  Vector_<Cell> cells_;
+  Int_32 x_min_;
+  Int_32 y_min_;
+  Int_32 x_max_;
+  Int_32 y_max_;
+};
+
+// Accepts an outline the way Renderer does, but instead of clipping cells
+// to a canvas and swiping them, keeps them for a Cell_list.
+struct Cell_recorder
+{
+  using Int_32 = ::std::int32_t;
+
+  Cell_recorder() noexcept :
+    cell_x_(0),
+    cell_y_(0),
+    x_0_(0.f),
+    y_0_(0.f),
+    x_(0.f),
+    y_(0.f)
+  {}
+
+  void move_to(float const x, float const y)
+  {
+    rasterizer_.move_to(*this, x, y);
+    x_0_ = x;
+    y_0_ = y;
+    x_ = x;
+    y_ = y;
+  }
+
+  void line_to(float const x, float const y)
+  {
+    rasterizer_.line_to(*this, x, y);
+    x_ = x;
+    y_ = y;
+  }
+
+  void bezier_to(
+    float const x_1,
+    float const y_1,
+    float const x_2,
+    float const y_2,
+    float const x_3,
+    float const y_3)
+  {
+    Util::subdivide_bezier(
+      [this](auto const& x, auto const& y)
+      {
+        rasterizer_.line_to(*this, x, y);
+      },
+      x_, y_, x_1, y_1, x_2, y_2, x_3, y_3);
+
+    x_ = x_3;
+    y_ = y_3;
+  }
+
+  void close_outline()
+  {
+    rasterizer_.close(*this);
+    x_ = x_0_;
+    y_ = y_0_;
+  }
+
+  // Closes the outline and hands out everything recorded since the
+  // previous call.
+  [[nodiscard]] Cell_list record()
+  {
+    using Cell = Cell_list::Cell;
+
+    close_outline();
+    rasterizer_.reset();
+    x_0_ = 0.f;
+    y_0_ = 0.f;
+    x_ = 0.f;
+    y_ = 0.f;
+
+    ::std::sort(
+      cells_.begin(), cells_.end(),
+      [](Cell const& a, Cell const& b) noexcept
+      {
+        return a.y < b.y || (a.y == b.y && a.x < b.x);
+      });
+
+    auto dst = cells_.begin();
+    auto src = cells_.begin();
+    auto const cells_end = cells_.end();
+
+    while(cells_end != src)
+    {
+      Cell cell = *src;
+      while(cells_end != ++src && src->y == cell.y && src->x == cell.x)
+      {
+        cell.cover += src->cover;
+        cell.area += src->area;
+      }
+
+      if(0 != cell.cover || 0 != cell.area)
+      {
+        *dst = cell;
+        ++dst;
+      }
+    }
+
+    // Copied rather than moved so that the recorder keeps its capacity.
+    Cell_list::Vector_<Cell> cells(cells_.begin(), dst);
+    cells_.clear();
+    return Cell_list(::std::move(cells));
+  }
+
+  void inc_x() noexcept
+  {
+    ++cell_x_;
+  }
+
+  void set_x(Int_32 const x) noexcept
+  {
+    cell_x_ = x;
+  }
+
+  void set_y(Int_32 const y) noexcept
+  {
+    cell_y_ = y;
+  }
+
+  void set_cell(Int_32 const cover, Int_32 const area)
+  {
+    if(!cells_.empty())
+    {
+      auto& cell = cells_.back();
+      if(cell.x == cell_x_ && cell.y == cell_y_)
+      {
+        cell.cover += cover;
+        cell.area += area;
+        return;
+      }
+    }
+
+    cells_.push_back(Cell_list::Cell{cell_x_, cell_y_, cover, area});
+  }
+
+private:
+  Rasterizer rasterizer_;
+  Cell_list::Vector_<Cell_list::Cell> cells_;
+  Int_32 cell_x_;
+  Int_32 cell_y_;
+  float x_0_;
+  float y_0_;
+  float x_;
+  float y_;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_CELLLIST_HH
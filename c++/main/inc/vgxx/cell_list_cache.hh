@@ -0,0 +1,190 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_CELLLISTCACHE_HH
+#define VGXX_CELLLISTCACHE_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+#include <vgxx/cell_list.hh>
+#include <vgxx/fill_rule.hh>
+#include <vgxx/path.hh>
+#include <vgxx/pixel_box.hh>
+#include <vgxx/util.hh>
+
+namespace vgxx
+{
+
+// Instancing cache for outlines drawn many times at different positions.
+// Each key is rasterized once per subpixel phase, quantized to
+// 1/subpixel_steps of a pixel on each axis, and every later instance
+// replays the retained cells at a whole-pixel offset.
+template<class K, class H = ::std::hash<K>>
+struct Cell_list_cache
+{
+  using Key = K;
+  using Hash = H;
+  using Int_32 = ::std::int32_t;
+  using Size = ::std::size_t;
+
+  static Int_32 constexpr subpixel_steps = 4;
+
+  Cell_list_cache(Cell_list_cache&&) = delete;
+  Cell_list_cache(Cell_list_cache const&) = delete;
+
+  explicit Cell_list_cache(Size const capacity = 256u) :
+    capacity_(0u < capacity ? capacity : 1u),
+    hit_count_(0u),
+    miss_count_(0u)
+  {}
+
+  Cell_list_cache& operator =(Cell_list_cache&&) = delete;
+  Cell_list_cache& operator =(Cell_list_cache const&) = delete;
+
+  // Fills the path, given relative to its own origin, placed at (x, y).
+  template<class Renderer>
+  Pixel_box fill(
+    Renderer& renderer,
+    Key const& key,
+    Path const& path,
+    float const x,
+    float const y,
+    Fill_rule const fill_rule)
+  {
+    Int_32 dx, dy, phase_x, phase_y;
+    Util::split_subpixel(x, subpixel_steps, dx, phase_x);
+    Util::split_subpixel(y, subpixel_steps, dy, phase_y);
+    return renderer.fill(
+      get_(key, path, phase_x, phase_y), dx, dy, fill_rule);
+  }
+
+  [[nodiscard]] Size size() const noexcept
+  {
+    return entries_.size();
+  }
+
+  [[nodiscard]] Size hit_count() const noexcept
+  {
+    return hit_count_;
+  }
+
+  [[nodiscard]] Size miss_count() const noexcept
+  {
+    return miss_count_;
+  }
+
+  void clear() noexcept
+  {
+    index_.clear();
+    entries_.clear();
+  }
+
+private:
+  struct Entry_key_
+  {
+    [[nodiscard]] bool operator ==(Entry_key_ const& other) const
+    {
+      return
+        phase_x == other.phase_x &&
+        phase_y == other.phase_y &&
+        key == other.key;
+    }
+
+    Key key;
+    Int_32 phase_x;
+    Int_32 phase_y;
+  };
+
+  struct Entry_key_hash_
+  {
+    [[nodiscard]] Size operator ()(Entry_key_ const& entry_key) const
+    {
+      auto const phase = static_cast<Size>(
+        entry_key.phase_y * subpixel_steps + entry_key.phase_x);
+      return Hash{}(entry_key.key) * 31u + phase;
+    }
+  };
+
+  struct Entry_
+  {
+    Entry_key_ key;
+    Cell_list cells;
+  };
+
+  using Entries_ = ::std::list<Entry_>;
+  using Index_ = ::std::unordered_map<
+    Entry_key_, typename Entries_::iterator, Entry_key_hash_>;
+
+  [[nodiscard]] Cell_list const& get_(
+    Key const& key,
+    Path const& path,
+    Int_32 const phase_x,
+    Int_32 const phase_y)
+  {
+    Entry_key_ entry_key{key, phase_x, phase_y};
+    auto const found = index_.find(entry_key);
+
+    if(index_.end() != found)
+    {
+      // Most recently used entries are kept at the front.
+      ++hit_count_;
+      entries_.splice(entries_.begin(), entries_, found->second);
+      return found->second->cells;
+    }
+
+    ++miss_count_;
+    auto constexpr step = 1.f / static_cast<float>(subpixel_steps);
+    path.replay(
+      recorder_,
+      static_cast<float>(phase_x) * step,
+      static_cast<float>(phase_y) * step);
+    Cell_list cells = recorder_.record();
+
+    if(capacity_ <= entries_.size())
+    {
+      index_.erase(entries_.back().key);
+      entries_.pop_back();
+    }
+
+    entries_.push_front(Entry_{entry_key, ::std::move(cells)});
+    index_.emplace(::std::move(entry_key), entries_.begin());
+    return entries_.front().cells;
+  }
+
+  Cell_recorder recorder_;
+  Entries_ entries_;
+  Index_ index_;
+  Size const capacity_;
+  Size hit_count_;
+  Size miss_count_;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_CELLLISTCACHE_HH
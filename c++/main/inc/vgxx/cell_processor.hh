@@ -24,6 +24,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #ifndef VGXX_CELLPROCESSOR_HH
 #define VGXX_CELLPROCESSOR_HH
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -31,45 +32,142 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <memory>
 #include <stdexcept>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <vgxx/fill_rule.hh>
+#include <vgxx/pixel_box.hh>
 #include <vgxx/util.hh>
 
 namespace vgxx
 {
 
-struct Cell_processor
+template<class C>
+struct Basic_cell_processor
 {
+  using Coord = C;
   using Int_32 = ::std::int32_t;
   using Unt_16 = ::std::uint16_t;
 
-  Cell_processor(Cell_processor&&) = delete;
-  Cell_processor(Cell_processor const&) = delete;
+  static_assert(
+    ::std::is_same<Coord, ::std::uint16_t>::value ||
+    ::std::is_same<Coord, ::std::uint32_t>::value);
 
-  explicit Cell_processor(Unt_16 const width, Unt_16 const height) :
-    rows_(nullptr),
-    width_(static_cast<Int_32>(width)) ,
-    height_(static_cast<Int_32>(height)),
+  // The rasterizer works in 24.8 fixed point, so this is the largest
+  // dimension it can address.
+  static Coord constexpr max_dimension =
+    ::std::numeric_limits<Coord>::max() < 0x7fffffu ?
+    ::std::numeric_limits<Coord>::max() :
+    static_cast<Coord>(0x7fffffu);
+
+  Basic_cell_processor(Basic_cell_processor const&) = delete;
+
+  explicit Basic_cell_processor(Coord const width, Coord const height) :
+    width_(0),
+    height_(0),
     x_(0),
     y_(0)
   {
-    if(0u < width && 0u < height)
+    resize(width, height);
+  }
+
+  Basic_cell_processor(Basic_cell_processor&& other) noexcept :
+    row_blocks_(::std::move(other.row_blocks_)),
+    cells_(::std::move(other.cells_)),
+    span_(::std::move(other.span_)),
+    sparse_cells_(::std::move(other.sparse_cells_)),
+    cell_stash_(::std::move(other.cell_stash_)),
+    width_(other.width_),
+    height_(other.height_),
+    x_(other.x_),
+    y_(other.y_),
+    y_range_(other.y_range_)
+  {
+    other.release_();
+  }
+
+  Basic_cell_processor& operator =(Basic_cell_processor const&) = delete;
+
+  Basic_cell_processor& operator =(Basic_cell_processor&& other) noexcept
+  {
+    if(this != &other)
     {
-      rows_ = new Row_[static_cast<Size_>(height)];
+      row_blocks_ = ::std::move(other.row_blocks_);
+      cells_ = ::std::move(other.cells_);
+      span_ = ::std::move(other.span_);
+      sparse_cells_ = ::std::move(other.sparse_cells_);
+      cell_stash_ = ::std::move(other.cell_stash_);
+      width_ = other.width_;
+      height_ = other.height_;
+      x_ = other.x_;
+      y_ = other.y_;
+      y_range_ = other.y_range_;
+      other.release_();
     }
+
+    return *this;
+  }
+
+  [[nodiscard]] Coord width() const noexcept
+  {
+    return static_cast<Coord>(width_);
+  }
+
+  [[nodiscard]] Coord height() const noexcept
+  {
+    return static_cast<Coord>(height_);
   }
 
-  ~Cell_processor()
+  // Changes the canvas size and drops any cells accumulated so far.
+  // Row blocks and the cell stash are kept, so a processor that has
+  // already rendered at the new size does not allocate again.
+  void resize(Coord const width, Coord const height)
   {
-    if(rows_)
+    if(max_dimension < width || max_dimension < height)
+    {
+      throw Overflow_error_("Canvas is too large");
+    }
+
+    reset();
+
+    if(0u < width && 0u < height)
     {
-      delete[] rows_;
+      // Rows are allocated block by block on first use, so only the
+      // directory is sized by the canvas height.
+      Size_ const block_count =
+        ((static_cast<Size_>(height) - 1u) >> row_block_bits_) + 1u;
+      if(row_blocks_.size() < block_count)
+      {
+        row_blocks_.resize(block_count);
+      }
     }
+
+    width_ = static_cast<Int_32>(width);
+    height_ = static_cast<Int_32>(height);
+    x_ = 0;
+    y_ = 0;
   }
 
-  Cell_processor& operator =(Cell_processor&&) = delete;
-  Cell_processor& operator =(Cell_processor const&) = delete;
+  // Drops the cells accumulated since the last swipe.
+  void reset() noexcept
+  {
+    if(y_range_)
+    {
+      for_each_row_run_(
+        [](Row_* row, Int_32 y, Int_32 const y_last) noexcept
+        {
+          for(; y_last >= y; ++y)
+          {
+            row->reset();
+            ++row;
+          }
+        });
+
+      y_range_.reset();
+    }
+
+    cell_stash_.reset();
+  }
 
   void inc_x() noexcept
   {
@@ -90,7 +188,7 @@ struct Cell_processor
   {
     if(height_ > y_ && 0 <= y_)
     {
-      Row_& row = rows_[y_];
+      Row_& row = row_(y_);
       if(0 <= x_)
       {
         if(width_ > x_)
@@ -99,7 +197,7 @@ struct Cell_processor
           if(invalid_cell_index_ != cell_idx)
           {
             auto& cell = cell_stash_[cell_idx];
-            if(cell.x == x_)
+            if(cell.x == static_cast<Coord>(x_))
             {
               cell.cover += cover;
               cell.area += area;
@@ -112,15 +210,15 @@ struct Cell_processor
           cell.cover = cover;
           cell.area = area;
           cell.next_cell_idx = cell_idx;
-          cell.x = x_;
+          cell.x = static_cast<Coord>(x_);
           cell_idx = new_cell_idx;
-          row.x_range.update(x_);
+          row.x_range.update(static_cast<Coord>(x_));
         }
         else // width_ <= x
         {
           if(0 < width_)
           {
-            row.x_range.update(static_cast<Unt_16>(width_ - 1));
+            row.x_range.update(static_cast<Coord>(width_ - 1));
           }
         }
       }
@@ -130,20 +228,55 @@ struct Cell_processor
         row.x_range.update(0u);
       }
 
-      y_range_.update(y_);
+      y_range_.update(static_cast<Coord>(y_));
     }
   }
 
+  // Blends the accumulated cells and returns the bounds of the pixels
+  // that have been blended.
+  //
+  // If the blender has blend_solid(coverage, count), which blends count
+  // pixels from the current one with the same coverage, rows with few
+  // cells for their width are swiped cell by cell: the runs between cells
+  // go to blend_solid() in one call, so the work follows the length of
+  // the edges rather than the area.
+  //
+  // If the blender has blend_span(coverage, count), which blends count
+  // pixels from the current one with a coverage each, the other rows
+  // gather the coverage of every run of covered pixels and hand it to
+  // blend_span() in one call instead of calling blend() per pixel.
   template<class Blender>
-  void swipe(Blender&& blender, Fill_rule const fill_rule)
+  Pixel_box swipe(Blender&& blender, Fill_rule const fill_rule)
+  {
+    Pixel_box box;
+    swipe(static_cast<Blender&&>(blender), fill_rule, box);
+    return box;
+  }
+
+  template<Fill_rule fill_rule, class Blender>
+  Pixel_box swipe(Blender&& blender)
+  {
+    Pixel_box box;
+    swipe<fill_rule>(static_cast<Blender&&>(blender), box);
+    return box;
+  }
+
+  // Reports the blended pixels of every row to damage.add_row(y, x_min,
+  // x_max).
+  template<class Blender, class Damage>
+  void swipe(Blender&& blender, Fill_rule const fill_rule, Damage&& damage)
   {
     switch(fill_rule)
     {
     case Fill_rule::non_zero:
-      swipe<Fill_rule::non_zero>(static_cast<Blender&&>(blender));
+      swipe<Fill_rule::non_zero>(
+        static_cast<Blender&&>(blender),
+        static_cast<Damage&&>(damage));
       break;
     case Fill_rule::even_odd:
-      swipe<Fill_rule::even_odd>(static_cast<Blender&&>(blender));
+      swipe<Fill_rule::even_odd>(
+        static_cast<Blender&&>(blender),
+        static_cast<Damage&&>(damage));
       break;
     default:
       assert(false);
@@ -151,8 +284,8 @@ struct Cell_processor
     }
   }
 
-  template<Fill_rule fill_rule, class Blender>
-  void swipe(Blender&& blender)
+  template<Fill_rule fill_rule, class Blender, class Damage>
+  void swipe(Blender&& blender, Damage&& damage)
   {
     static_assert(
       Fill_rule::non_zero == fill_rule ||
@@ -160,123 +293,30 @@ struct Cell_processor
 
     if(y_range_)
     {
-      auto* row = rows_;
-      Cell_* cell;
-      Int_32 cover, mid_cover;
-      auto y = y_range_.min;
-      Unt_8_ coverage, mid_coverage;
-      row += y;
-      static_cast<Blender&&>(blender).set_y(y);
-
-      for(;;)
-      {
-        auto& x_range = row->x_range;
-        if(x_range)
+      for_each_row_run_(
+        [this, &blender, &damage](Row_* row, Int_32 y, Int_32 const y_last)
         {
-          auto const& x_min = x_range.min;
-          auto const& x_max = x_range.max;
-          Size_ const x_range_size = static_cast<Size_>(x_max - x_min) + 1u;
-          if(cells_.size() < x_range_size)
-          {
-            cells_.resize(x_range_size);
-          }
-
-          auto cell_idx = row->first_cell_idx;
-          cell = cells_.data();
-          while(invalid_cell_index_ != cell_idx)
-          {
-            auto const& src_cell = cell_stash_[cell_idx];
-            auto& dst_cell = cell[src_cell.x - x_min];
-            dst_cell.cover += src_cell.cover;
-            dst_cell.area += src_cell.area;
-            cell_idx = src_cell.next_cell_idx;
-          }
-
-          auto x = x_min;
-          cover = row->left_cover;
-          mid_coverage = 0u;
-          static_cast<Blender&&>(blender).set_x(x);
+          static_cast<Blender&&>(blender).set_y(y);
 
           for(;;)
           {
-            if(*cell)
-            {
-              cover += cell->cover;
-              coverage =
-                Util::compute_cell_coverage<fill_rule>(cover, cell->area);
-              mid_coverage = 0u;
-              cell->reset();
-            }
-            else
-            {
-              if(1u > mid_coverage && 0 != cover)
-              {
-                mid_cover = cover;
-                if(0 > mid_cover)
-                {
-                  mid_cover = -mid_cover;
-                }
-
-                if constexpr(Fill_rule::non_zero == fill_rule)
-                {
-                  if (0x100 < mid_cover)
-                  {
-                    mid_cover = 0x100;
-                  }
-                }
-                else // Fill_rule::non_zero == fill_rule
-                {
-                  if(((mid_cover >> 8u) & 1) == 0)
-                  {
-                    // Even.
-                    mid_cover &= 0xff;
-                  }
-                  else
-                  {
-                    // Odd.
-                    mid_cover = 0x100 - (mid_cover & 0xff);
-                  }
-                }
-
-                // * 255 / 256
-                mid_coverage =
-                  static_cast<Unt_8_>(((mid_cover << 8u) - mid_cover) >> 8u);
-              }
-
-              coverage = mid_coverage;
-            }
-
-            if(0u < coverage)
-            {
-              static_cast<Blender&&>(blender).blend(coverage);
-            }
+            swipe_row_<fill_rule>(
+              *row, y,
+              static_cast<Blender&&>(blender),
+              static_cast<Damage&&>(damage));
 
-            if(x_max > x)
+            if(y_last > y)
             {
-              ++cell;
-              ++x;
-              static_cast<Blender&&>(blender).inc_x();
+              ++row;
+              ++y;
+              static_cast<Blender&&>(blender).inc_y();
             }
             else
             {
               break;
             }
           }
-
-          row->reset();
-        }
-
-        if(y_range_.max > y)
-        {
-          ++row;
-          ++y;
-          static_cast<Blender&&>(blender).inc_y();
-        }
-        else
-        {
-          break;
-        }
-      }
+        });
 
       y_range_.reset();
     }
@@ -297,14 +337,17 @@ private:
   template<class T>
   using Numeric_limits_ = ::std::numeric_limits<T>;
 
+  template<class T>
+  using Unique_ptr_ = ::std::unique_ptr<T>;
+
   template<class T>
   using Vector_ = ::std::vector<T>;
 
   struct Pixel_range_
   {
     Pixel_range_() noexcept :
-      min(unt_16_max_),
-      max(unt_16_min_)
+      min(coord_max_),
+      max(coord_min_)
     {}
 
     [[nodiscard]] explicit operator bool() const noexcept
@@ -314,11 +357,11 @@ private:
 
     void reset() noexcept
     {
-      min = unt_16_max_;
-      max = unt_16_min_;
+      min = coord_max_;
+      max = coord_min_;
     }
 
-    void update(Unt_16 const val) noexcept
+    void update(Coord const val) noexcept
     {
       if(val < min) {
         min = val;
@@ -328,14 +371,14 @@ private:
       }
     }
 
-    Unt_16 min;
-    Unt_16 max;
+    Coord min;
+    Coord max;
 
   private:
-    using Unt_16_limits_ = Numeric_limits_<Unt_16>;
+    using Coord_limits_ = Numeric_limits_<Coord>;
 
-    static Unt_16 constexpr unt_16_min_ = Unt_16_limits_::min();
-    static Unt_16 constexpr unt_16_max_ = Unt_16_limits_::max();
+    static Coord constexpr coord_min_ = Coord_limits_::min();
+    static Coord constexpr coord_max_ = Coord_limits_::max();
   };
 
   struct Cell_
@@ -358,9 +401,38 @@ private:
   struct Cell_ex_ : Cell_
   {
     Cell_index_ next_cell_idx;
-    Unt_16 x;
+    Coord x;
   };
 
+  struct Sparse_cell_ : Cell_
+  {
+    Coord x;
+  };
+
+  template<class Blender, class = void>
+  struct Has_blend_solid_ : ::std::false_type
+  {};
+
+  template<class Blender>
+  struct Has_blend_solid_<
+    Blender,
+    decltype(void(::std::declval<Blender&>().blend_solid(
+      ::std::declval<Unt_8_>(), ::std::declval<Size_>())))> :
+    ::std::true_type
+  {};
+
+  template<class Blender, class = void>
+  struct Has_blend_span_ : ::std::false_type
+  {};
+
+  template<class Blender>
+  struct Has_blend_span_<
+    Blender,
+    decltype(void(::std::declval<Blender&>().blend_span(
+      ::std::declval<Unt_8_ const*>(), ::std::declval<Size_>())))> :
+    ::std::true_type
+  {};
+
   struct Cell_stash_
   {
     template<class I>
@@ -447,17 +519,411 @@ private:
 
   static auto constexpr invalid_cell_index_ =
     Numeric_limits_<Cell_index_>::max();
+  static Size_ constexpr row_block_bits_ = 6u;
+  static Size_ constexpr row_block_size_ = Size_{1u} << row_block_bits_;
+  static Int_32 constexpr row_block_mask_ =
+    static_cast<Int_32>(row_block_size_ - 1u);
+
+  // Rows at least this many times wider than their cell count are swiped
+  // cell by cell when the blender can blend solid runs.
+  static Size_ constexpr sparse_ratio_ = 8u;
+
+  template<Fill_rule fill_rule, class Blender, class Damage>
+  void swipe_row_(
+    Row_& row,
+    Int_32 const y,
+    Blender&& blender,
+    Damage&& damage)
+  {
+    Cell_* cell;
+    Int_32 cover, mid_cover;
+    Unt_8_ coverage, mid_coverage;
+    Int_32 blended_x_min = 0;
+    Int_32 blended_x_max = -1;
+    bool constexpr has_blend_span = Has_blend_span_<Decay<Blender>>::value;
+
+    if constexpr(Has_blend_solid_<Decay<Blender>>::value)
+    {
+      if(gather_sparse_row_(row))
+      {
+        swipe_sparse_row_<fill_rule>(
+          row, y,
+          static_cast<Blender&&>(blender),
+          static_cast<Damage&&>(damage));
+        return;
+      }
+    }
 
-  Row_* rows_;
+    auto& x_range = row.x_range;
+    if(x_range)
+    {
+      auto const& x_min = x_range.min;
+      auto const& x_max = x_range.max;
+      Size_ const x_range_size = static_cast<Size_>(x_max - x_min) + 1u;
+      if(cells_.size() < x_range_size)
+      {
+        cells_.resize(x_range_size);
+      }
+      if constexpr(has_blend_span)
+      {
+        if(span_.size() < x_range_size)
+        {
+          span_.resize(x_range_size);
+        }
+      }
+
+      auto cell_idx = row.first_cell_idx;
+      cell = cells_.data();
+      while(invalid_cell_index_ != cell_idx)
+      {
+        auto const& src_cell = cell_stash_[cell_idx];
+        auto& dst_cell = cell[src_cell.x - x_min];
+        dst_cell.cover += src_cell.cover;
+        dst_cell.area += src_cell.area;
+        cell_idx = src_cell.next_cell_idx;
+      }
+
+      auto x = x_min;
+      cover = row.left_cover;
+      mid_coverage = 0u;
+      Unt_8_* const span = span_.data();
+      Size_ span_size = 0u;
+      if constexpr(!has_blend_span)
+      {
+        static_cast<Blender&&>(blender).set_x(x);
+      }
+
+      for(;;)
+      {
+        if(*cell)
+        {
+          cover += cell->cover;
+          coverage =
+            Util::compute_cell_coverage<fill_rule>(cover, cell->area);
+          mid_coverage = 0u;
+          cell->reset();
+        }
+        else
+        {
+          if(1u > mid_coverage && 0 != cover)
+          {
+            mid_cover = cover;
+            if(0 > mid_cover)
+            {
+              mid_cover = -mid_cover;
+            }
+
+            if constexpr(Fill_rule::non_zero == fill_rule)
+            {
+              if (0x100 < mid_cover)
+              {
+                mid_cover = 0x100;
+              }
+            }
+            else // Fill_rule::non_zero == fill_rule
+            {
+              if(((mid_cover >> 8u) & 1) == 0)
+              {
+                // Even.
+                mid_cover &= 0xff;
+              }
+              else
+              {
+                // Odd.
+                mid_cover = 0x100 - (mid_cover & 0xff);
+              }
+            }
+
+            // * 255 / 256
+            mid_coverage =
+              static_cast<Unt_8_>(((mid_cover << 8u) - mid_cover) >> 8u);
+          }
+
+          coverage = mid_coverage;
+        }
+
+        if(0u < coverage)
+        {
+          if constexpr(has_blend_span)
+          {
+            span[span_size++] = coverage;
+          }
+          else
+          {
+            static_cast<Blender&&>(blender).blend(coverage);
+          }
+
+          if(0 > blended_x_max)
+          {
+            blended_x_min = x;
+          }
+          blended_x_max = x;
+        }
+        else if constexpr(has_blend_span)
+        {
+          if(0u < span_size)
+          {
+            blend_span_(static_cast<Blender&&>(blender), x, span, span_size);
+          }
+        }
+
+        if(x_max > x)
+        {
+          ++cell;
+          ++x;
+          if constexpr(!has_blend_span)
+          {
+            static_cast<Blender&&>(blender).inc_x();
+          }
+        }
+        else
+        {
+          break;
+        }
+      }
+
+      if constexpr(has_blend_span)
+      {
+        if(0u < span_size)
+        {
+          blend_span_(
+            static_cast<Blender&&>(blender), x + 1, span, span_size);
+        }
+      }
+
+      row.reset();
+
+      if(0 <= blended_x_max)
+      {
+        static_cast<Damage&&>(damage).add_row(
+          y, blended_x_min, blended_x_max);
+      }
+    }
+  }
+
+  // Blends the run of span_size pixels that ends before x_end and empties
+  // the span.
+  template<class Blender>
+  static void blend_span_(
+    Blender&& blender,
+    Int_32 const x_end,
+    Unt_8_ const* const span,
+    Size_& span_size)
+  {
+    static_cast<Blender&&>(blender).set_x(
+      x_end - static_cast<Int_32>(span_size));
+    static_cast<Blender&&>(blender).blend_span(span, span_size);
+    span_size = 0u;
+  }
+
+  // Copies the cells of the row to sparse_cells_, sorted by x with the
+  // cells at the same x merged, if the row has few enough of them.
+  [[nodiscard]] bool gather_sparse_row_(Row_ const& row)
+  {
+    auto const& x_range = row.x_range;
+    if(!x_range)
+    {
+      return false;
+    }
+
+    Size_ const max_count =
+      (static_cast<Size_>(x_range.max - x_range.min) + 1u) / sparse_ratio_;
+    Size_ count = 0u;
+    for(auto idx = row.first_cell_idx; invalid_cell_index_ != idx;
+      idx = cell_stash_[idx].next_cell_idx)
+    {
+      if(max_count <= count++)
+      {
+        return false;
+      }
+    }
+
+    sparse_cells_.clear();
+    for(auto idx = row.first_cell_idx; invalid_cell_index_ != idx;
+      idx = cell_stash_[idx].next_cell_idx)
+    {
+      auto const& cell = cell_stash_[idx];
+      Sparse_cell_ sparse_cell;
+      sparse_cell.cover = cell.cover;
+      sparse_cell.area = cell.area;
+      sparse_cell.x = cell.x;
+      sparse_cells_.push_back(sparse_cell);
+    }
+
+    // The stash lists a row from its last cell, so reversing first makes
+    // the list nearly sorted.
+    ::std::reverse(sparse_cells_.begin(), sparse_cells_.end());
+    ::std::stable_sort(
+      sparse_cells_.begin(), sparse_cells_.end(),
+      [](Sparse_cell_ const& a, Sparse_cell_ const& b) noexcept
+      {
+        return a.x < b.x;
+      });
+
+    auto dst = sparse_cells_.begin();
+    for(auto src = sparse_cells_.begin(); sparse_cells_.end() != src; ++src)
+    {
+      if(sparse_cells_.begin() != dst && (dst - 1)->x == src->x)
+      {
+        (dst - 1)->cover += src->cover;
+        (dst - 1)->area += src->area;
+      }
+      else
+      {
+        *dst++ = *src;
+      }
+    }
+    sparse_cells_.erase(dst, sparse_cells_.end());
+
+    return true;
+  }
+
+  // Swipes a row gathered by gather_sparse_row_(). Produces exactly the
+  // coverage the dense swipe does.
+  template<Fill_rule fill_rule, class Blender, class Damage>
+  void swipe_sparse_row_(
+    Row_& row,
+    Int_32 const y,
+    Blender&& blender,
+    Damage&& damage)
+  {
+    Int_32 blended_x_min = 0;
+    Int_32 blended_x_max = -1;
+    Int_32 cover = row.left_cover;
+    Int_32 x = row.x_range.min;
+    Int_32 const x_max = row.x_range.max;
+
+    auto const blend_run = [&](Int_32 const x_end)
+      {
+        Unt_8_ const coverage = Util::compute_cell_coverage<fill_rule>(
+          cover, 0);
+        if(0u < coverage)
+        {
+          static_cast<Blender&&>(blender).set_x(x);
+          static_cast<Blender&&>(blender).blend_solid(
+            coverage, static_cast<Size_>(x_end - x));
+          if(0 > blended_x_max)
+          {
+            blended_x_min = x;
+          }
+          blended_x_max = x_end - 1;
+        }
+      };
+
+    for(auto const& cell : sparse_cells_)
+    {
+      Int_32 const cell_x = static_cast<Int_32>(cell.x);
+      if(x < cell_x)
+      {
+        blend_run(cell_x);
+      }
+
+      cover += cell.cover;
+      Unt_8_ const coverage = Util::compute_cell_coverage<fill_rule>(
+        cover, cell.area);
+      if(0u < coverage)
+      {
+        static_cast<Blender&&>(blender).set_x(cell_x);
+        static_cast<Blender&&>(blender).blend(coverage);
+        if(0 > blended_x_max)
+        {
+          blended_x_min = cell_x;
+        }
+        blended_x_max = cell_x;
+      }
+
+      x = cell_x + 1;
+    }
+
+    if(x <= x_max)
+    {
+      blend_run(x_max + 1);
+    }
+
+    row.reset();
+
+    if(0 <= blended_x_max)
+    {
+      static_cast<Damage&&>(damage).add_row(
+        y, blended_x_min, blended_x_max);
+    }
+  }
+
+  // Invokes the callback for every run of consecutive allocated rows
+  // within y_range_.
+  template<class Callback>
+  void for_each_row_run_(Callback&& callback)
+  {
+    Int_32 y = y_range_.min;
+    Int_32 const y_max = y_range_.max;
+
+    for(;;)
+    {
+      auto const& row_block =
+        row_blocks_[static_cast<Size_>(y) >> row_block_bits_];
+      Int_32 block_y_max = y | row_block_mask_;
+      if(y_max < block_y_max)
+      {
+        block_y_max = y_max;
+      }
+
+      if(row_block)
+      {
+        static_cast<Callback&&>(callback)(
+          row_block.get() + (y & row_block_mask_), y, block_y_max);
+      }
+
+      if(y_max > block_y_max)
+      {
+        y = block_y_max + 1;
+      }
+      else
+      {
+        break;
+      }
+    }
+  }
+
+  void release_() noexcept
+  {
+    row_blocks_.clear();
+    cells_.clear();
+    span_.clear();
+    sparse_cells_.clear();
+    cell_stash_.reset();
+    width_ = 0;
+    height_ = 0;
+    y_range_.reset();
+  }
+
+  [[nodiscard]] Row_& row_(Int_32 const y)
+  {
+    auto& row_block = row_blocks_[static_cast<Size_>(y) >> row_block_bits_];
+    if(!row_block)
+    {
+      row_block.reset(new Row_[row_block_size_]);
+    }
+
+    return row_block[static_cast<Size_>(y & row_block_mask_)];
+  }
+
+  Vector_<Unique_ptr_<Row_[]>> row_blocks_;
   Vector_<Cell_> cells_;
+  Vector_<Unt_8_> span_;
+  Vector_<Sparse_cell_> sparse_cells_;
   Cell_stash_ cell_stash_;
-  Int_32 const width_;
-  Int_32 const height_;
+  Int_32 width_;
+  Int_32 height_;
   Int_32 x_;
   Int_32 y_;
   Pixel_range_ y_range_;
 };
 
+using Cell_processor = Basic_cell_processor<::std::uint16_t>;
+
+// Addresses canvases beyond 65535 pixels on a side.
+using Large_cell_processor = Basic_cell_processor<::std::uint32_t>;
+
 } // namespace vgxx
 
 #endif // VGXX_CELLPROCESSOR_HH
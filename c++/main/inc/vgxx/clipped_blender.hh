@@ -0,0 +1,212 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_CLIPPEDBLENDER_HH
+#define VGXX_CLIPPEDBLENDER_HH
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include <vgxx/blend_a8.hh>
+
+namespace vgxx
+{
+
+// Blender adaptor that clips any blender with an 8-bit alpha mask, such as
+// one rendered with Mask_blender_a8. The mask value of each pixel is
+// multiplied into the coverage before the wrapped blender sees it, which
+// gives arbitrary soft clip paths for a quarter of the memory traffic of
+// an RGBA mask.
+//
+// The mask covers the same pixels as the target image and is not owned.
+template<class B>
+struct Clipped_blender : B
+{
+  using Blender = B;
+  using Unt_8 = ::std::uint8_t;
+  using Int_32 = ::std::int32_t;
+  using Size = ::std::size_t;
+
+  explicit Clipped_blender(
+    Blender const& blender,
+    Unt_8 const* const mask,
+    Size const mask_bytes_per_row) :
+    Blender(blender),
+    mask_(mask),
+    mask_bytes_per_row_(mask_bytes_per_row)
+  {}
+
+  [[nodiscard]] Unt_8 const* mask() const noexcept
+  {
+    return mask_;
+  }
+
+  void set_mask(
+    Unt_8 const* const mask,
+    Size const mask_bytes_per_row) noexcept
+  {
+    mask_ = mask;
+    mask_row_ = nullptr;
+    mask_bytes_per_row_ = mask_bytes_per_row;
+  }
+
+  // The mask may hide any pixel.
+  [[nodiscard]] bool is_opaque() const noexcept
+  {
+    return false;
+  }
+
+  template<class X>
+  void set_x(X const& x) noexcept
+  {
+    Blender::set_x(x);
+    x_ = static_cast<Int_32>(x);
+  }
+
+  template<class Y>
+  void set_y(Y const& y) noexcept
+  {
+    Blender::set_y(y);
+    mask_row_ = mask_ + mask_bytes_per_row_ * static_cast<Size>(y);
+  }
+
+  void inc_x() noexcept
+  {
+    Blender::inc_x();
+    ++x_;
+  }
+
+  void inc_y() noexcept
+  {
+    Blender::inc_y();
+    mask_row_ += mask_bytes_per_row_;
+  }
+
+  void blend(Unt_8 const alpha)
+  {
+    assert(mask_row_);
+    Unt_8 const clipped = Blend_a8::combine(
+      mask_row_[x_], alpha, Mask_mode::intersect);
+    if(0u < clipped)
+    {
+      Blender::blend(clipped);
+    }
+  }
+
+  // Blends count pixels starting at the current one, each with its own
+  // coverage.
+  void blend_span(Unt_8 const* coverage, Size const count)
+  {
+    blend_<true>(coverage, 0u, count);
+  }
+
+  // Blends count pixels starting at the current one, all with the same
+  // coverage.
+  void blend_solid(Unt_8 const coverage, Size const count)
+  {
+    blend_<false>(nullptr, coverage, count);
+  }
+
+private:
+  // Pixels clipped per call of the wrapped blender.
+  static Size constexpr chunk_size_ = 256u;
+
+  template<class T, class = void>
+  struct Has_blend_span_ : ::std::false_type
+  {};
+
+  template<class T>
+  struct Has_blend_span_<
+    T,
+    decltype(void(::std::declval<T&>().blend_span(
+      ::std::declval<Unt_8 const*>(), ::std::declval<Size>())))> :
+    ::std::true_type
+  {};
+
+  template<bool coverage_span>
+  void blend_(Unt_8 const* coverage, Unt_8 const solid_coverage, Size count)
+  {
+    assert(mask_row_);
+    Unt_8 clipped[chunk_size_];
+    Int_32 x = x_;
+
+    while(0u < count)
+    {
+      Size const chunk = chunk_size_ < count ? chunk_size_ : count;
+      Unt_8 const* const mask = mask_row_ + x;
+      if constexpr(coverage_span)
+      {
+        Blend_a8::multiply(clipped, mask, coverage, chunk);
+        coverage += chunk;
+      }
+      else
+      {
+        Blend_a8::multiply(clipped, mask, solid_coverage, chunk);
+      }
+
+      Blender::set_x(x);
+      if constexpr(Has_blend_span_<Blender>::value)
+      {
+        Blender::blend_span(clipped, chunk);
+      }
+      else
+      {
+        for(Size i = 0u;;)
+        {
+          if(0u < clipped[i])
+          {
+            Blender::blend(clipped[i]);
+          }
+
+          if(chunk > ++i)
+          {
+            Blender::inc_x();
+          }
+          else
+          {
+            break;
+          }
+        }
+      }
+
+      x += static_cast<Int_32>(chunk);
+      count -= chunk;
+    }
+
+    // Spans do not move the current pixel.
+    Blender::set_x(x_);
+  }
+
+  Unt_8 const* mask_;
+  Unt_8 const* mask_row_ = nullptr;
+  Size mask_bytes_per_row_;
+  Int_32 x_ = 0;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_CLIPPEDBLENDER_HH
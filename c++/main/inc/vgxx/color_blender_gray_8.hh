@@ -0,0 +1,107 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_COLORBLENDERGRAY8_HH
+#define VGXX_COLORBLENDERGRAY8_HH
+
+#include <cassert>
+#include <cstdint>
+
+#include <vgxx/blend_gray_8.hh>
+#include <vgxx/blender_base.hh>
+
+namespace vgxx
+{
+
+// Blends a solid gray level into an 8-bit grayscale image, a quarter of
+// the bytes of a 32-bit image per pixel.
+struct Color_blender_gray_8 : Blender_base<::std::uint8_t>
+{
+private:
+  using Base_ = Blender_base<Color>;
+
+public:
+  // Color with red in the low byte and alpha in the top one, as for
+  // Color_blender_rgba_8888.
+  using Rgba = ::std::uint32_t;
+
+  using Base_::Base_;
+
+  [[nodiscard]] Color gray() const noexcept
+  {
+    return gray_;
+  }
+
+  [[nodiscard]] Color alpha() const noexcept
+  {
+    return alpha_;
+  }
+
+  void set_gray(Color const gray, Color const alpha = 0xffu) noexcept
+  {
+    gray_ = gray;
+    alpha_ = alpha;
+  }
+
+  // Takes the luma of the color.
+  void set_color(Rgba const c) noexcept
+  {
+    set_gray(Blend_gray_8::luma(c), static_cast<Color>(c >> 24u));
+  }
+
+  [[nodiscard]] bool is_opaque() const noexcept
+  {
+    return 0xffu == alpha_;
+  }
+
+  void blend(unsigned const alpha) const noexcept
+  {
+    assert(pixel());
+    Blend_gray_8::blend_pixel(*pixel(), gray_, alpha, alpha_);
+  }
+
+  // Blends count pixels starting at the current one, each with its own
+  // coverage.
+  void blend_span(Color const* const coverage, Size const count) const noexcept
+  {
+    assert(pixel());
+    Blend_gray_8::blend_span(pixel(), coverage, count, gray_, alpha_);
+  }
+
+  // Blends count pixels starting at the current one, all with the same
+  // coverage.
+  void blend_solid(Color const coverage, Size const count) const noexcept
+  {
+    assert(pixel());
+    Blend_gray_8::blend_solid(pixel(), coverage, count, gray_, alpha_);
+  }
+
+private:
+  Color gray_ = 0u;
+  Color alpha_ = 0u;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_COLORBLENDERGRAY8_HH
@@ -0,0 +1,127 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_COLORBLENDERPREMUL8888_HH
+#define VGXX_COLORBLENDERPREMUL8888_HH
+
+#include <cassert>
+#include <cstdint>
+
+#include <vgxx/blend_premul_8888.hh>
+#include <vgxx/blender_base.hh>
+#include <vgxx/composite_op.hh>
+
+namespace vgxx
+{
+
+// Solid color blender for premultiplied 32-bit images, RGBA or BGRA with
+// alpha in the top byte. Keeps the destination alpha and composites with
+// a Porter-Duff operator, src_over by default, so paths can be rendered
+// into transparent layers; Blend_premul_8888::composite() puts the layers
+// back.
+struct Color_blender_premul_8888 : Blender_base<::std::uint32_t>
+{
+private:
+  using Unt_8_ = ::std::uint8_t;
+  using Base_ = Blender_base<Color>;
+
+public:
+  using Base_::Base_;
+
+  // The premultiplied color.
+  [[nodiscard]] Color color() const noexcept
+  {
+    return color_;
+  }
+
+  // Takes a color with straight alpha and premultiplies it.
+  void set_color(Color const c) noexcept
+  {
+    color_ = Blend_premul_8888::premultiply(c);
+  }
+
+  void set_premultiplied_color(Color const c) noexcept
+  {
+    color_ = c;
+  }
+
+  [[nodiscard]] Composite_op op() const noexcept
+  {
+    return op_;
+  }
+
+  void set_op(Composite_op const op) noexcept
+  {
+    op_ = op;
+  }
+
+  // True if blending with full coverage replaces the pixel, whatever it
+  // was before.
+  [[nodiscard]] bool is_opaque() const noexcept
+  {
+    switch(op_)
+    {
+    case Composite_op::clear:
+    case Composite_op::src:
+      return true;
+    case Composite_op::src_over:
+      return 0xffu == color_ >> 24u;
+    default:
+      return false;
+    }
+  }
+
+  void blend(Color const alpha) const noexcept
+  {
+    Color* const dst_color = pixel();
+    assert(dst_color);
+    Blend_premul_8888::blend_pixel(*dst_color, color_, alpha, op_);
+  }
+
+  // Blends count pixels starting at the current one, each with its own
+  // coverage.
+  void blend_span(
+    Unt_8_ const* const coverage,
+    Size const count) const noexcept
+  {
+    assert(pixel());
+    Blend_premul_8888::blend_span(pixel(), coverage, count, color_, op_);
+  }
+
+  // Blends count pixels starting at the current one, all with the same
+  // coverage.
+  void blend_solid(Unt_8_ const coverage, Size const count) const noexcept
+  {
+    assert(pixel());
+    Blend_premul_8888::blend_solid(pixel(), coverage, count, color_, op_);
+  }
+
+private:
+  Color color_ = 0u;
+  Composite_op op_ = Composite_op::src_over;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_COLORBLENDERPREMUL8888_HH
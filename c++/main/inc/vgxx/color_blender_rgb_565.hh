@@ -0,0 +1,139 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_COLORBLENDERRGB565_HH
+#define VGXX_COLORBLENDERRGB565_HH
+
+#include <cassert>
+#include <cstdint>
+
+#include <vgxx/blend_565.hh>
+#include <vgxx/blender_base.hh>
+#include <vgxx/dither.hh>
+
+namespace vgxx
+{
+
+// Blends a solid color into a 16-bit RGB565 image, red in the top bits.
+// Half the bytes of a 32-bit image per pixel, which matters most where
+// rendering is bound by memory bandwidth. Blended values are quantized
+// with the given dithering, which depends on the pixel position, so that
+// smooth coverage does not turn into visible bands.
+template<Dither dither = Dither::none>
+struct Color_blender_rgb_565 : Blender_base<::std::uint16_t>
+{
+private:
+  using Unt_8_ = ::std::uint8_t;
+  using Int_32_ = ::std::int32_t;
+  using Base_ = Blender_base<Color>;
+  using Dither_map_ = Dither_map<dither>;
+
+public:
+  // Color with red in the low byte and alpha in the top one, as for
+  // Color_blender_rgba_8888.
+  using Rgba = ::std::uint32_t;
+
+  using Base_::Base_;
+
+  [[nodiscard]] Rgba color() const noexcept
+  {
+    return color_;
+  }
+
+  void set_color(Rgba const c) noexcept
+  {
+    color_ = c;
+  }
+
+  [[nodiscard]] bool is_opaque() const noexcept
+  {
+    return 0xffu == color_ >> 24u;
+  }
+
+  template<class X>
+  void set_x(X const& x) noexcept
+  {
+    Base_::set_x(x);
+    x_ = static_cast<Int_32_>(x);
+  }
+
+  template<class Y>
+  void set_y(Y const& y) noexcept
+  {
+    Base_::set_y(y);
+    biases_ = Dither_map_::row(static_cast<Int_32_>(y));
+    y_ = static_cast<Int_32_>(y);
+  }
+
+  void inc_x() noexcept
+  {
+    Base_::inc_x();
+    ++x_;
+  }
+
+  void inc_y() noexcept
+  {
+    Base_::inc_y();
+    biases_ = Dither_map_::row(++y_);
+  }
+
+  void blend(unsigned const alpha) const noexcept
+  {
+    assert(pixel());
+    Blend_565::blend_pixel(
+      *pixel(), color_, alpha, biases_[x_ & bias_mask_]);
+  }
+
+  // Blends count pixels starting at the current one, each with its own
+  // coverage.
+  void blend_span(
+    Unt_8_ const* const coverage,
+    Size const count) const noexcept
+  {
+    assert(pixel());
+    Blend_565::blend_span(
+      pixel(), coverage, count, color_, biases_, bias_mask_, x_);
+  }
+
+  // Blends count pixels starting at the current one, all with the same
+  // coverage.
+  void blend_solid(Unt_8_ const coverage, Size const count) const noexcept
+  {
+    assert(pixel());
+    Blend_565::blend_solid(
+      pixel(), coverage, count, color_, biases_, bias_mask_, x_);
+  }
+
+private:
+  static unsigned constexpr bias_mask_ = Dither_map_::period - 1u;
+
+  Rgba color_ = 0u;
+  Unt_8_ const* biases_ = Dither_map_::row(0);
+  Int_32_ x_ = 0;
+  Int_32_ y_ = 0;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_COLORBLENDERRGB565_HH
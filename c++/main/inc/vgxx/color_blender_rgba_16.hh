@@ -0,0 +1,105 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_COLORBLENDERRGBA16_HH
+#define VGXX_COLORBLENDERRGBA16_HH
+
+#include <cassert>
+#include <cstdint>
+
+#include <vgxx/blend_rgba_16.hh>
+#include <vgxx/blender_base.hh>
+
+namespace vgxx
+{
+
+// Blends a solid color into an image of 16 bits per channel, see
+// Blend_rgba_16 for the layout. Rounding error stays far below what an
+// 8-bit result can show after many passes.
+struct Color_blender_rgba_16 : Blender_base<::std::uint64_t>
+{
+private:
+  using Unt_8_ = ::std::uint8_t;
+  using Base_ = Blender_base<Color>;
+
+public:
+  using Base_::Base_;
+
+  [[nodiscard]] Color color() const noexcept
+  {
+    return color_;
+  }
+
+  void set_color(Color const c) noexcept
+  {
+    color_ = c;
+  }
+
+  // Takes an 8-bit color with red in the low byte.
+  void set_color_8888(::std::uint32_t const c) noexcept
+  {
+    color_ = Blend_rgba_16::from_8888(c);
+  }
+
+  [[nodiscard]] bool is_opaque() const noexcept
+  {
+    return 0xffffu == color_ >> 48u;
+  }
+
+  void blend(unsigned const alpha) const noexcept
+  {
+    assert(pixel());
+    auto const factor = Blend_rgba_16::factor(
+      alpha, static_cast<unsigned>(color_ >> 48u));
+    if(0u < factor)
+    {
+      Blend_rgba_16::blend_pixel(*pixel(), color_, factor);
+    }
+  }
+
+  // Blends count pixels starting at the current one, each with its own
+  // coverage.
+  void blend_span(
+    Unt_8_ const* const coverage,
+    Size const count) const noexcept
+  {
+    assert(pixel());
+    Blend_rgba_16::blend_span(pixel(), coverage, count, color_);
+  }
+
+  // Blends count pixels starting at the current one, all with the same
+  // coverage.
+  void blend_solid(Unt_8_ const coverage, Size const count) const noexcept
+  {
+    assert(pixel());
+    Blend_rgba_16::blend_solid(pixel(), coverage, count, color_);
+  }
+
+private:
+  Color color_ = 0u;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_COLORBLENDERRGBA16_HH
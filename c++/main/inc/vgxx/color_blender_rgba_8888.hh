@@ -27,6 +27,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <cassert>
 #include <cstdint>
 
+#include <vgxx/blend_8888.hh>
 #include <vgxx/blender_base.hh>
 #include <vgxx/util.hh>
 
@@ -37,6 +38,7 @@ struct Color_blender_rgba_8888 : Blender_base<::std::uint32_t>
 {
 private:
   using Int_32_ = ::std::int32_t;
+  using Unt_8_ = ::std::uint8_t;
   using Base_ = Blender_base<Color>;
 
 public:
@@ -59,6 +61,13 @@ public:
     }
   }
 
+  // True if blending with full coverage replaces the pixel, whatever it
+  // was before.
+  [[nodiscard]] bool is_opaque() const noexcept
+  {
+    return 0xffu == alpha_;
+  }
+
   void set_r_g_b_a(Color const r_g_b_a) noexcept
   {
     set_color(r_g_b_a);
@@ -98,6 +107,24 @@ public:
     }
   }
 
+  // Blends count pixels starting at the current one, each with its own
+  // coverage.
+  void blend_span(
+    Unt_8_ const* const coverage,
+    Size const count) const noexcept
+  {
+    assert(pixel());
+    Blend_8888::blend_span(pixel(), coverage, count, color_);
+  }
+
+  // Blends count pixels starting at the current one, all with the same
+  // coverage.
+  void blend_solid(Unt_8_ const coverage, Size const count) const noexcept
+  {
+    assert(pixel());
+    Blend_8888::blend_solid(pixel(), coverage, count, color_);
+  }
+
 private:
   [[nodiscard]] static Color get_alpha_(Color const color) noexcept
   {
@@ -0,0 +1,114 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_COLORBLENDERRGBAFLOAT_HH
+#define VGXX_COLORBLENDERRGBAFLOAT_HH
+
+#include <cassert>
+#include <cstdint>
+
+#include <vgxx/blend_rgba_float.hh>
+#include <vgxx/blender_base.hh>
+
+namespace vgxx
+{
+
+// Blends a solid color into an image of Rgba_f32 or Rgba_f16 pixels, for
+// HDR output and for compositing in many passes without 8-bit rounding.
+// The color is kept in single precision either way, see Blend_rgba_float.
+template<class P>
+struct Color_blender_rgba_float : Blender_base<P>
+{
+private:
+  using Unt_8_ = ::std::uint8_t;
+  using Base_ = Blender_base<P>;
+
+public:
+  using Size = typename Base_::Size;
+
+  using Base_::Base_;
+  using Base_::pixel;
+
+  [[nodiscard]] Rgba_f32 const& color() const noexcept
+  {
+    return color_;
+  }
+
+  // Takes a straight color with alpha from 0 to 1.
+  void set_color(Rgba_f32 const& c) noexcept
+  {
+    color_ = c;
+  }
+
+  // Takes an 8-bit color with red in the low byte.
+  void set_color_8888(::std::uint32_t const c) noexcept
+  {
+    color_ = Blend_rgba_float::from_8888(c);
+  }
+
+  [[nodiscard]] bool is_opaque() const noexcept
+  {
+    return 1.0f == color_.a;
+  }
+
+  void blend(unsigned const alpha) const noexcept
+  {
+    assert(pixel());
+    if(0u < alpha && 0.0f < color_.a)
+    {
+      Blend_rgba_float::blend_pixel(
+        *pixel(),
+        color_,
+        static_cast<float>(alpha) * (color_.a * (1.0f / 255.0f)));
+    }
+  }
+
+  // Blends count pixels starting at the current one, each with its own
+  // coverage.
+  void blend_span(
+    Unt_8_ const* const coverage,
+    Size const count) const noexcept
+  {
+    assert(pixel());
+    Blend_rgba_float::blend_span(pixel(), coverage, count, color_);
+  }
+
+  // Blends count pixels starting at the current one, all with the same
+  // coverage.
+  void blend_solid(Unt_8_ const coverage, Size const count) const noexcept
+  {
+    assert(pixel());
+    Blend_rgba_float::blend_solid(pixel(), coverage, count, color_);
+  }
+
+private:
+  Rgba_f32 color_ = {0.0f, 0.0f, 0.0f, 0.0f};
+};
+
+using Color_blender_rgba_f32 = Color_blender_rgba_float<Rgba_f32>;
+using Color_blender_rgba_f16 = Color_blender_rgba_float<Rgba_f16>;
+
+} // namespace vgxx
+
+#endif // VGXX_COLORBLENDERRGBAFLOAT_HH
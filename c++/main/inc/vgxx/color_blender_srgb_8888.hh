@@ -0,0 +1,94 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_COLORBLENDERSRGB8888_HH
+#define VGXX_COLORBLENDERSRGB8888_HH
+
+#include <cassert>
+#include <cstdint>
+
+#include <vgxx/blend_srgb_8888.hh>
+#include <vgxx/blender_base.hh>
+
+namespace vgxx
+{
+
+// Color_blender_rgba_8888 counterpart that blends in linear light, see
+// Blend_srgb_8888. Takes the same colors and renders into the same
+// images.
+struct Color_blender_srgb_8888 : Blender_base<::std::uint32_t>
+{
+private:
+  using Unt_8_ = ::std::uint8_t;
+  using Base_ = Blender_base<Color>;
+
+public:
+  using Base_::Base_;
+
+  [[nodiscard]] Color color() const noexcept
+  {
+    return color_;
+  }
+
+  void set_color(Color const c) noexcept
+  {
+    color_ = c;
+  }
+
+  [[nodiscard]] bool is_opaque() const noexcept
+  {
+    return 0xffu == color_ >> 24u;
+  }
+
+  void blend(Color const alpha) const noexcept
+  {
+    assert(pixel());
+    Blend_srgb_8888::blend_pixel(*pixel(), color_, alpha);
+  }
+
+  // Blends count pixels starting at the current one, each with its own
+  // coverage.
+  void blend_span(
+    Unt_8_ const* const coverage,
+    Size const count) const noexcept
+  {
+    assert(pixel());
+    Blend_srgb_8888::blend_span(pixel(), coverage, count, color_);
+  }
+
+  // Blends count pixels starting at the current one, all with the same
+  // coverage.
+  void blend_solid(Unt_8_ const coverage, Size const count) const noexcept
+  {
+    assert(pixel());
+    Blend_srgb_8888::blend_solid(pixel(), coverage, count, color_);
+  }
+
+private:
+  Color color_ = 0u;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_COLORBLENDERSRGB8888_HH
@@ -0,0 +1,54 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_COMPOSITEOP_HH
+#define VGXX_COMPOSITEOP_HH
+
+namespace vgxx
+{
+
+// Porter-Duff operators for premultiplied colors, plus additive plus.
+// With source S, destination D and their alphas Sa and Da, the result is
+// S * Fa + D * Fb for the factors listed; coverage then mixes the result
+// with D.
+enum class Composite_op
+{
+  clear = 0,     // Fa = 0,      Fb = 0
+  src = 1,       // Fa = 1,      Fb = 0
+  dst = 2,       // Fa = 0,      Fb = 1
+  src_over = 3,  // Fa = 1,      Fb = 1 - Sa
+  dst_over = 4,  // Fa = 1 - Da, Fb = 1
+  src_in = 5,    // Fa = Da,     Fb = 0
+  dst_in = 6,    // Fa = 0,      Fb = Sa
+  src_out = 7,   // Fa = 1 - Da, Fb = 0
+  dst_out = 8,   // Fa = 0,      Fb = 1 - Sa
+  src_atop = 9,  // Fa = Da,     Fb = 1 - Sa
+  dst_atop = 10, // Fa = 1 - Da, Fb = Sa
+  xor_ = 11,     // Fa = 1 - Da, Fb = 1 - Sa
+  plus = 12      // min(S + D, 1)
+};
+
+} // namespace vgxx
+
+#endif // VGXX_COMPOSITEOP_HH
@@ -0,0 +1,589 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_COMPOUNDRENDERER_HH
+#define VGXX_COMPOUNDRENDERER_HH
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <vgxx/fill_rule.hh>
+#include <vgxx/pixel_box.hh>
+#include <vgxx/rasterizer.hh>
+#include <vgxx/util.hh>
+
+namespace vgxx
+{
+
+// Fills many outlines, each tagged with a style, in a single pass. Styles
+// are blenders; a higher style id paints over a lower one. Cells of all
+// outlines are kept together and resolved once per pixel when fill() is
+// called.
+//
+// The styles at a pixel share its area like the faces of a planar map:
+// going from the top style down, each takes its coverage out of what is
+// left. The shares are then blended bottom-up, scaled so that their sum
+// replaces the same amount of the background. Two polygons that share an
+// edge thus cover the edge pixels completely, without the seam that
+// filling them one after another leaves. Each outline still rounds the
+// edge on its own, though, and a few edge pixels where the two differ by
+// more than a subpixel row, or put the edge into different pixels, are
+// left a level or two short of full.
+//
+// The shares are blended one style after another rather than mixed into
+// one color first: a style may be any blender, a gradient or a pattern,
+// and blenders only blend their own color into the image. Blenders with
+// blend_solid() get every run between cells in one call.
+//
+// Cells are kept in one vector tagged with their style and sorted by row,
+// column and style, instead of in a Cell_processor. A cell processor sums
+// the cells of all outlines, while the shares need the cover and area of
+// every style at a pixel, and a processor per style would swipe each row
+// once per style without seeing the other styles at the same pixel.
+template<class B>
+struct Compound_renderer
+{
+  using Blender = B;
+  using Coord = ::std::uint32_t;
+  using Int_32 = ::std::int32_t;
+  using Size = ::std::size_t;
+
+  static Coord constexpr max_dimension = 0x7fffffu;
+
+  explicit Compound_renderer(Coord const width, Coord const height) :
+    width_(static_cast<Int_32>(width)),
+    height_(static_cast<Int_32>(height)),
+    style_(0u),
+    cell_x_(0),
+    cell_y_(0),
+    x_0_(0.f),
+    y_0_(0.f),
+    x_(0.f),
+    y_(0.f)
+  {
+    assert(0u < width);
+    assert(0u < height);
+
+    if(max_dimension < width || max_dimension < height)
+    {
+      throw Overflow_error_("Canvas is too large");
+    }
+  }
+
+  [[nodiscard]] Coord width() const noexcept
+  {
+    return static_cast<Coord>(width_);
+  }
+
+  [[nodiscard]] Coord height() const noexcept
+  {
+    return static_cast<Coord>(height_);
+  }
+
+  // Adds a style constructed from the arguments and returns its id.
+  template<class... Blender_args>
+  Size add_style(Blender_args&&... blender_args)
+  {
+    styles_.emplace_back(static_cast<Blender_args&&>(blender_args)...);
+    return styles_.size() - 1u;
+  }
+
+  [[nodiscard]] Blender& style(Size const i) noexcept
+  {
+    return styles_[i];
+  }
+
+  [[nodiscard]] Blender const& style(Size const i) const noexcept
+  {
+    return styles_[i];
+  }
+
+  [[nodiscard]] Size style_count() const noexcept
+  {
+    return styles_.size();
+  }
+
+  // Removes all styles. Outlines that have not been filled yet are
+  // discarded as well.
+  void clear_styles() noexcept
+  {
+    styles_.clear();
+    cells_.clear();
+    style_ = 0u;
+  }
+
+  // Style of the outlines that follow, below style_count().
+  void set_style(Size const i)
+  {
+    assert(styles_.size() > i);
+    close_outline();
+    style_ = static_cast<Unt_32_>(i);
+  }
+
+  void move_to(float const x, float const y)
+  {
+    rasterizer_.move_to(*this, x, y);
+    x_0_ = x;
+    y_0_ = y;
+    x_ = x;
+    y_ = y;
+  }
+
+  void line_to(float const x, float const y)
+  {
+    rasterizer_.line_to(*this, x, y);
+    x_ = x;
+    y_ = y;
+  }
+
+  void bezier_to(
+    float const x_1,
+    float const y_1,
+    float const x_2,
+    float const y_2,
+    float const x_3,
+    float const y_3)
+  {
+    Util::subdivide_bezier(
+      [this](auto const& x, auto const& y)
+      {
+        rasterizer_.line_to(*this, x, y);
+      },
+      x_, y_, x_1, y_1, x_2, y_2, x_3, y_3);
+
+    x_ = x_3;
+    y_ = y_3;
+  }
+
+  void close_outline()
+  {
+    rasterizer_.close(*this);
+    x_ = x_0_;
+    y_ = y_0_;
+  }
+
+  // Blends all the outlines added since the previous fill and returns the
+  // bounds of the pixels that have been blended.
+  template<Fill_rule fill_rule>
+  Pixel_box fill()
+  {
+    close_outline();
+    rasterizer_.reset();
+    x_0_ = 0.f;
+    y_0_ = 0.f;
+    x_ = 0.f;
+    y_ = 0.f;
+
+    Pixel_box box;
+    if(!cells_.empty())
+    {
+      sort_cells_();
+      resolve_<fill_rule>(box);
+      cells_.clear();
+    }
+
+    return box;
+  }
+
+  Pixel_box fill(Fill_rule const fill_rule)
+  {
+    switch(fill_rule)
+    {
+    case Fill_rule::non_zero:
+      return fill<Fill_rule::non_zero>();
+    case Fill_rule::even_odd:
+      return fill<Fill_rule::even_odd>();
+    default:
+      assert(false);
+      return Pixel_box();
+    }
+  }
+
+  void inc_x() noexcept
+  {
+    ++cell_x_;
+  }
+
+  void set_x(Int_32 const x) noexcept
+  {
+    cell_x_ = x;
+  }
+
+  void set_y(Int_32 const y) noexcept
+  {
+    cell_y_ = y;
+  }
+
+  void set_cell(Int_32 const cover, Int_32 const area)
+  {
+    // Cells right of the canvas only affect pixels further right, and
+    // cells left of it only pass their cover on.
+    if(0 > cell_y_ || height_ <= cell_y_ || width_ <= cell_x_)
+    {
+      return;
+    }
+
+    Int_32 const x = 0 > cell_x_ ? -1 : cell_x_;
+    if(!cells_.empty())
+    {
+      auto& cell = cells_.back();
+      if(cell.x == x && cell.y == cell_y_ && cell.style == style_)
+      {
+        cell.cover += cover;
+        cell.area += area;
+        return;
+      }
+    }
+
+    cells_.push_back(Cell_{x, cell_y_, style_, cover, area});
+  }
+
+private:
+  using Unt_8_ = ::std::uint8_t;
+  using Unt_32_ = ::std::uint32_t;
+  using Int_64_ = ::std::int64_t;
+  using Overflow_error_ = ::std::overflow_error;
+
+  template<class T>
+  using Vector_ = ::std::vector<T>;
+
+  template<class T, class = void>
+  struct Has_blend_solid_ : ::std::false_type
+  {};
+
+  template<class T>
+  struct Has_blend_solid_<
+    T,
+    decltype(void(::std::declval<T&>().blend_solid(
+      ::std::declval<Unt_8_>(), ::std::declval<Size>())))> :
+    ::std::true_type
+  {};
+
+  static Int_32 constexpr cell_area_ = 0x20000;
+
+  // Area of one subpixel row across a cell. Two outlines that share an
+  // edge are rasterized on their own and may leave this much of a pixel
+  // on the edge uncovered between them.
+  static Int_32 constexpr seam_area_ = cell_area_ >> 8u;
+
+  struct Cell_
+  {
+    Int_32 x;
+    Int_32 y;
+    Unt_32_ style;
+    Int_32 cover;
+    Int_32 area;
+  };
+
+  // Covered area of a style at a pixel, later replaced by the coverage
+  // to blend it with.
+  struct Layer_
+  {
+    Unt_32_ style;
+    Int_32 coverage;
+  };
+
+  void sort_cells_()
+  {
+    ::std::sort(
+      cells_.begin(), cells_.end(),
+      [](Cell_ const& a, Cell_ const& b) noexcept
+      {
+        return a.y < b.y || (a.y == b.y && (a.x < b.x ||
+          (a.x == b.x && a.style < b.style)));
+      });
+
+    auto dst = cells_.begin();
+    auto src = cells_.begin();
+    auto const cells_end = cells_.end();
+
+    while(cells_end != src)
+    {
+      Cell_ cell = *src;
+      while(
+        cells_end != ++src &&
+        src->y == cell.y &&
+        src->x == cell.x &&
+        src->style == cell.style)
+      {
+        cell.cover += src->cover;
+        cell.area += src->area;
+      }
+
+      if(0 != cell.cover || 0 != cell.area)
+      {
+        *dst = cell;
+        ++dst;
+      }
+    }
+
+    cells_.erase(dst, cells_end);
+  }
+
+  template<Fill_rule fill_rule>
+  void resolve_(Pixel_box& box)
+  {
+    style_covers_.assign(styles_.size(), 0);
+    style_rows_.assign(styles_.size(), -1);
+
+    auto cell = cells_.cbegin();
+    auto const cells_end = cells_.cend();
+
+    while(cells_end != cell)
+    {
+      Int_32 const y = cell->y;
+      Int_32 x = cell->x;
+      Int_32 blended_x_min = 0;
+      Int_32 blended_x_max = -1;
+      active_.clear();
+
+      for(;;)
+      {
+        bool const row_end = cells_end == cell || y != cell->y;
+        Int_32 const next_x = row_end ? width_ : cell->x;
+
+        // Between cells every active style keeps its coverage.
+        if(!active_.empty() && x < next_x)
+        {
+          layers_.clear();
+          for(auto const style : active_)
+          {
+            layers_.push_back(
+              Layer_{
+                style,
+                Util::compute_cell_area<fill_rule>(
+                  style_covers_[style], 0)});
+          }
+
+          if(share_layers_())
+          {
+            blend_span_(y, x, next_x);
+            if(0 > blended_x_max)
+            {
+              blended_x_min = x;
+            }
+            blended_x_max = next_x - 1;
+          }
+        }
+
+        if(row_end)
+        {
+          break;
+        }
+
+        // Merge the active styles with the styles of the cells at x; both
+        // are sorted by style.
+        x = next_x;
+        layers_.clear();
+        next_active_.clear();
+        auto active = active_.cbegin();
+        auto const active_end = active_.cend();
+
+        for(;;)
+        {
+          bool const has_cell =
+            cells_end != cell && y == cell->y && x == cell->x;
+          bool const has_active = active_end != active;
+          if(!has_cell && !has_active)
+          {
+            break;
+          }
+
+          Unt_32_ style;
+          Int_32 area = 0;
+          if(has_cell && (!has_active || cell->style <= *active))
+          {
+            style = cell->style;
+            style_covers_[style] += cell->cover;
+            area = cell->area;
+            if(has_active && *active == style)
+            {
+              ++active;
+            }
+            ++cell;
+          }
+          else
+          {
+            style = *active;
+            ++active;
+          }
+
+          Int_32 const cover = style_covers_[style];
+          if(0 != cover)
+          {
+            next_active_.push_back(style);
+          }
+          layers_.push_back(
+            Layer_{
+              style,
+              Util::compute_cell_area<fill_rule>(cover, area)});
+        }
+
+        active_.swap(next_active_);
+
+        if(0 <= x)
+        {
+          if(share_layers_())
+          {
+            blend_span_(y, x, x + 1);
+            if(0 > blended_x_max)
+            {
+              blended_x_min = x;
+            }
+            blended_x_max = x;
+          }
+        }
+
+        ++x;
+      }
+
+      // Rows end with zero cover for closed outlines, but not when the
+      // outlines reach past the right edge of the canvas.
+      for(auto const style : active_)
+      {
+        style_covers_[style] = 0;
+      }
+
+      if(0 <= blended_x_max)
+      {
+        box.add_row(y, blended_x_min, blended_x_max);
+      }
+    }
+  }
+
+  // Turns the areas of layers_ into the coverage to blend every layer
+  // with and drops the layers that do not show. Returns false if none
+  // does.
+  [[nodiscard]] bool share_layers_() noexcept
+  {
+    Int_32 remaining = cell_area_;
+    for(Size i = layers_.size(); 0u < i;)
+    {
+      auto& share = layers_[--i].coverage;
+      if(remaining < share)
+      {
+        share = remaining;
+      }
+      remaining -= share;
+    }
+
+    // Up to seam_area_ left by several styles at a pixel is the rounding
+    // of an edge they share; the pixel is covered completely. It is less
+    // than a coverage level, so outer edges do not change visibly.
+    if(1u < layers_.size() && seam_area_ >= remaining)
+    {
+      remaining = 0;
+    }
+
+    // Blending share s over what is below replaces s / total of it, where
+    // total counts the background left and the shares blended so far. A
+    // share too small to blend is left out of total, so that the shares
+    // above it still replace all of the background. A single layer is
+    // blended exactly as Renderer would blend it.
+    Int_32 total = remaining;
+    Size count = 0u;
+    for(auto const& layer : layers_)
+    {
+      if(0 < layer.coverage)
+      {
+        Int_32 const next_total = total + layer.coverage;
+        auto const share = static_cast<Int_32>(
+          static_cast<Int_64_>(layer.coverage) * cell_area_ / next_total);
+        Int_32 const coverage = Util::cell_area_to_coverage(share);
+        if(0 < coverage)
+        {
+          layers_[count++] = Layer_{layer.style, coverage};
+          total = next_total;
+        }
+      }
+    }
+
+    layers_.resize(count);
+    return 0u < count;
+  }
+
+  void blend_span_(Int_32 const y, Int_32 const x, Int_32 const x_end)
+  {
+    for(auto const& layer : layers_)
+    {
+      auto& blender = styles_[layer.style];
+      auto& row = style_rows_[layer.style];
+      if(y != row)
+      {
+        blender.set_y(y);
+        row = y;
+      }
+
+      auto const coverage = static_cast<Unt_8_>(layer.coverage);
+      blender.set_x(x);
+      if constexpr(Has_blend_solid_<Blender>::value)
+      {
+        blender.blend_solid(coverage, static_cast<Size>(x_end - x));
+      }
+      else
+      {
+        for(Int_32 i = x;;)
+        {
+          blender.blend(coverage);
+          if(x_end > ++i)
+          {
+            blender.inc_x();
+          }
+          else
+          {
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  Rasterizer rasterizer_;
+  Vector_<Blender> styles_;
+  Vector_<Cell_> cells_;
+  Vector_<Int_32> style_covers_;
+  Vector_<Int_32> style_rows_;
+  Vector_<Unt_32_> active_;
+  Vector_<Unt_32_> next_active_;
+  Vector_<Layer_> layers_;
+  Int_32 width_;
+  Int_32 height_;
+  Unt_32_ style_;
+  Int_32 cell_x_;
+  Int_32 cell_y_;
+  float x_0_;
+  float y_0_;
+  float x_;
+  float y_;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_COMPOUNDRENDERER_HH
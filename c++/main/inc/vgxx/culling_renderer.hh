@@ -0,0 +1,635 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_CULLINGRENDERER_HH
+#define VGXX_CULLINGRENDERER_HH
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <vgxx/cell_processor.hh>
+#include <vgxx/display_list.hh>
+#include <vgxx/pixel_box.hh>
+#include <vgxx/rasterizer.hh>
+
+namespace vgxx
+{
+
+struct Culling_stats
+{
+  using Size = ::std::size_t;
+
+  // Share of the covered pixels of rasterized commands that were hidden
+  // by opaque commands in front of them.
+  [[nodiscard]] double culled_fraction() const noexcept
+  {
+    Size const total = blended_pixels + culled_pixels;
+    return 0u < total ?
+      static_cast<double>(culled_pixels) / static_cast<double>(total) :
+      0.;
+  }
+
+  Size blended_pixels = 0u;
+  Size culled_pixels = 0u;
+
+  // Commands skipped without rasterizing, as their bounds were hidden.
+  Size culled_commands = 0u;
+};
+
+// Renders display lists, skipping the pixels that opaque commands later in
+// the list paint over. The commands are first rasterized front to back,
+// keeping for every row the spans fully covered by opaque commands so far;
+// the runs of coverage the cell processor hands over are cut against those
+// spans and only their visible parts are kept. Runs of the same coverage
+// are kept as one value, so the memory follows the edges of the commands
+// rather than their area. The kept runs are then blended back to front,
+// with blend_solid() and blend_span() where the blender has them. A
+// command is opaque if its blender has is_opaque() and it returns true.
+// The output is bit-identical to filling the commands one by one.
+template<class B, class P = Cell_processor>
+struct Culling_renderer
+{
+  using Blender = B;
+  using Cell_processor = P;
+  using Coord = typename Cell_processor::Coord;
+  using Int_32 = ::std::int32_t;
+  using Size = ::std::size_t;
+
+  explicit Culling_renderer(Coord const width, Coord const height) :
+    cell_proc_(width, height)
+  {
+    assert(0u < width);
+    assert(0u < height);
+  }
+
+  [[nodiscard]] Coord width() const noexcept
+  {
+    return cell_proc_.width();
+  }
+
+  [[nodiscard]] Coord height() const noexcept
+  {
+    return cell_proc_.height();
+  }
+
+  void resize(Coord const width, Coord const height)
+  {
+    assert(0u < width);
+    assert(0u < height);
+
+    cell_proc_.resize(width, height);
+  }
+
+  // Statistics of the latest render().
+  [[nodiscard]] Culling_stats const& stats() const noexcept
+  {
+    return stats_;
+  }
+
+  // Renders the commands of the list in order and returns the bounds of
+  // the pixels that have been blended.
+  Pixel_box render(Display_list<Blender> const& list)
+  {
+    stats_ = Culling_stats();
+    Int_32 const height = static_cast<Int_32>(cell_proc_.height());
+    occluded_.resize(static_cast<Size>(height));
+    for(auto& spans : occluded_)
+    {
+      spans.clear();
+    }
+    runs_.clear();
+    coverage_.clear();
+    command_runs_.assign(list.size(), Command_runs_{0u, 0u});
+
+    for(Size k = list.size(); 0u < k;)
+    {
+      --k;
+      collect_(list[k], command_runs_[k]);
+    }
+
+    Pixel_box box;
+    for(Size k = 0u; list.size() > k; ++k)
+    {
+      Blender blender(list[k].blender);
+      auto const& command_runs = command_runs_[k];
+
+      for(Size i = command_runs.begin; command_runs.end > i; ++i)
+      {
+        auto const& run = runs_[i];
+        blender.set_y(run.y);
+        blender.set_x(run.x);
+        if(0u < run.solid)
+        {
+          blend_solid_(blender, run.solid, static_cast<Size>(run.length));
+        }
+        else
+        {
+          blend_span_(
+            blender,
+            coverage_.data() + run.coverage,
+            static_cast<Size>(run.length));
+        }
+
+        box.add_row(run.y, run.x, run.x + run.length - 1);
+      }
+    }
+
+    return box;
+  }
+
+private:
+  using Unt_8_ = ::std::uint8_t;
+
+  template<class T>
+  using Vector_ = ::std::vector<T>;
+
+  template<class T, class = void>
+  struct Opacity_
+  {
+    [[nodiscard]] static bool is_opaque(T const&) noexcept
+    {
+      return false;
+    }
+  };
+
+  template<class T>
+  struct Opacity_<T, decltype(void(::std::declval<T const&>().is_opaque()))>
+  {
+    [[nodiscard]] static bool is_opaque(T const& blender) noexcept
+    {
+      return blender.is_opaque();
+    }
+  };
+
+  template<class T, class = void>
+  struct Has_blend_solid_ : ::std::false_type
+  {};
+
+  template<class T>
+  struct Has_blend_solid_<
+    T,
+    decltype(void(::std::declval<T&>().blend_solid(
+      ::std::declval<Unt_8_>(), ::std::declval<Size>())))> :
+    ::std::true_type
+  {};
+
+  template<class T, class = void>
+  struct Has_blend_span_ : ::std::false_type
+  {};
+
+  template<class T>
+  struct Has_blend_span_<
+    T,
+    decltype(void(::std::declval<T&>().blend_span(
+      ::std::declval<Unt_8_ const*>(), ::std::declval<Size>())))> :
+    ::std::true_type
+  {};
+
+  // Blends count pixels from the current one, all with the same coverage.
+  static void blend_solid_(
+    Blender& blender,
+    Unt_8_ const coverage,
+    Size count)
+  {
+    if constexpr(Has_blend_solid_<Blender>::value)
+    {
+      blender.blend_solid(coverage, count);
+    }
+    else
+    {
+      for(;;)
+      {
+        blender.blend(coverage);
+        if(0u < --count)
+        {
+          blender.inc_x();
+        }
+        else
+        {
+          break;
+        }
+      }
+    }
+  }
+
+  // Blends count pixels from the current one, with a coverage each.
+  static void blend_span_(
+    Blender& blender,
+    Unt_8_ const* coverage,
+    Size count)
+  {
+    if constexpr(Has_blend_span_<Blender>::value)
+    {
+      if(1u < count)
+      {
+        blender.blend_span(coverage, count);
+        return;
+      }
+    }
+
+    for(;;)
+    {
+      blender.blend(*coverage);
+      if(0u < --count)
+      {
+        ++coverage;
+        blender.inc_x();
+      }
+      else
+      {
+        break;
+      }
+    }
+  }
+
+  // Inclusive range of pixels in a row.
+  struct Span_
+  {
+    Int_32 x_min;
+    Int_32 x_max;
+  };
+
+  // Kept coverage of consecutive pixels: solid for all of them, or if
+  // that is 0, one value per pixel from coverage_[coverage].
+  struct Run_
+  {
+    Int_32 y;
+    Int_32 x;
+    Int_32 length;
+    Unt_8_ solid;
+    Size coverage;
+  };
+
+  struct Command_runs_
+  {
+    Size begin;
+    Size end;
+  };
+
+  struct Opaque_span_
+  {
+    Int_32 y;
+    Span_ span;
+  };
+
+  // Stands in for the blender while a command is swiped front to back.
+  // Cuts the runs it is handed against the hidden spans of the row, keeps
+  // the visible parts and notes the pixels the command hides itself.
+  struct Collector_
+  {
+    explicit Collector_(Culling_renderer& renderer, bool const opaque) :
+      renderer_(renderer),
+      run_begin_(renderer.runs_.size()),
+      spans_(nullptr),
+      span_(nullptr),
+      spans_end_(nullptr),
+      x_(0),
+      y_(0),
+      opaque_(opaque)
+    {}
+
+    template<class X>
+    void set_x(X const& x) noexcept
+    {
+      // Runs come in increasing x within a row, so the span search only
+      // starts over when x goes back.
+      Int_32 const new_x = static_cast<Int_32>(x);
+      if(new_x < x_)
+      {
+        span_ = spans_;
+      }
+      x_ = new_x;
+    }
+
+    template<class Y>
+    void set_y(Y const& y) noexcept
+    {
+      y_ = static_cast<Int_32>(y);
+      select_row_();
+    }
+
+    void inc_x() noexcept
+    {
+      ++x_;
+    }
+
+    void inc_y() noexcept
+    {
+      ++y_;
+      select_row_();
+    }
+
+    void blend(Unt_8_ const coverage)
+    {
+      blend_solid(coverage, 1u);
+    }
+
+    void blend_solid(Unt_8_ const coverage, Size const count)
+    {
+      Int_32 const x_end = x_ + static_cast<Int_32>(count);
+      if(opaque_ && 0xffu == coverage)
+      {
+        add_opaque_(x_, x_end);
+      }
+
+      for_visible_(x_end, [&](Int_32 const x, Int_32 const length)
+        {
+          keep_solid_(x, length, coverage);
+        });
+    }
+
+    void blend_span(Unt_8_ const* const coverage, Size const count)
+    {
+      Int_32 const x_begin = x_;
+      Int_32 const x_end = x_ + static_cast<Int_32>(count);
+      if(opaque_)
+      {
+        for(Int_32 x = x_begin; x_end > x;)
+        {
+          if(0xffu == coverage[x - x_begin])
+          {
+            Int_32 const opaque_begin = x;
+            while(x_end > ++x && 0xffu == coverage[x - x_begin])
+            {}
+            add_opaque_(opaque_begin, x);
+          }
+          else
+          {
+            ++x;
+          }
+        }
+      }
+
+      for_visible_(x_end, [&](Int_32 const x, Int_32 const length)
+        {
+          keep_span_(x, length, coverage + (x - x_begin));
+        });
+    }
+
+  private:
+    void select_row_() noexcept
+    {
+      auto const& spans = renderer_.occluded_[static_cast<Size>(y_)];
+      spans_ = spans.data();
+      span_ = spans_;
+      spans_end_ = spans_ + spans.size();
+    }
+
+    // Calls keep(x, length) for the parts of the pixels from x_ to x_end
+    // not inside a hidden span, and moves x_ to x_end.
+    template<class Keep>
+    void for_visible_(Int_32 const x_end, Keep const& keep)
+    {
+      auto& stats = renderer_.stats_;
+      Int_32 x = x_;
+      while(x_end > x)
+      {
+        while(spans_end_ != span_ && span_->x_max < x)
+        {
+          ++span_;
+        }
+
+        if(spans_end_ != span_ && span_->x_min <= x)
+        {
+          Int_32 const hidden_end =
+            span_->x_max < x_end ? span_->x_max + 1 : x_end;
+          stats.culled_pixels += static_cast<Size>(hidden_end - x);
+          x = hidden_end;
+          continue;
+        }
+
+        Int_32 const visible_end =
+          spans_end_ != span_ && span_->x_min < x_end ? span_->x_min : x_end;
+        stats.blended_pixels += static_cast<Size>(visible_end - x);
+        keep(x, visible_end - x);
+        x = visible_end;
+      }
+
+      x_ = x_end;
+    }
+
+    void keep_solid_(Int_32 const x, Int_32 const length, Unt_8_ const solid)
+    {
+      renderer_.runs_.push_back(Run_{y_, x, length, solid, 0u});
+    }
+
+    void keep_span_(
+      Int_32 const x,
+      Int_32 const length,
+      Unt_8_ const* const coverage)
+    {
+      auto& runs = renderer_.runs_;
+      auto& kept = renderer_.coverage_;
+      if(
+        runs.size() > run_begin_ &&
+        0u == runs.back().solid &&
+        runs.back().y == y_ &&
+        runs.back().x + runs.back().length == x)
+      {
+        runs.back().length += length;
+      }
+      else
+      {
+        runs.push_back(Run_{y_, x, length, 0u, kept.size()});
+      }
+      kept.insert(kept.end(), coverage, coverage + length);
+    }
+
+    // Notes that the command hides the pixels from x_begin to x_end.
+    void add_opaque_(Int_32 const x_begin, Int_32 const x_end)
+    {
+      auto& opaque_spans = renderer_.opaque_spans_;
+      if(
+        !opaque_spans.empty() &&
+        opaque_spans.back().y == y_ &&
+        opaque_spans.back().span.x_max + 1 == x_begin)
+      {
+        opaque_spans.back().span.x_max = x_end - 1;
+      }
+      else
+      {
+        opaque_spans.push_back(Opaque_span_{y_, Span_{x_begin, x_end - 1}});
+      }
+    }
+
+    Culling_renderer& renderer_;
+    Size run_begin_;
+    Span_ const* spans_;
+    Span_ const* span_;
+    Span_ const* spans_end_;
+    Int_32 x_;
+    Int_32 y_;
+    bool opaque_;
+  };
+
+  void collect_(
+    typename Display_list<Blender>::Command const& command,
+    Command_runs_& command_runs)
+  {
+    command_runs.begin = runs_.size();
+    command_runs.end = runs_.size();
+
+    auto const& segments = command.segments;
+    Int_32 const width = static_cast<Int_32>(cell_proc_.width());
+    Int_32 const height = static_cast<Int_32>(cell_proc_.height());
+    Int_32 x_min = segments.column_min();
+    Int_32 x_max = segments.column_max();
+    Int_32 y_min = segments.row_min();
+    Int_32 y_max = segments.row_max();
+    if(0 > x_min)
+    {
+      x_min = 0;
+    }
+    if(width <= x_max)
+    {
+      x_max = width - 1;
+    }
+    if(0 > y_min)
+    {
+      y_min = 0;
+    }
+    if(height <= y_max)
+    {
+      y_max = height - 1;
+    }
+    if(x_min > x_max || y_min > y_max)
+    {
+      return;
+    }
+
+    // Narrow the rows down to those not hidden across the whole bounds.
+    while(y_min <= y_max && hidden_(y_min, x_min, x_max))
+    {
+      ++y_min;
+    }
+    while(y_min <= y_max && hidden_(y_max, x_min, x_max))
+    {
+      --y_max;
+    }
+    if(y_min > y_max)
+    {
+      ++stats_.culled_commands;
+      return;
+    }
+
+    segments.rasterize(rasterizer_, cell_proc_, 0, 0, y_min, y_max);
+
+    Collector_ collector(*this, Opacity_<Blender>::is_opaque(command.blender));
+    opaque_spans_.clear();
+    cell_proc_.swipe(collector, command.fill_rule);
+    command_runs.end = runs_.size();
+
+    // Spans come in row order, sorted by x within a row.
+    auto span = opaque_spans_.cbegin();
+    auto const spans_end = opaque_spans_.cend();
+    while(spans_end != span)
+    {
+      auto next = span + 1;
+      while(spans_end != next && next->y == span->y)
+      {
+        ++next;
+      }
+      occlude_(span, next);
+      span = next;
+    }
+  }
+
+  [[nodiscard]] bool hidden_(
+    Int_32 const y,
+    Int_32 const x_min,
+    Int_32 const x_max) const noexcept
+  {
+    for(auto const& span : occluded_[static_cast<Size>(y)])
+    {
+      if(span.x_max >= x_min)
+      {
+        return span.x_min <= x_min && span.x_max >= x_max;
+      }
+    }
+
+    return false;
+  }
+
+  // Merges the opaque spans of one row into its occluded spans.
+  template<class It>
+  void occlude_(It span, It const spans_end)
+  {
+    auto& occluded = occluded_[static_cast<Size>(span->y)];
+    merged_.clear();
+    auto old_span = occluded.cbegin();
+    auto const old_spans_end = occluded.cend();
+
+    for(;;)
+    {
+      Span_ next;
+      if(
+        old_spans_end != old_span &&
+        (spans_end == span || old_span->x_min < span->span.x_min))
+      {
+        next = *old_span++;
+      }
+      else if(spans_end != span)
+      {
+        next = span->span;
+        ++span;
+      }
+      else
+      {
+        break;
+      }
+
+      if(!merged_.empty() && merged_.back().x_max + 1 >= next.x_min)
+      {
+        if(merged_.back().x_max < next.x_max)
+        {
+          merged_.back().x_max = next.x_max;
+        }
+      }
+      else
+      {
+        merged_.push_back(next);
+      }
+    }
+
+    occluded.swap(merged_);
+  }
+
+  Cell_processor cell_proc_;
+  Rasterizer rasterizer_;
+  Vector_<Vector_<Span_>> occluded_;
+  Vector_<Span_> merged_;
+  Vector_<Opaque_span_> opaque_spans_;
+  Vector_<Run_> runs_;
+  Vector_<Unt_8_> coverage_;
+  Vector_<Command_runs_> command_runs_;
+  Culling_stats stats_;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_CULLINGRENDERER_HH
@@ -0,0 +1,176 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_DAMAGETRACKER_HH
+#define VGXX_DAMAGETRACKER_HH
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <vgxx/pixel_box.hh>
+
+namespace vgxx
+{
+
+// Accumulates the pixels touched by fills across a frame: the overall
+// bounding box and, for every band of band_height rows, the extent of
+// the touched columns. Callers upload or copy only those regions.
+struct Damage_tracker
+{
+  using Int_32 = ::std::int32_t;
+  using Size = ::std::size_t;
+
+  explicit Damage_tracker(Int_32 const band_height = 16) :
+    band_height_(band_height)
+  {
+    assert(0 < band_height);
+  }
+
+  [[nodiscard]] Int_32 band_height() const noexcept
+  {
+    return band_height_;
+  }
+
+  [[nodiscard]] Pixel_box const& bounds() const noexcept
+  {
+    return bounds_;
+  }
+
+  // Number of bands up to the last damaged one.
+  [[nodiscard]] Size band_count() const noexcept
+  {
+    return bands_.size();
+  }
+
+  // Damaged part of band i, or an empty box if the band is clean.
+  [[nodiscard]] Pixel_box band(Size const i) const noexcept
+  {
+    assert(bands_.size() > i);
+    auto const& band = bands_[i];
+    Pixel_box box;
+
+    if(band.x_min <= band.x_max)
+    {
+      Int_32 const y_min = static_cast<Int_32>(i) * band_height_;
+      Int_32 y_max = y_min + band_height_ - 1;
+      if(bounds_.y_max < y_max)
+      {
+        y_max = bounds_.y_max;
+      }
+
+      box = Pixel_box(
+        band.x_min,
+        bounds_.y_min > y_min ? bounds_.y_min : y_min,
+        band.x_max,
+        y_max);
+    }
+
+    return box;
+  }
+
+  void add_row(Int_32 const y, Int_32 const x_min, Int_32 const x_max)
+  {
+    assert(0 <= y);
+    bounds_.add_row(y, x_min, x_max);
+    band_(y).add(x_min, x_max);
+  }
+
+  void add(Pixel_box const& box)
+  {
+    if(box)
+    {
+      assert(0 <= box.y_min);
+      bounds_.unite(box);
+
+      Size const band_max = static_cast<Size>(box.y_max / band_height_);
+      for(auto i = static_cast<Size>(box.y_min / band_height_);;)
+      {
+        band_at_(i).add(box.x_min, box.x_max);
+        if(band_max > i)
+        {
+          ++i;
+        }
+        else
+        {
+          break;
+        }
+      }
+    }
+  }
+
+  // Starts a new frame, keeping the band storage.
+  void clear() noexcept
+  {
+    bounds_.reset();
+    bands_.clear();
+  }
+
+private:
+  template<class T>
+  using Vector_ = ::std::vector<T>;
+
+  struct Band_
+  {
+    void add(Int_32 const row_x_min, Int_32 const row_x_max) noexcept
+    {
+      if(row_x_min < x_min)
+      {
+        x_min = row_x_min;
+      }
+      if(row_x_max > x_max)
+      {
+        x_max = row_x_max;
+      }
+    }
+
+    Int_32 x_min;
+    Int_32 x_max;
+  };
+
+  [[nodiscard]] Band_& band_(Int_32 const y)
+  {
+    return band_at_(static_cast<Size>(y / band_height_));
+  }
+
+  [[nodiscard]] Band_& band_at_(Size const i)
+  {
+    if(bands_.size() <= i)
+    {
+      Pixel_box const empty;
+      bands_.resize(i + 1u, Band_{empty.x_min, empty.x_max});
+    }
+
+    return bands_[i];
+  }
+
+  Vector_<Band_> bands_;
+  Pixel_box bounds_;
+  Int_32 const band_height_;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_DAMAGETRACKER_HH
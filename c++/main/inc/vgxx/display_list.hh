@@ -0,0 +1,177 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_DISPLAYLIST_HH
+#define VGXX_DISPLAYLIST_HH
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include <vgxx/fill_rule.hh>
+#include <vgxx/segment_list.hh>
+
+namespace vgxx
+{
+
+// Retained list of fill commands. Takes the same path commands as
+// Renderer, but fill() records the flattened outline together with a copy
+// of the current blender and the fill rule instead of drawing anything.
+// The list can be rendered any number of times, e.g. by Tile_renderer.
+template<class B>
+struct Display_list
+{
+  using Blender = B;
+  using Size = ::std::size_t;
+
+  struct Command
+  {
+    Segment_list segments;
+    Blender blender;
+    Fill_rule fill_rule;
+  };
+
+private:
+  template<class T, class... Args>
+  using Is_constructible_ = typename ::std::is_constructible<T, Args...>::type;
+
+  template<bool, class = void>
+  struct Enable_if_
+  {};
+
+  template<class T>
+  struct Enable_if_<true, T>
+  {
+    using Type = T;
+  };
+
+public:
+  template<
+    class... Blender_args,
+    bool e = Is_constructible_<Blender, Blender_args&&...>::value,
+    class = typename Enable_if_<e>::Type>
+  explicit Display_list(Blender_args&&... blender_args) :
+    blender_(static_cast<Blender_args&&>(blender_args)...)
+  {}
+
+  // Blender state captured by the next fill.
+  [[nodiscard]] Blender& blender() noexcept
+  {
+    return blender_;
+  }
+
+  [[nodiscard]] Blender const& blender() const noexcept
+  {
+    return blender_;
+  }
+
+  void move_to(float const x, float const y)
+  {
+    segments_.move_to(x, y);
+  }
+
+  void line_to(float const x, float const y)
+  {
+    segments_.line_to(x, y);
+  }
+
+  void bezier_to(
+    float const x_1,
+    float const y_1,
+    float const x_2,
+    float const y_2,
+    float const x_3,
+    float const y_3)
+  {
+    segments_.bezier_to(x_1, y_1, x_2, y_2, x_3, y_3);
+  }
+
+  void close_outline()
+  {
+    segments_.close_outline();
+  }
+
+  // Appends a command filling the current outline. Empty outlines are
+  // dropped.
+  void fill(Fill_rule const fill_rule)
+  {
+    segments_.close_outline();
+    if(!segments_.empty())
+    {
+      commands_.push_back(
+        Command{static_cast<Segment_list&&>(segments_), blender_, fill_rule});
+    }
+    segments_.clear();
+  }
+
+  template<Fill_rule fill_rule>
+  void fill()
+  {
+    fill(fill_rule);
+  }
+
+  // Removes all commands and the current outline.
+  void clear() noexcept
+  {
+    commands_.clear();
+    segments_.clear();
+  }
+
+  [[nodiscard]] bool empty() const noexcept
+  {
+    return commands_.empty();
+  }
+
+  [[nodiscard]] Size size() const noexcept
+  {
+    return commands_.size();
+  }
+
+  [[nodiscard]] Command const& operator [](Size const i) const noexcept
+  {
+    return commands_[i];
+  }
+
+  [[nodiscard]] Command const* begin() const noexcept
+  {
+    return commands_.data();
+  }
+
+  [[nodiscard]] Command const* end() const noexcept
+  {
+    return commands_.data() + commands_.size();
+  }
+
+private:
+  template<class T>
+  using Vector_ = ::std::vector<T>;
+
+  Blender blender_;
+  Segment_list segments_;
+  Vector_<Command> commands_;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_DISPLAYLIST_HH
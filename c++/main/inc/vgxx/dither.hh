@@ -0,0 +1,158 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_DITHER_HH
+#define VGXX_DITHER_HH
+
+#include <cstddef>
+#include <cstdint>
+
+namespace vgxx
+{
+
+// Dithering for blenders that store fewer than 8 bits per channel.
+enum class Dither
+{
+  // Rounds to the nearest level.
+  none = 0,
+
+  // 8x8 Bayer matrix.
+  ordered = 1,
+
+  // 16x16 void-and-cluster blue noise, with less visible structure than
+  // the Bayer pattern.
+  blue_noise = 2
+};
+
+// Rows of dithering thresholds, tiled over the image. A threshold is a
+// bias from 0 to 254 added to v * max before dividing by 255 to quantize
+// an 8-bit value v to max + 1 levels; no dithering is a constant 127.
+//
+// Each row is stored twice in a row, so that any run of period values
+// starting at a column can be read without wrapping.
+template<Dither dither>
+struct Dither_map
+{
+  using Unt_8 = ::std::uint8_t;
+  using Int_32 = ::std::int32_t;
+
+  static unsigned constexpr period = Dither::blue_noise == dither ? 16u : 8u;
+
+  // Thresholds of row y, to be indexed by column & (period - 1); up to
+  // period - 1 more may be read past the indexed one.
+  [[nodiscard]] static Unt_8 const* row(Int_32 const y) noexcept
+  {
+    return table_.values + (static_cast<unsigned>(y) & (period - 1u)) *
+      period * 2u;
+  }
+
+  [[nodiscard]] static Unt_8 bias(Int_32 const x, Int_32 const y) noexcept
+  {
+    return row(y)[static_cast<unsigned>(x) & (period - 1u)];
+  }
+
+private:
+  struct Table_
+  {
+    Unt_8 values[period * period * 2u];
+  };
+
+  static Table_ constexpr make_table_() noexcept
+  {
+    unsigned char constexpr bayer[8][8] =
+    {
+      { 0, 32,  8, 40,  2, 34, 10, 42},
+      {48, 16, 56, 24, 50, 18, 58, 26},
+      {12, 44,  4, 36, 14, 46,  6, 38},
+      {60, 28, 52, 20, 62, 30, 54, 22},
+      { 3, 35, 11, 43,  1, 33,  9, 41},
+      {51, 19, 59, 27, 49, 17, 57, 25},
+      {15, 47,  7, 39, 13, 45,  5, 37},
+      {63, 31, 55, 23, 61, 29, 53, 21}
+    };
+
+    unsigned char constexpr blue_noise[16][16] =
+    {
+      {252, 131,  58,  10, 227, 146, 191,  81,
+        40, 204, 106,  29, 229,  42, 164,  66},
+      { 16, 215,  34, 240,  94,  43, 109, 166,
+        12,  69, 213, 132,  77, 114,  22, 148},
+      { 93, 167, 113, 177,  65, 210, 248, 141,
+       232, 186,  47, 153, 180, 239, 208, 190},
+      { 46,  75, 202, 135, 157,   3, 124,  24,
+        88, 119, 245,  98,   2,  56, 138, 105},
+      {224,   6, 235,  25,  80, 195,  50, 222,
+        60, 161,  17, 194, 218,  82,  35, 246},
+      {121, 145,  54,  97, 254, 181, 102, 172,
+       205,  33, 144,  70, 125, 170, 155, 183},
+      { 28, 192, 168, 129, 217,  37, 150,  74,
+       241, 111, 228,  44, 255, 100,  11,  67},
+      {221, 107, 209,  14,  63, 118,  20, 130,
+         7,  92, 178, 137,  23, 206, 233,  89},
+      {136,  76,  41, 158,  86, 244, 225, 187,
+       156,  55, 214,  79, 189, 116,  51, 162},
+      {250,   1, 238, 185, 203, 140,  48,  99,
+       199,  30, 163,   5,  64, 149,  36, 198},
+      {173,  95,  57, 110,  31, 175,  13,  68,
+       251, 123, 231, 108, 243, 219, 127,  18},
+      {112, 230, 151, 128,  78, 234, 115, 216,
+        84, 142,  45, 169,  96, 182,  83,  61},
+      {212,  27, 188,   8, 211, 165,  38, 152,
+       184,  21,  72, 207,  32,  15, 247, 159},
+      { 73, 139,  49, 249,  90,  59, 133, 103,
+         0, 196, 237, 117, 134,  52, 143, 201},
+      { 39, 226, 104, 171,  19, 200, 242, 223,
+        53,  91, 160,  62, 220, 193, 101,   4},
+      {179,  85, 197, 154, 120,  71,  26, 174,
+       126, 253, 147,   9, 176,  87, 236, 122}
+    };
+
+    Table_ table{};
+    for(unsigned y = 0u; period > y; ++y)
+    {
+      for(unsigned x = 0u; period * 2u > x; ++x)
+      {
+        unsigned bias = 127u;
+        if constexpr(Dither::ordered == dither)
+        {
+          bias = bayer[y][x % period] * 4u + 2u;
+        }
+        else if constexpr(Dither::blue_noise == dither)
+        {
+          bias = blue_noise[y][x % period] * 255u / 256u;
+        }
+
+        table.values[y * period * 2u + x] = static_cast<Unt_8>(bias);
+      }
+    }
+
+    return table;
+  }
+
+  static Table_ constexpr table_ = make_table_();
+};
+
+} // namespace vgxx
+
+#endif // VGXX_DITHER_HH
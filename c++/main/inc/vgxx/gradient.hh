@@ -0,0 +1,220 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_GRADIENT_HH
+#define VGXX_GRADIENT_HH
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vgxx
+{
+
+// What a gradient does past its ends.
+enum class Gradient_spread
+{
+  pad = 0,
+  repeat = 1,
+  reflect = 2
+};
+
+struct Gradient_stop
+{
+  // Position along the gradient, 0 to 1.
+  float offset;
+
+  // 32-bit color with alpha in the top byte, in the channel order of the
+  // target image.
+  ::std::uint32_t color;
+};
+
+// Color ramp of a gradient sampled into a table of n entries, n being a
+// power of two. Gradient blenders look colors up by a fixed-point index
+// with 16 fraction bits, mapped to the table by the spread mode.
+template<::std::size_t n = 256u>
+struct Gradient_ramp
+{
+  using Color = ::std::uint32_t;
+  using Int_64 = ::std::int64_t;
+  using Size = ::std::size_t;
+
+  static_assert(1u < n && 0u == (n & (n - 1u)));
+
+  static Size constexpr size = n;
+
+  // Fixed-point index of a gradient position, t = 1 being n.
+  static Int_64 constexpr one = static_cast<Int_64>(n) << 16u;
+
+  // All entries transparent.
+  Gradient_ramp() noexcept
+  {
+    ::std::fill(colors_, colors_ + n, Color{0u});
+  }
+
+  // Stops need not be sorted. Before the first stop and after the last
+  // one the ramp keeps their colors.
+  Gradient_ramp(Gradient_stop const* const stops, Size const stop_count)
+  {
+    set_stops(stops, stop_count);
+  }
+
+  void set_stops(Gradient_stop const* const stops, Size const stop_count)
+  {
+    if(0u == stop_count)
+    {
+      ::std::fill(colors_, colors_ + n, Color{0u});
+      opaque_ = false;
+      return;
+    }
+
+    Vector_<Gradient_stop> sorted(stops, stops + stop_count);
+    ::std::stable_sort(
+      sorted.begin(), sorted.end(),
+      [](Gradient_stop const& a, Gradient_stop const& b) noexcept
+      {
+        return a.offset < b.offset;
+      });
+
+    opaque_ = true;
+    for(auto const& stop : sorted)
+    {
+      opaque_ = opaque_ && 0xffu == stop.color >> 24u;
+    }
+
+    Size k = 0u;
+    for(Size i = 0u; n > i; ++i)
+    {
+      float const t = (static_cast<float>(i) + 0.5f) / static_cast<float>(n);
+      while(sorted.size() > k && sorted[k].offset <= t)
+      {
+        ++k;
+      }
+
+      if(0u == k)
+      {
+        colors_[i] = sorted.front().color;
+      }
+      else if(sorted.size() == k)
+      {
+        colors_[i] = sorted.back().color;
+      }
+      else
+      {
+        auto const& a = sorted[k - 1u];
+        auto const& b = sorted[k];
+        colors_[i] = mix_(
+          a.color, b.color, (t - a.offset) / (b.offset - a.offset));
+      }
+    }
+  }
+
+  // True if every color of the ramp is opaque.
+  [[nodiscard]] bool is_opaque() const noexcept
+  {
+    return opaque_;
+  }
+
+  [[nodiscard]] Color operator [](Size const i) const noexcept
+  {
+    assert(n > i);
+    return colors_[i];
+  }
+
+  [[nodiscard]] Color const* data() const noexcept
+  {
+    return colors_;
+  }
+
+  // Color at a fixed-point index. Compiles to a few integer operations
+  // without branches for each spread mode.
+  template<Gradient_spread spread>
+  [[nodiscard]] Color at(Int_64 const index) const noexcept
+  {
+    return colors_[table_index<spread>(index)];
+  }
+
+  template<Gradient_spread spread>
+  [[nodiscard]] static Size table_index(Int_64 index) noexcept
+  {
+    index >>= 16u;
+    if constexpr(Gradient_spread::pad == spread)
+    {
+      index = index < 0 ? 0 : index;
+      index = index > mask_ ? mask_ : index;
+      return static_cast<Size>(index);
+    }
+    else if constexpr(Gradient_spread::repeat == spread)
+    {
+      return static_cast<Size>(index & mask_);
+    }
+    else
+    {
+      // Odd periods run backwards.
+      Int_64 const flip = -((index >> shift_) & 1);
+      return static_cast<Size>((index ^ flip) & mask_);
+    }
+  }
+
+private:
+  template<class T>
+  using Vector_ = ::std::vector<T>;
+
+  static Int_64 constexpr mask_ = static_cast<Int_64>(n - 1u);
+
+  static unsigned constexpr shift_ = []() constexpr
+    {
+      unsigned s = 0u;
+      while((Size{1u} << s) < n)
+      {
+        ++s;
+      }
+      return s;
+    }();
+
+  [[nodiscard]] static Color mix_(
+    Color const a,
+    Color const b,
+    float const t) noexcept
+  {
+    Color color = 0u;
+    for(unsigned shift = 0u; 32u > shift; shift += 8u)
+    {
+      auto const ca = static_cast<float>((a >> shift) & 0xffu);
+      auto const cb = static_cast<float>((b >> shift) & 0xffu);
+      color |= static_cast<Color>(ca + (cb - ca) * t + 0.5f) << shift;
+    }
+
+    return color;
+  }
+
+  Color colors_[n];
+  bool opaque_ = false;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_GRADIENT_HH
@@ -0,0 +1,368 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_GRADIENTBLENDER8888_HH
+#define VGXX_GRADIENTBLENDER8888_HH
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <vgxx/blend_8888.hh>
+#include <vgxx/blender_base.hh>
+#include <vgxx/gradient.hh>
+
+namespace vgxx
+{
+
+// Fills with a linear gradient over 32-bit RGBA or BGRA images; the ramp
+// colors must be in the channel order of the image. The gradient position
+// is kept as a fixed-point ramp index that moves by a constant step per
+// pixel and per row, so a pixel costs one addition and a table lookup.
+//
+// The ramp is not owned and must outlive the blender, like the image.
+template<Gradient_spread spread, ::std::size_t n = 256u>
+struct Linear_gradient_blender_8888 : Blender_base<::std::uint32_t>
+{
+private:
+  using Unt_8_ = ::std::uint8_t;
+  using Unt_32_ = ::std::uint32_t;
+  using Int_64_ = ::std::int64_t;
+  using Base_ = Blender_base<Color>;
+
+public:
+  using Ramp = Gradient_ramp<n>;
+
+  using Base_::Base_;
+
+  [[nodiscard]] Ramp const* ramp() const noexcept
+  {
+    return ramp_;
+  }
+
+  void set_ramp(Ramp const& ramp) noexcept
+  {
+    ramp_ = &ramp;
+  }
+
+  // The gradient runs from position 0 at (x_0, y_0) to position 1 at
+  // (x_1, y_1), in pixel coordinates. Coincident points give position 0
+  // everywhere.
+  void set_points(
+    double const x_0,
+    double const y_0,
+    double const x_1,
+    double const y_1) noexcept
+  {
+    double const dx = x_1 - x_0;
+    double const dy = y_1 - y_0;
+    double const length_2 = dx * dx + dy * dy;
+    if(0.0 >= length_2)
+    {
+      step_x_ = 0;
+      step_y_ = 0;
+      origin_ = 0;
+      return;
+    }
+
+    // Positions are taken at pixel centers.
+    double const scale = static_cast<double>(Ramp::one) / length_2;
+    step_x_ = static_cast<Int_64_>(::std::llround(dx * scale));
+    step_y_ = static_cast<Int_64_>(::std::llround(dy * scale));
+    origin_ = static_cast<Int_64_>(::std::llround(
+      ((0.5 - x_0) * dx + (0.5 - y_0) * dy) * scale));
+  }
+
+  [[nodiscard]] bool is_opaque() const noexcept
+  {
+    return ramp_ && ramp_->is_opaque();
+  }
+
+  template<class X>
+  void set_x(X const& x) noexcept
+  {
+    Base_::set_x(x);
+    index_ = row_index_ + step_x_ * static_cast<Int_64_>(x);
+  }
+
+  template<class Y>
+  void set_y(Y const& y) noexcept
+  {
+    Base_::set_y(y);
+    row_index_ = origin_ + step_y_ * static_cast<Int_64_>(y);
+  }
+
+  void inc_x() noexcept
+  {
+    Base_::inc_x();
+    index_ += step_x_;
+  }
+
+  void inc_y() noexcept
+  {
+    Base_::inc_y();
+    row_index_ += step_y_;
+  }
+
+  void blend(Color const alpha) const noexcept
+  {
+    Color* const dst_color = pixel();
+    assert(dst_color && ramp_);
+    Blend_8888::blend_pixel(
+      *dst_color, ramp_->template at<spread>(index_), alpha);
+  }
+
+  // Blends count pixels starting at the current one, each with its own
+  // coverage.
+  void blend_span(
+    Unt_8_ const* const coverage,
+    Size const count) const noexcept
+  {
+    blend_<true>(coverage, 0u, count);
+  }
+
+  // Blends count pixels starting at the current one, all with the same
+  // coverage.
+  void blend_solid(Unt_8_ const coverage, Size const count) const noexcept
+  {
+    if(0u < coverage)
+    {
+      blend_<false>(nullptr, coverage, count);
+    }
+  }
+
+private:
+  // Colors looked up per call of the span kernel.
+  static Size constexpr chunk_size_ = 64u;
+
+  template<bool coverage_span>
+  void blend_(
+    Unt_8_ const* coverage,
+    Unt_32_ const solid_coverage,
+    Size count) const noexcept
+  {
+    Color* dst = pixel();
+    assert(dst && ramp_);
+
+    Color colors[chunk_size_];
+    Int_64_ index = index_;
+    while(0u < count)
+    {
+      Size const chunk = chunk_size_ < count ? chunk_size_ : count;
+      for(Size i = 0u; chunk > i; ++i, index += step_x_)
+      {
+        colors[i] = ramp_->template at<spread>(index);
+      }
+
+      if constexpr(coverage_span)
+      {
+        Blend_8888::blend_colors(dst, colors, coverage, chunk);
+        coverage += chunk;
+      }
+      else
+      {
+        Blend_8888::blend_colors(dst, colors, solid_coverage, chunk);
+      }
+
+      dst += chunk;
+      count -= chunk;
+    }
+  }
+
+  Ramp const* ramp_ = nullptr;
+  Int_64_ origin_ = 0;
+  Int_64_ step_x_ = 0;
+  Int_64_ step_y_ = 0;
+  Int_64_ row_index_ = 0;
+  Int_64_ index_ = 0;
+};
+
+// Fills with a radial gradient, position 0 at the center and 1 on the
+// circle of the given radius. Along a row the squared distance to the
+// center changes by a first difference that itself grows by 2 per pixel,
+// so a pixel costs two additions and a square root.
+template<Gradient_spread spread, ::std::size_t n = 256u>
+struct Radial_gradient_blender_8888 : Blender_base<::std::uint32_t>
+{
+private:
+  using Unt_8_ = ::std::uint8_t;
+  using Unt_32_ = ::std::uint32_t;
+  using Int_64_ = ::std::int64_t;
+  using Base_ = Blender_base<Color>;
+
+public:
+  using Ramp = Gradient_ramp<n>;
+
+  using Base_::Base_;
+
+  [[nodiscard]] Ramp const* ramp() const noexcept
+  {
+    return ramp_;
+  }
+
+  void set_ramp(Ramp const& ramp) noexcept
+  {
+    ramp_ = &ramp;
+  }
+
+  // A zero radius gives position 0 everywhere.
+  void set_circle(
+    double const center_x,
+    double const center_y,
+    double const radius) noexcept
+  {
+    center_x_ = center_x;
+    center_y_ = center_y;
+    scale_ = 0.0 < radius ? static_cast<double>(Ramp::one) / radius : 0.0;
+  }
+
+  [[nodiscard]] bool is_opaque() const noexcept
+  {
+    return ramp_ && ramp_->is_opaque();
+  }
+
+  template<class X>
+  void set_x(X const& x) noexcept
+  {
+    Base_::set_x(x);
+    double const dx = static_cast<double>(x) + 0.5 - center_x_;
+    distance_2_ = dx * dx + dy_2_;
+    step_ = dx + dx + 1.0;
+  }
+
+  template<class Y>
+  void set_y(Y const& y) noexcept
+  {
+    Base_::set_y(y);
+    y_ = static_cast<double>(y);
+    double const dy = y_ + 0.5 - center_y_;
+    dy_2_ = dy * dy;
+  }
+
+  void inc_x() noexcept
+  {
+    Base_::inc_x();
+    distance_2_ += step_;
+    step_ += 2.0;
+  }
+
+  void inc_y() noexcept
+  {
+    Base_::inc_y();
+    set_y(y_ + 1.0);
+  }
+
+  void blend(Color const alpha) const noexcept
+  {
+    Color* const dst_color = pixel();
+    assert(dst_color && ramp_);
+    Blend_8888::blend_pixel(*dst_color, color_(distance_2_), alpha);
+  }
+
+  void blend_span(
+    Unt_8_ const* const coverage,
+    Size const count) const noexcept
+  {
+    blend_<true>(coverage, 0u, count);
+  }
+
+  void blend_solid(Unt_8_ const coverage, Size const count) const noexcept
+  {
+    if(0u < coverage)
+    {
+      blend_<false>(nullptr, coverage, count);
+    }
+  }
+
+private:
+  // Colors computed per call of the span kernel.
+  static Size constexpr chunk_size_ = 64u;
+
+  // Upper bound of the ramp position, a whole even number of ramps, so
+  // that converting it to an index cannot overflow for pixels far from a
+  // tiny circle.
+  static double constexpr max_index_ =
+    static_cast<double>(Ramp::one) * static_cast<double>(1u << 30u);
+
+  [[nodiscard]] Color color_(double const distance_2) const noexcept
+  {
+    // Rounding may leave the sum a hair below zero at the center.
+    double const distance =
+      0.0 < distance_2 ? ::std::sqrt(distance_2) : 0.0;
+    double const index = distance * scale_;
+    return ramp_->template at<spread>(
+      static_cast<Int_64_>(index < max_index_ ? index : max_index_));
+  }
+
+  template<bool coverage_span>
+  void blend_(
+    Unt_8_ const* coverage,
+    Unt_32_ const solid_coverage,
+    Size count) const noexcept
+  {
+    Color* dst = pixel();
+    assert(dst && ramp_);
+
+    Color colors[chunk_size_];
+    double distance_2 = distance_2_;
+    double step = step_;
+    while(0u < count)
+    {
+      Size const chunk = chunk_size_ < count ? chunk_size_ : count;
+      for(Size i = 0u; chunk > i; ++i)
+      {
+        colors[i] = color_(distance_2);
+        distance_2 += step;
+        step += 2.0;
+      }
+
+      if constexpr(coverage_span)
+      {
+        Blend_8888::blend_colors(dst, colors, coverage, chunk);
+        coverage += chunk;
+      }
+      else
+      {
+        Blend_8888::blend_colors(dst, colors, solid_coverage, chunk);
+      }
+
+      dst += chunk;
+      count -= chunk;
+    }
+  }
+
+  Ramp const* ramp_ = nullptr;
+  double center_x_ = 0.0;
+  double center_y_ = 0.0;
+  double scale_ = 0.0;
+  double y_ = 0.0;
+  double dy_2_ = 0.0;
+  double distance_2_ = 0.0;
+  double step_ = 0.0;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_GRADIENTBLENDER8888_HH
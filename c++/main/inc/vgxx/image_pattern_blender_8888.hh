@@ -0,0 +1,582 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_IMAGEPATTERNBLENDER8888_HH
+#define VGXX_IMAGEPATTERNBLENDER8888_HH
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+#include <vgxx/blend_8888.hh>
+#include <vgxx/blend_premul_8888.hh>
+#include <vgxx/blender_base.hh>
+#include <vgxx/simd.hh>
+
+namespace vgxx
+{
+
+enum class Image_filter
+{
+  nearest = 0,
+  bilinear = 1
+};
+
+// Fills with a transformed source image, for raster tiles clipped to
+// vector shapes and textured UI. The source is a 32-bit image with
+// straight alpha in the channel order of the target, and is not owned.
+// Pixels outside it repeat its edge.
+//
+// The source position of each target pixel center is kept in 16.16 fixed
+// point and stepped per pixel and per row. Bilinear samples take 8-bit
+// weights and are computed for four pixels at a time with SSE2; both
+// paths produce the same values. They interpolate premultiplied texels
+// and divide the alpha out again, so the color of transparent texels does
+// not bleed into the edges of the image. Under a whole-pixel translation
+// pixels are blended straight from the source rows with no sampling.
+template<Image_filter filter>
+struct Image_pattern_blender_8888 : Blender_base<::std::uint32_t>
+{
+private:
+  using Unt_8_ = ::std::uint8_t;
+  using Unt_32_ = ::std::uint32_t;
+  using Int_32_ = ::std::int32_t;
+  using Int_64_ = ::std::int64_t;
+  using Base_ = Blender_base<Color>;
+
+public:
+  using Base_::Base_;
+
+  void set_source(
+    Color const* const data,
+    Size const width,
+    Size const height,
+    Size const bytes_per_row) noexcept
+  {
+    assert(data && 0u < width && 0u < height);
+    src_ = data;
+    src_width_ = static_cast<Int_64_>(width);
+    src_height_ = static_cast<Int_64_>(height);
+    src_bytes_per_row_ = bytes_per_row;
+  }
+
+  // Places the source with the affine transform that maps source point
+  // (x, y) to target point (a * x + c * y + e, b * x + d * y + f).
+  // Throws std::invalid_argument if the transform is not invertible.
+  void set_transform(
+    double const a,
+    double const b,
+    double const c,
+    double const d,
+    double const e,
+    double const f)
+  {
+    double const det = a * d - b * c;
+    if(!(0.0 != det) || !::std::isfinite(det))
+    {
+      throw ::std::invalid_argument(
+        "The pattern transform is not invertible");
+    }
+
+    // Inverse transform, scaled to 16.16 fixed point.
+    double const scale = 65536.0 / det;
+    u_step_x_ = fixed_(d * scale);
+    u_step_y_ = fixed_(-c * scale);
+    v_step_x_ = fixed_(-b * scale);
+    v_step_y_ = fixed_(a * scale);
+
+    // Source position of the center of target pixel (0, 0).
+    u_origin_ = fixed_(((0.5 - e) * d - (0.5 - f) * c) * scale);
+    v_origin_ = fixed_(((0.5 - f) * a - (0.5 - e) * b) * scale);
+
+    if constexpr(Image_filter::bilinear == filter)
+    {
+      // Bilinear samples are taken around pixel centers.
+      u_origin_ -= 0x8000;
+      v_origin_ -= 0x8000;
+    }
+
+    Int_64_ constexpr one = 0x10000;
+    blit_ =
+      one == u_step_x_ && 0 == u_step_y_ &&
+      0 == v_step_x_ && one == v_step_y_;
+    if constexpr(Image_filter::bilinear == filter)
+    {
+      // Zero weights give back the texels.
+      blit_ = blit_ && 0 == (u_origin_ & 0xff00) && 0 == (v_origin_ & 0xff00);
+    }
+  }
+
+  void set_translation(double const x, double const y)
+  {
+    set_transform(1.0, 0.0, 0.0, 1.0, x, y);
+  }
+
+  template<class X>
+  void set_x(X const& x) noexcept
+  {
+    Base_::set_x(x);
+    u_ = row_u_ + u_step_x_ * static_cast<Int_64_>(x);
+    v_ = row_v_ + v_step_x_ * static_cast<Int_64_>(x);
+  }
+
+  template<class Y>
+  void set_y(Y const& y) noexcept
+  {
+    Base_::set_y(y);
+    row_u_ = u_origin_ + u_step_y_ * static_cast<Int_64_>(y);
+    row_v_ = v_origin_ + v_step_y_ * static_cast<Int_64_>(y);
+  }
+
+  void inc_x() noexcept
+  {
+    Base_::inc_x();
+    u_ += u_step_x_;
+    v_ += v_step_x_;
+  }
+
+  void inc_y() noexcept
+  {
+    Base_::inc_y();
+    row_u_ += u_step_y_;
+    row_v_ += v_step_y_;
+  }
+
+  void blend(Color const alpha) const noexcept
+  {
+    Color* const dst_color = pixel();
+    assert(dst_color && src_);
+    Blend_8888::blend_pixel(*dst_color, sample_(u_, v_), alpha);
+  }
+
+  // Blends count pixels starting at the current one, each with its own
+  // coverage.
+  void blend_span(
+    Unt_8_ const* const coverage,
+    Size const count) const noexcept
+  {
+    blend_<true>(coverage, 0u, count);
+  }
+
+  // Blends count pixels starting at the current one, all with the same
+  // coverage.
+  void blend_solid(Unt_8_ const coverage, Size const count) const noexcept
+  {
+    if(0u < coverage)
+    {
+      blend_<false>(nullptr, coverage, count);
+    }
+  }
+
+private:
+  // Pixels sampled per call of the span kernel.
+  static Size constexpr chunk_size_ = 64u;
+
+  [[nodiscard]] static Int_64_ fixed_(double const val) noexcept
+  {
+    return static_cast<Int_64_>(::std::llround(val));
+  }
+
+  [[nodiscard]] static Int_64_ clamp_(
+    Int_64_ const val,
+    Int_64_ const max) noexcept
+  {
+    return val < 0 ? 0 : (val > max ? max : val);
+  }
+
+  [[nodiscard]] Color const* src_row_(Int_64_ const y) const noexcept
+  {
+    return reinterpret_cast<Color const*>(
+      reinterpret_cast<char const*>(src_) +
+      src_bytes_per_row_ * static_cast<Size>(y));
+  }
+
+  [[nodiscard]] Color texel_(Int_64_ const x, Int_64_ const y) const noexcept
+  {
+    return src_row_(clamp_(y, src_height_ - 1))[clamp_(x, src_width_ - 1)];
+  }
+
+  // (a * (256 - w) + b * w) / 256 per channel.
+  [[nodiscard]] static Unt_32_ lerp_(
+    Unt_32_ const a,
+    Unt_32_ const b,
+    Unt_32_ const w) noexcept
+  {
+    Unt_32_ result = 0u;
+    for(Unt_32_ shift = 0u; 32u > shift; shift += 8u)
+    {
+      Unt_32_ const ca = (a >> shift) & 0xffu;
+      Unt_32_ const cb = (b >> shift) & 0xffu;
+      result |= ((ca * (0x100u - w) + cb * w) >> 8u) << shift;
+    }
+
+    return result;
+  }
+
+  [[nodiscard]] static Unt_32_ premultiplied_(Unt_32_ const color) noexcept
+  {
+    return 0xffu == color >> 24u ?
+      color : Blend_premul_8888::premultiply(color);
+  }
+
+  [[nodiscard]] static Unt_32_ unpremultiplied_(Unt_32_ const color) noexcept
+  {
+    return 0xffu == color >> 24u ?
+      color : Blend_premul_8888::unpremultiply(color);
+  }
+
+  [[nodiscard]] Color sample_(Int_64_ const u, Int_64_ const v) const noexcept
+  {
+    Int_64_ const x = u >> 16u;
+    Int_64_ const y = v >> 16u;
+    if constexpr(Image_filter::nearest == filter)
+    {
+      return texel_(x, y);
+    }
+    else
+    {
+      auto const wx = static_cast<Unt_32_>((u >> 8u) & 0xff);
+      auto const wy = static_cast<Unt_32_>((v >> 8u) & 0xff);
+      if(0u == (wx | wy))
+      {
+        // The texel itself, as blit_span_() blends it.
+        return texel_(x, y);
+      }
+
+      Unt_32_ const top = lerp_(
+        premultiplied_(texel_(x, y)), premultiplied_(texel_(x + 1, y)), wx);
+      Unt_32_ const bottom = lerp_(
+        premultiplied_(texel_(x, y + 1)),
+        premultiplied_(texel_(x + 1, y + 1)),
+        wx);
+      return unpremultiplied_(lerp_(top, bottom, wy));
+    }
+  }
+
+  template<bool coverage_span>
+  void blend_(
+    Unt_8_ const* coverage,
+    Unt_32_ const solid_coverage,
+    Size count) const noexcept
+  {
+    Color* dst = pixel();
+    assert(dst && src_);
+
+    if(blit_)
+    {
+      blit_span_<coverage_span>(dst, coverage, solid_coverage, count);
+      return;
+    }
+
+    Color colors[chunk_size_];
+    Int_64_ u = u_;
+    Int_64_ v = v_;
+    while(0u < count)
+    {
+      Size const chunk = chunk_size_ < count ? chunk_size_ : count;
+      Size i = 0u;
+#if defined(VGXX_SIMD_X86)
+      if constexpr(Image_filter::bilinear == filter)
+      {
+        if(Simd_level::sse2 <= Simd::level())
+        {
+          for(; chunk >= i + 4u; i += 4u)
+          {
+            sample_4_sse2_(colors + i, u, v);
+            u += 4 * u_step_x_;
+            v += 4 * v_step_x_;
+          }
+        }
+      }
+#endif
+      for(; chunk > i; ++i)
+      {
+        colors[i] = sample_(u, v);
+        u += u_step_x_;
+        v += v_step_x_;
+      }
+
+      if constexpr(coverage_span)
+      {
+        Blend_8888::blend_colors(dst, colors, coverage, chunk);
+        coverage += chunk;
+      }
+      else
+      {
+        Blend_8888::blend_colors(dst, colors, solid_coverage, chunk);
+      }
+
+      dst += chunk;
+      count -= chunk;
+    }
+  }
+
+  // Whole-pixel translation: the middle of the span reads the source row
+  // directly, the parts left and right of the source repeat its edge.
+  template<bool coverage_span>
+  void blit_span_(
+    Color* dst,
+    Unt_8_ const* coverage,
+    Unt_32_ const solid_coverage,
+    Size count) const noexcept
+  {
+    Color const* const row = src_row_(clamp_(v_ >> 16u, src_height_ - 1));
+    Int_64_ x = u_ >> 16u;
+
+    auto const blend_edge = [&](Color const color, Size const n)
+      {
+        if constexpr(coverage_span)
+        {
+          Blend_8888::blend_span(dst, coverage, n, color);
+          coverage += n;
+        }
+        else
+        {
+          Blend_8888::blend_solid(dst, solid_coverage, n, color);
+        }
+        dst += n;
+        count -= n;
+      };
+
+    if(0 > x)
+    {
+      Size const n = -x < static_cast<Int_64_>(count) ?
+        static_cast<Size>(-x) : count;
+      blend_edge(row[0], n);
+      x = 0;
+    }
+
+    if(0u < count && src_width_ > x)
+    {
+      Int_64_ const available = src_width_ - x;
+      Size const n = available < static_cast<Int_64_>(count) ?
+        static_cast<Size>(available) : count;
+      if constexpr(coverage_span)
+      {
+        Blend_8888::blend_colors(dst, row + x, coverage, n);
+        coverage += n;
+      }
+      else
+      {
+        Blend_8888::blend_colors(dst, row + x, solid_coverage, n);
+      }
+      dst += n;
+      count -= n;
+    }
+
+    if(0u < count)
+    {
+      blend_edge(row[src_width_ - 1], count);
+    }
+  }
+
+#if defined(VGXX_SIMD_X86)
+  VGXX_SIMD_TARGET("sse2")
+  [[nodiscard]] static __m128i lerp_sse2_(
+    __m128i const a,
+    __m128i const b,
+    __m128i const w) noexcept
+  {
+    __m128i const full = _mm_set1_epi16(0x100);
+    return _mm_srli_epi16(
+      _mm_add_epi16(
+        _mm_mullo_epi16(a, _mm_sub_epi16(full, w)),
+        _mm_mullo_epi16(b, w)),
+      8);
+  }
+
+  // Color channels times alpha / 255 for two pixels on 16-bit lanes, with
+  // the rounding of Blend_premul_8888::premultiply():
+  // (v + 1 + (v >> 8)) >> 8 equals ((v + 1) * 257) >> 16 for v <= 65025.
+  VGXX_SIMD_TARGET("sse2")
+  [[nodiscard]] static __m128i premultiply_sse2_(__m128i const c) noexcept
+  {
+    __m128i const alpha_lanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+    __m128i const product = _mm_mullo_epi16(
+      c,
+      _mm_shufflehi_epi16(
+        _mm_shufflelo_epi16(c, _MM_SHUFFLE(3, 3, 3, 3)),
+        _MM_SHUFFLE(3, 3, 3, 3)));
+    __m128i const scaled = _mm_mulhi_epu16(
+      _mm_add_epi16(product, _mm_set1_epi16(1)), _mm_set1_epi16(257));
+    return _mm_or_si128(
+      _mm_andnot_si128(alpha_lanes, scaled), _mm_and_si128(alpha_lanes, c));
+  }
+
+  // Divides the alpha out of four premultiplied pixels with the rounding
+  // of Blend_premul_8888::unpremultiply(). The numerators stay below 2^16,
+  // so the float quotient truncates to the integer one; a zero alpha
+  // gives NaN, which saturates to 0.
+  VGXX_SIMD_TARGET("sse2")
+  [[nodiscard]] static __m128i unpremultiply_sse2_(__m128i const p) noexcept
+  {
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const alpha_lanes = _mm_set1_epi32(static_cast<int>(0xff000000u));
+    __m128i const c_lo = _mm_unpacklo_epi8(p, zero);
+    __m128i const c_hi = _mm_unpackhi_epi8(p, zero);
+    __m128i const c[4] = {
+      _mm_unpacklo_epi16(c_lo, zero),
+      _mm_unpackhi_epi16(c_lo, zero),
+      _mm_unpacklo_epi16(c_hi, zero),
+      _mm_unpackhi_epi16(c_hi, zero)};
+    __m128i q[4];
+    for(unsigned i = 0u; 4u > i; ++i)
+    {
+      __m128i const alpha = _mm_shuffle_epi32(c[i], _MM_SHUFFLE(3, 3, 3, 3));
+      __m128i const n = _mm_add_epi32(
+        _mm_sub_epi32(_mm_slli_epi32(c[i], 8), c[i]),
+        _mm_srli_epi32(alpha, 1));
+      q[i] = _mm_cvttps_epi32(
+        _mm_div_ps(_mm_cvtepi32_ps(n), _mm_cvtepi32_ps(alpha)));
+    }
+
+    return _mm_or_si128(
+      _mm_andnot_si128(
+        alpha_lanes,
+        _mm_packus_epi16(
+          _mm_packs_epi32(q[0], q[1]), _mm_packs_epi32(q[2], q[3]))),
+      _mm_and_si128(alpha_lanes, p));
+  }
+
+  // Four bilinear samples starting at (u, v). The texels are gathered
+  // with scalar loads; the weighting runs on 16-bit lanes with the same
+  // rounding as lerp_(), and premultiplication with that of sample_().
+  VGXX_SIMD_TARGET("sse2")
+  void sample_4_sse2_(Color* const out, Int_64_ u, Int_64_ v) const noexcept
+  {
+    alignas(16) Unt_32_ t_00[4];
+    alignas(16) Unt_32_ t_01[4];
+    alignas(16) Unt_32_ t_10[4];
+    alignas(16) Unt_32_ t_11[4];
+    alignas(16) ::std::int16_t w_x[8];
+    alignas(16) ::std::int16_t w_y[8];
+    Unt_32_ all_texels = 0xffffffffu;
+
+    for(unsigned i = 0u; 4u > i; ++i)
+    {
+      Int_64_ const x = u >> 16u;
+      Int_64_ const y = v >> 16u;
+      Int_64_ const x_0 = clamp_(x, src_width_ - 1);
+      Int_64_ const x_1 = clamp_(x + 1, src_width_ - 1);
+      Color const* const row_0 = src_row_(clamp_(y, src_height_ - 1));
+      Color const* const row_1 = src_row_(clamp_(y + 1, src_height_ - 1));
+      t_00[i] = row_0[x_0];
+      t_01[i] = row_0[x_1];
+      t_10[i] = row_1[x_0];
+      t_11[i] = row_1[x_1];
+      all_texels &= t_00[i] & t_01[i] & t_10[i] & t_11[i];
+      w_x[i] = static_cast<::std::int16_t>((u >> 8u) & 0xff);
+      w_y[i] = static_cast<::std::int16_t>((v >> 8u) & 0xff);
+      u += u_step_x_;
+      v += v_step_x_;
+    }
+
+    __m128i const zero = _mm_setzero_si128();
+
+    // Weights of pixels 0 and 1 in the low register, 2 and 3 in the high
+    // one, each spread to the four channels.
+    __m128i const wx = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(w_x));
+    __m128i const wy = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(w_y));
+    __m128i const wx_2 = _mm_unpacklo_epi16(wx, wx);
+    __m128i const wy_2 = _mm_unpacklo_epi16(wy, wy);
+    __m128i const wx_lo = _mm_unpacklo_epi32(wx_2, wx_2);
+    __m128i const wx_hi = _mm_unpackhi_epi32(wx_2, wx_2);
+    __m128i const wy_lo = _mm_unpacklo_epi32(wy_2, wy_2);
+    __m128i const wy_hi = _mm_unpackhi_epi32(wy_2, wy_2);
+
+    __m128i const p_00 = _mm_load_si128(reinterpret_cast<__m128i*>(t_00));
+    __m128i const p_01 = _mm_load_si128(reinterpret_cast<__m128i*>(t_01));
+    __m128i const p_10 = _mm_load_si128(reinterpret_cast<__m128i*>(t_10));
+    __m128i const p_11 = _mm_load_si128(reinterpret_cast<__m128i*>(t_11));
+
+    __m128i c_00_lo = _mm_unpacklo_epi8(p_00, zero);
+    __m128i c_01_lo = _mm_unpacklo_epi8(p_01, zero);
+    __m128i c_10_lo = _mm_unpacklo_epi8(p_10, zero);
+    __m128i c_11_lo = _mm_unpacklo_epi8(p_11, zero);
+    __m128i c_00_hi = _mm_unpackhi_epi8(p_00, zero);
+    __m128i c_01_hi = _mm_unpackhi_epi8(p_01, zero);
+    __m128i c_10_hi = _mm_unpackhi_epi8(p_10, zero);
+    __m128i c_11_hi = _mm_unpackhi_epi8(p_11, zero);
+
+    // Premultiplying and dividing out an alpha of 255 change nothing.
+    bool const opaque = 0xffu == all_texels >> 24u;
+    if(!opaque)
+    {
+      c_00_lo = premultiply_sse2_(c_00_lo);
+      c_01_lo = premultiply_sse2_(c_01_lo);
+      c_10_lo = premultiply_sse2_(c_10_lo);
+      c_11_lo = premultiply_sse2_(c_11_lo);
+      c_00_hi = premultiply_sse2_(c_00_hi);
+      c_01_hi = premultiply_sse2_(c_01_hi);
+      c_10_hi = premultiply_sse2_(c_10_hi);
+      c_11_hi = premultiply_sse2_(c_11_hi);
+    }
+
+    __m128i const lo = lerp_sse2_(
+      lerp_sse2_(c_00_lo, c_01_lo, wx_lo),
+      lerp_sse2_(c_10_lo, c_11_lo, wx_lo),
+      wy_lo);
+    __m128i const hi = lerp_sse2_(
+      lerp_sse2_(c_00_hi, c_01_hi, wx_hi),
+      lerp_sse2_(c_10_hi, c_11_hi, wx_hi),
+      wy_hi);
+
+    __m128i result = _mm_packus_epi16(lo, hi);
+    if(!opaque)
+    {
+      // Pixels with zero weights take their texel as it is, as in
+      // sample_().
+      __m128i const texel = _mm_cmpeq_epi32(
+        _mm_unpacklo_epi16(_mm_or_si128(wx, wy), zero), zero);
+      result = _mm_or_si128(
+        _mm_and_si128(texel, p_00),
+        _mm_andnot_si128(texel, unpremultiply_sse2_(result)));
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), result);
+  }
+#endif
+
+  Color const* src_ = nullptr;
+  Int_64_ src_width_ = 0;
+  Int_64_ src_height_ = 0;
+  Size src_bytes_per_row_ = 0u;
+  Int_64_ u_origin_ = 0;
+  Int_64_ v_origin_ = 0;
+  Int_64_ u_step_x_ = 0x10000;
+  Int_64_ u_step_y_ = 0;
+  Int_64_ v_step_x_ = 0;
+  Int_64_ v_step_y_ = 0x10000;
+  Int_64_ row_u_ = 0;
+  Int_64_ row_v_ = 0;
+  Int_64_ u_ = 0;
+  Int_64_ v_ = 0;
+  bool blit_ = true;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_IMAGEPATTERNBLENDER8888_HH
@@ -0,0 +1,161 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_LATENCYHISTOGRAM_HH
+#define VGXX_LATENCYHISTOGRAM_HH
+
+#include <cstddef>
+#include <cstdint>
+
+namespace vgxx
+{
+
+// Histogram of durations in nanoseconds with power-of-two buckets. Bucket
+// i counts durations in [2^i, 2^(i + 1)), except bucket 0, which also
+// counts zero.
+struct Latency_histogram
+{
+  using Size = ::std::size_t;
+  using Unt_64 = ::std::uint64_t;
+
+  static Size constexpr bucket_count = 64u;
+
+  Latency_histogram() noexcept
+  {
+    clear();
+  }
+
+  void clear() noexcept
+  {
+    for(auto& bucket : buckets_)
+    {
+      bucket = 0u;
+    }
+    count_ = 0u;
+    total_ = 0u;
+    max_ = 0u;
+  }
+
+  void add(Unt_64 const nanoseconds) noexcept
+  {
+    ++buckets_[bucket_index(nanoseconds)];
+    ++count_;
+    total_ += nanoseconds;
+    if(max_ < nanoseconds)
+    {
+      max_ = nanoseconds;
+    }
+  }
+
+  void merge(Latency_histogram const& other) noexcept
+  {
+    for(Size i = 0u; bucket_count > i; ++i)
+    {
+      buckets_[i] += other.buckets_[i];
+    }
+    count_ += other.count_;
+    total_ += other.total_;
+    if(max_ < other.max_)
+    {
+      max_ = other.max_;
+    }
+  }
+
+  [[nodiscard]] Unt_64 count() const noexcept
+  {
+    return count_;
+  }
+
+  [[nodiscard]] Unt_64 total_nanoseconds() const noexcept
+  {
+    return total_;
+  }
+
+  [[nodiscard]] Unt_64 max_nanoseconds() const noexcept
+  {
+    return max_;
+  }
+
+  [[nodiscard]] Unt_64 mean_nanoseconds() const noexcept
+  {
+    return 0u < count_ ? total_ / count_ : 0u;
+  }
+
+  [[nodiscard]] Unt_64 bucket(Size const i) const noexcept
+  {
+    return buckets_[i];
+  }
+
+  // Upper estimate of the q-th quantile, 0 <= q <= 1: the end of the
+  // bucket holding it, capped at the largest duration seen.
+  [[nodiscard]] Unt_64 quantile_nanoseconds(double const q) const noexcept
+  {
+    if(0u == count_)
+    {
+      return 0u;
+    }
+
+    auto rank = static_cast<Unt_64>(q * static_cast<double>(count_));
+    if(count_ <= rank)
+    {
+      rank = count_ - 1u;
+    }
+
+    Unt_64 seen = 0u;
+    for(Size i = 0u; bucket_count > i; ++i)
+    {
+      seen += buckets_[i];
+      if(rank < seen)
+      {
+        Unt_64 const end = bucket_count - 1u > i ?
+          (Unt_64{2u} << i) - 1u : ~Unt_64{0u};
+        return end < max_ ? end : max_;
+      }
+    }
+
+    return max_;
+  }
+
+  [[nodiscard]] static Size bucket_index(Unt_64 nanoseconds) noexcept
+  {
+    Size i = 0u;
+    while(1u < nanoseconds)
+    {
+      nanoseconds >>= 1u;
+      ++i;
+    }
+
+    return i;
+  }
+
+private:
+  Unt_64 buckets_[bucket_count];
+  Unt_64 count_;
+  Unt_64 total_;
+  Unt_64 max_;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_LATENCYHISTOGRAM_HH
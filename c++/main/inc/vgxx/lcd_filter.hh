@@ -0,0 +1,145 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_LCDFILTER_HH
+#define VGXX_LCDFILTER_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+#include <vgxx/simd.hh>
+
+namespace vgxx
+{
+
+// Five-tap low-pass filter over a row of subpixel coverage, which spreads
+// the energy of every subpixel over its neighbours to keep color fringes
+// at bay. The weights sum to 256; the default ones are FreeType's.
+struct Lcd_filter
+{
+  using Unt_8 = ::std::uint8_t;
+  using Size = ::std::size_t;
+
+  static Size constexpr tap_count = 5u;
+
+  Lcd_filter() noexcept :
+    weights_{0x08u, 0x4du, 0x56u, 0x4du, 0x08u}
+  {}
+
+  // Throws std::invalid_argument unless the weights sum to 256.
+  explicit Lcd_filter(
+    unsigned const w_0,
+    unsigned const w_1,
+    unsigned const w_2,
+    unsigned const w_3,
+    unsigned const w_4) :
+    weights_{w_0, w_1, w_2, w_3, w_4}
+  {
+    if(256u != w_0 + w_1 + w_2 + w_3 + w_4)
+    {
+      throw ::std::invalid_argument("LCD filter weights must sum to 256");
+    }
+  }
+
+  [[nodiscard]] unsigned weight(Size const tap) const noexcept
+  {
+    return weights_[tap];
+  }
+
+  // Filters count values: dst[i] is the weighted sum of src[i] to
+  // src[i + 4], so src is centered 2 entries before dst.
+  void apply(
+    Unt_8 const* src,
+    Unt_8* dst,
+    Size count,
+    Simd_level const level = Simd::level()) const noexcept
+  {
+#if defined(VGXX_SIMD_X86)
+    if(Simd_level::sse2 <= Simd::clamp(level))
+    {
+      Size const done = count & ~Size{15u};
+      apply_sse2_(src, dst, done);
+      src += done;
+      dst += done;
+      count -= done;
+    }
+#else
+    static_cast<void>(level);
+#endif
+
+    for(; 0u < count; --count, ++src)
+    {
+      unsigned sum = 0x80u;
+      for(Size tap = 0u; tap_count > tap; ++tap)
+      {
+        sum += weights_[tap] * src[tap];
+      }
+      *dst++ = static_cast<Unt_8>(sum >> 8u);
+    }
+  }
+
+private:
+#if defined(VGXX_SIMD_X86)
+  // Sums stay below 65536, so the unsigned 16-bit lanes do not wrap.
+  VGXX_SIMD_TARGET("sse2")
+  void apply_sse2_(
+    Unt_8 const* const src,
+    Unt_8* const dst,
+    Size const count) const noexcept
+  {
+    __m128i const zero = _mm_setzero_si128();
+    __m128i weights[tap_count];
+    for(Size tap = 0u; tap_count > tap; ++tap)
+    {
+      weights[tap] = _mm_set1_epi16(static_cast<short>(weights_[tap]));
+    }
+
+    for(Size i = 0u; count > i; i += 16u)
+    {
+      __m128i lo = _mm_set1_epi16(0x80);
+      __m128i hi = lo;
+      for(Size tap = 0u; tap_count > tap; ++tap)
+      {
+        __m128i const v = _mm_loadu_si128(
+          reinterpret_cast<__m128i const*>(src + i + tap));
+        lo = _mm_add_epi16(
+          lo, _mm_mullo_epi16(_mm_unpacklo_epi8(v, zero), weights[tap]));
+        hi = _mm_add_epi16(
+          hi, _mm_mullo_epi16(_mm_unpackhi_epi8(v, zero), weights[tap]));
+      }
+
+      _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(dst + i),
+        _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+    }
+  }
+#endif
+
+  unsigned weights_[tap_count];
+};
+
+} // namespace vgxx
+
+#endif // VGXX_LCDFILTER_HH
@@ -0,0 +1,346 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_LCDRENDERER_HH
+#define VGXX_LCDRENDERER_HH
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <vgxx/cell_processor.hh>
+#include <vgxx/damage_tracker.hh>
+#include <vgxx/fill_rule.hh>
+#include <vgxx/lcd_filter.hh>
+#include <vgxx/pixel_box.hh>
+#include <vgxx/rasterizer.hh>
+#include <vgxx/util.hh>
+
+namespace vgxx
+{
+
+// Renderer for LCD subpixel text. Outlines are rasterized at three times
+// the horizontal resolution by scaling x on the way into the rasterizer,
+// so every cell covers one subpixel. Each swiped row of subpixel coverage
+// goes through an Lcd_filter and reaches the blender as red, green and
+// blue coverage per pixel, through blend_lcd_span(coverage, count) (see
+// Color_blender_lcd_8888).
+//
+// Only one row of subpixel coverage is kept at a time, so there is no
+// need to render into a 3x wide image and downsample it.
+template<class B, class P = Cell_processor>
+struct Lcd_renderer
+{
+  using Blender = B;
+  using Cell_processor = P;
+  using Coord = typename Cell_processor::Coord;
+  using Int_32 = ::std::int32_t;
+
+  template<class... Blender_args>
+  explicit Lcd_renderer(
+    Coord const width,
+    Coord const height,
+    Blender_args&&... blender_args) :
+    cell_proc_(subpixel_width_(width), height),
+    blender_(static_cast<Blender_args&&>(blender_args)...),
+    damage_tracker_(nullptr),
+    width_(static_cast<Int_32>(width)),
+    x_0_(0.f),
+    y_0_(0.f),
+    x_(0.f),
+    y_(0.f)
+  {
+    assert(0u < width);
+    assert(0u < height);
+    resize_rows_();
+  }
+
+  [[nodiscard]] Coord width() const noexcept
+  {
+    return static_cast<Coord>(width_);
+  }
+
+  [[nodiscard]] Coord height() const noexcept
+  {
+    return cell_proc_.height();
+  }
+
+  [[nodiscard]] Blender& blender() noexcept
+  {
+    return blender_;
+  }
+
+  [[nodiscard]] Blender const& blender() const noexcept
+  {
+    return blender_;
+  }
+
+  [[nodiscard]] Lcd_filter const& filter() const noexcept
+  {
+    return filter_;
+  }
+
+  void set_filter(Lcd_filter const& filter) noexcept
+  {
+    filter_ = filter;
+  }
+
+  // Discards the current outline and changes the canvas size. The blender
+  // keeps its target, so point it at the new image as well. The damage
+  // tracker is dropped, as it was collecting rows of the old image.
+  void resize(Coord const width, Coord const height)
+  {
+    assert(0u < width);
+    assert(0u < height);
+
+    cell_proc_.resize(subpixel_width_(width), height);
+    rasterizer_.reset();
+    damage_tracker_ = nullptr;
+    width_ = static_cast<Int_32>(width);
+    resize_rows_();
+    x_0_ = 0.f;
+    y_0_ = 0.f;
+    x_ = 0.f;
+    y_ = 0.f;
+  }
+
+  void move_to(float const x, float const y) noexcept
+  {
+    rasterizer_.move_to(cell_proc_, x * 3.f, y);
+    x_0_ = x;
+    y_0_ = y;
+    x_ = x;
+    y_ = y;
+  }
+
+  void line_to(float const x, float const y) noexcept
+  {
+    line_to_(x, y);
+    x_ = x;
+    y_ = y;
+  }
+
+  void bezier_to(
+    float const x_1,
+    float const y_1,
+    float const x_2,
+    float const y_2,
+    float const x_3,
+    float const y_3) noexcept
+  {
+    // Subdivided at subpixel resolution, since that is what the curve is
+    // rasterized at.
+    Util::subdivide_bezier(
+      [this](auto const& x, auto const& y) noexcept
+      {
+        rasterizer_.line_to(cell_proc_, x, y);
+      },
+      x_ * 3.f, y_, x_1 * 3.f, y_1, x_2 * 3.f, y_2, x_3 * 3.f, y_3);
+
+    x_ = x_3;
+    y_ = y_3;
+  }
+
+  void close_outline() noexcept
+  {
+    rasterizer_.close(cell_proc_);
+    x_ = x_0_;
+    y_ = y_0_;
+  }
+
+  // Fills the current outline and returns the bounds of the pixels it
+  // has blended, which extend past the outline by the reach of the
+  // filter.
+  template<Fill_rule fill_rule>
+  Pixel_box fill()
+  {
+    close_outline();
+    Row_sink_ sink{*this, Pixel_box()};
+    cell_proc_.template swipe<fill_rule>(coverage_row_(), sink);
+    return sink.box;
+  }
+
+  Pixel_box fill(Fill_rule const fill_rule)
+  {
+    close_outline();
+    Row_sink_ sink{*this, Pixel_box()};
+    cell_proc_.swipe(coverage_row_(), fill_rule, sink);
+    return sink.box;
+  }
+
+  [[nodiscard]] Damage_tracker* damage_tracker() const noexcept
+  {
+    return damage_tracker_;
+  }
+
+  // Every subsequent fill adds the rows it touches to the tracker. Pass
+  // nullptr to stop tracking.
+  void set_damage_tracker(Damage_tracker* const damage_tracker) noexcept
+  {
+    damage_tracker_ = damage_tracker;
+  }
+
+private:
+  using Size_ = ::std::size_t;
+  using Unt_8_ = ::std::uint8_t;
+  using Overflow_error_ = ::std::overflow_error;
+
+  template<class T>
+  using Vector_ = ::std::vector<T>;
+
+  // Entries of the coverage row before subpixel 0, read by the filter.
+  static Size_ constexpr row_margin_ = 2u;
+
+  // Stands in for the blender during the swipe and writes the coverage
+  // of one row of subpixels.
+  struct Coverage_row_
+  {
+    template<class X>
+    void set_x(X const& x) noexcept
+    {
+      pixel = row + static_cast<Int_32>(x);
+    }
+
+    template<class Y>
+    void set_y(Y const&) noexcept
+    {}
+
+    void inc_x() noexcept
+    {
+      ++pixel;
+    }
+
+    void inc_y() noexcept
+    {}
+
+    void blend(Unt_8_ const coverage) const noexcept
+    {
+      *pixel = coverage;
+    }
+
+    void blend_solid(Unt_8_ const coverage, Size_ const count) const noexcept
+    {
+      ::std::memset(pixel, coverage, count);
+    }
+
+    Unt_8_* row;
+    Unt_8_* pixel;
+  };
+
+  // Gets every row once the swipe is done with it.
+  struct Row_sink_
+  {
+    void add_row(Int_32 const y, Int_32 const x_min, Int_32 const x_max)
+    {
+      renderer.flush_row_(y, x_min, x_max, box);
+    }
+
+    Lcd_renderer& renderer;
+    Pixel_box box;
+  };
+
+  [[nodiscard]] static Coord subpixel_width_(Coord const width)
+  {
+    if(Cell_processor::max_dimension / 3u < width)
+    {
+      throw Overflow_error_("Canvas is too large");
+    }
+
+    return static_cast<Coord>(width * 3u);
+  }
+
+  void resize_rows_()
+  {
+    Size_ const subpixel_count = static_cast<Size_>(width_) * 3u;
+    coverage_.assign(subpixel_count + row_margin_ * 2u, 0u);
+    filtered_.resize(subpixel_count);
+  }
+
+  [[nodiscard]] Coverage_row_ coverage_row_() noexcept
+  {
+    Unt_8_* const row = coverage_.data() + row_margin_;
+    return Coverage_row_{row, row};
+  }
+
+  // Filters the subpixels x_min to x_max of row y and whatever they
+  // spread to, blends the pixels they reach and clears the row.
+  void flush_row_(
+    Int_32 const y,
+    Int_32 const x_min,
+    Int_32 const x_max,
+    Pixel_box& box)
+  {
+    auto constexpr margin = static_cast<Int_32>(row_margin_);
+    Int_32 const subpixel_max = width_ * 3 - 1;
+    Int_32 const first = 0 < x_min - margin ? (x_min - margin) / 3 : 0;
+    Int_32 const last =
+      (subpixel_max < x_max + margin ? subpixel_max : x_max + margin) / 3;
+    auto const count = static_cast<Size_>(last - first) + 1u;
+
+    filter_.apply(
+      coverage_.data() + static_cast<Size_>(first) * 3u,
+      filtered_.data(),
+      count * 3u);
+    ::std::memset(
+      coverage_.data() + row_margin_ + static_cast<Size_>(x_min),
+      0,
+      static_cast<Size_>(x_max - x_min) + 1u);
+
+    blender_.set_y(y);
+    blender_.set_x(first);
+    blender_.blend_lcd_span(filtered_.data(), count);
+
+    box.add_row(y, first, last);
+    if(damage_tracker_)
+    {
+      damage_tracker_->add_row(y, first, last);
+    }
+  }
+
+  template<class T>
+  void line_to_(T const& x, T const& y) noexcept
+  {
+    rasterizer_.line_to(cell_proc_, x * 3.f, y);
+  }
+
+  Rasterizer rasterizer_;
+  Cell_processor cell_proc_;
+  Blender blender_;
+  Lcd_filter filter_;
+  Vector_<Unt_8_> coverage_;
+  Vector_<Unt_8_> filtered_;
+  Damage_tracker* damage_tracker_;
+  Int_32 width_;
+  float x_0_;
+  float y_0_;
+  float x_;
+  float y_;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_LCDRENDERER_HH
@@ -0,0 +1,354 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_MAPPEDCANVAS_HH
+#define VGXX_MAPPEDCANVAS_HH
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <vgxx/blend_8888.hh>
+
+namespace vgxx
+{
+
+enum class Image_file_format
+{
+  // Pixel rows only, no header.
+  raw,
+
+  // Netpbm PAM: RGB_ALPHA for 32-bit colours in R, G, B, A byte order,
+  // GRAYSCALE for 8-bit ones.
+  pam,
+
+  // Top-down 32-bit BMP with B, G, R, A byte order.
+  bmp
+};
+
+// Image stored in a file mapped into memory, so that blenders write
+// straight into the page cache and no copy to disk is needed. The file is
+// created with the header of the format and pixel rows aligned for Color;
+// pass data() and bytes_per_row() to the blender. Rendering goes from top
+// to bottom, which the mapping is advised of.
+template<class C>
+struct Mapped_canvas
+{
+  using Color = C;
+  using Size = ::std::size_t;
+
+  Mapped_canvas(Mapped_canvas const&) = delete;
+
+  Mapped_canvas(Mapped_canvas&& other) noexcept :
+    map_(other.map_),
+    map_size_(other.map_size_),
+    data_offset_(other.data_offset_),
+    width_(other.width_),
+    height_(other.height_),
+    finished_(other.finished_),
+    file_(other.file_)
+  {
+    other.map_ = nullptr;
+    other.map_size_ = 0u;
+    other.file_ = -1;
+  }
+
+  // Creates or truncates the file at path. Throws std::invalid_argument
+  // if width or height is 0, and std::system_error if the file cannot be
+  // created, sized or mapped; the file is removed in the latter case.
+  explicit Mapped_canvas(
+    char const* const path,
+    Size const width,
+    Size const height,
+    Image_file_format const format) :
+    map_(nullptr),
+    map_size_(0u),
+    data_offset_(0u),
+    width_(width),
+    height_(height),
+    finished_(0u),
+    file_(-1)
+  {
+    if(0u == width || 0u == height)
+    {
+      throw ::std::invalid_argument("The canvas must not be empty");
+    }
+
+    char header[header_capacity_];
+    data_offset_ = write_header_(header, format);
+    map_size_ = data_offset_ + bytes_per_row() * height;
+
+    file_ = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if(0 > file_)
+    {
+      throw_error_(errno, "Failed to open the canvas file");
+    }
+
+    if(0 != ::ftruncate(file_, static_cast<::off_t>(map_size_)))
+    {
+      discard_(path, "Failed to size the canvas file");
+    }
+
+    void* const map = ::mmap(
+      nullptr, map_size_, PROT_READ | PROT_WRITE, MAP_SHARED, file_, 0);
+    if(MAP_FAILED == map)
+    {
+      discard_(path, "Failed to map the canvas file");
+    }
+
+    map_ = static_cast<char*>(map);
+    ::madvise(map_, map_size_, MADV_SEQUENTIAL);
+    ::std::memcpy(map_, header, data_offset_);
+  }
+
+  ~Mapped_canvas()
+  {
+    if(map_)
+    {
+      ::munmap(map_, map_size_);
+    }
+    close_();
+  }
+
+  Mapped_canvas& operator =(Mapped_canvas&&) = delete;
+  Mapped_canvas& operator =(Mapped_canvas const&) = delete;
+
+  [[nodiscard]] Color* data() const noexcept
+  {
+    return reinterpret_cast<Color*>(map_ + data_offset_);
+  }
+
+  [[nodiscard]] Size bytes_per_row() const noexcept
+  {
+    return width_ * sizeof(Color);
+  }
+
+  [[nodiscard]] Size width() const noexcept
+  {
+    return width_;
+  }
+
+  [[nodiscard]] Size height() const noexcept
+  {
+    return height_;
+  }
+
+  // Fills every pixel with the colour. Large 32-bit canvases are written
+  // with non-temporal stores, so clearing does not flush the cache.
+  void clear(Color const& color) noexcept
+  {
+    Color* const pixels = data();
+    if constexpr(::std::is_same<Color, ::std::uint32_t>::value)
+    {
+      Blend_8888::fill(pixels, width_ * height_, color);
+    }
+    else
+    {
+      for(Size i = width_ * height_; 0u < i;)
+      {
+        pixels[--i] = color;
+      }
+    }
+  }
+
+  // Tells the system that the rows above y are finished: starts writing
+  // them back and lets their pages be dropped from memory.
+  void finish_rows(Size const y) noexcept
+  {
+    Size const page_size = static_cast<Size>(::sysconf(_SC_PAGESIZE));
+    Size const end = (data_offset_ + bytes_per_row() * y) & ~(page_size - 1u);
+    if(finished_ < end)
+    {
+      ::msync(map_ + finished_, end - finished_, MS_ASYNC);
+      ::madvise(map_ + finished_, end - finished_, MADV_DONTNEED);
+      finished_ = end;
+    }
+  }
+
+  // Writes all the rows back to the file and waits for it.
+  void sync()
+  {
+    if(0 != ::msync(map_, map_size_, MS_SYNC))
+    {
+      throw_error_(errno, "Failed to write the canvas file");
+    }
+  }
+
+private:
+  using Unt_16_ = ::std::uint16_t;
+  using Unt_32_ = ::std::uint32_t;
+
+  static Size constexpr alignment_ = 16u;
+  static Size constexpr header_capacity_ = 256u;
+
+  static_assert(alignof(Color) <= alignment_);
+
+  [[noreturn]] static void throw_error_(
+    int const error,
+    char const* const what)
+  {
+    throw ::std::system_error(error, ::std::generic_category(), what);
+  }
+
+  // Closes and removes the file the constructor failed to set up, then
+  // throws with the errno of the failure.
+  [[noreturn]] void discard_(char const* const path, char const* const what)
+  {
+    int const error = errno;
+    close_();
+    ::unlink(path);
+    throw_error_(error, what);
+  }
+
+  static void put_16_(char*& dst, Unt_16_ const value) noexcept
+  {
+    *dst++ = static_cast<char>(value & 0xffu);
+    *dst++ = static_cast<char>(value >> 8u);
+  }
+
+  static void put_32_(char*& dst, Unt_32_ const value) noexcept
+  {
+    put_16_(dst, static_cast<Unt_16_>(value & 0xffffu));
+    put_16_(dst, static_cast<Unt_16_>(value >> 16u));
+  }
+
+  // Writes the header for the format, padded so that the pixels that
+  // follow are aligned, and returns its size.
+  [[nodiscard]] Size write_header_(
+    char* const header,
+    Image_file_format const format) const
+  {
+    switch(format)
+    {
+    case Image_file_format::raw:
+      return 0u;
+
+    case Image_file_format::pam:
+      if(4u == sizeof(Color) || 1u == sizeof(Color))
+      {
+        char const* const fields_format =
+          "WIDTH %zu\nHEIGHT %zu\nDEPTH %u\nMAXVAL 255\nTUPLTYPE %s\n"
+          "ENDHDR\n";
+        char fields[header_capacity_ / 2u];
+        auto const fields_size = static_cast<Size>(::std::snprintf(
+          fields, sizeof(fields), fields_format,
+          width_, height_,
+          static_cast<unsigned>(sizeof(Color)),
+          4u == sizeof(Color) ? "RGB_ALPHA" : "GRAYSCALE"));
+
+        // A comment line after the magic number takes up the padding.
+        Size size = 3u + 2u + fields_size;
+        size = (size + alignment_ - 1u) & ~(alignment_ - 1u);
+        Size const comment_size = size - 3u - fields_size;
+
+        ::std::memcpy(header, "P7\n#", 4u);
+        ::std::memset(header + 4u, ' ', comment_size - 2u);
+        header[2u + comment_size] = '\n';
+        ::std::memcpy(header + 3u + comment_size, fields, fields_size);
+        return size;
+      }
+      break;
+
+    case Image_file_format::bmp:
+      if(4u == sizeof(Color))
+      {
+        // File header and a BITMAPV4HEADER with explicit channel masks.
+        Size const info_size = 108u;
+        Size const data_offset = (14u + info_size + alignment_ - 1u) &
+          ~(alignment_ - 1u);
+        Size const image_size = bytes_per_row() * height_;
+
+        if(0x7fffffffu < width_ || 0x7fffffffu < height_ ||
+          0xffffffffu - data_offset < image_size)
+        {
+          throw ::std::invalid_argument("Canvas is too large for BMP");
+        }
+
+        char* dst = header;
+        *dst++ = 'B';
+        *dst++ = 'M';
+        put_32_(dst, static_cast<Unt_32_>(data_offset + image_size));
+        put_32_(dst, 0u);
+        put_32_(dst, static_cast<Unt_32_>(data_offset));
+        put_32_(dst, static_cast<Unt_32_>(info_size));
+        put_32_(dst, static_cast<Unt_32_>(width_));
+        put_32_(dst, static_cast<Unt_32_>(-static_cast<::std::int32_t>(
+          height_)));  // Negative for top-down rows.
+        put_16_(dst, 1u);  // Planes.
+        put_16_(dst, 32u);  // Bits per pixel.
+        put_32_(dst, 3u);  // BI_BITFIELDS.
+        put_32_(dst, static_cast<Unt_32_>(image_size));
+        put_32_(dst, 2835u);  // 72 DPI.
+        put_32_(dst, 2835u);
+        put_32_(dst, 0u);
+        put_32_(dst, 0u);
+        put_32_(dst, 0x00ff0000u);  // Red.
+        put_32_(dst, 0x0000ff00u);  // Green.
+        put_32_(dst, 0x000000ffu);  // Blue.
+        put_32_(dst, 0xff000000u);  // Alpha.
+        put_32_(dst, 0x73524742u);  // LCS_sRGB.
+        ::std::memset(
+          dst, 0, static_cast<Size>(header + data_offset - dst));
+        return data_offset;
+      }
+      break;
+    }
+
+    throw ::std::invalid_argument("Unsupported canvas format");
+  }
+
+  void close_() noexcept
+  {
+    if(0 <= file_)
+    {
+      ::close(file_);
+      file_ = -1;
+    }
+  }
+
+  char* map_;
+  Size map_size_;
+  Size data_offset_;
+  Size width_;
+  Size height_;
+  Size finished_;
+  int file_;
+};
+
+} // namespace vgxx
+
+#endif // defined(__unix__) || defined(__APPLE__)
+
+#endif // VGXX_MAPPEDCANVAS_HH
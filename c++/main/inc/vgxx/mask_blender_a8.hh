@@ -0,0 +1,113 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_MASKBLENDERA8_HH
+#define VGXX_MASKBLENDERA8_HH
+
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+
+#include <vgxx/blend_a8.hh>
+#include <vgxx/blender_base.hh>
+
+namespace vgxx
+{
+
+// Writes coverage into an 8-bit alpha mask. By default coverage replaces
+// the mask value; union mode accumulates several paths into one mask.
+//
+// There is no intersect mode: a renderer only reaches the pixels a path
+// covers, so the mask would keep its values outside the path. To clip a
+// mask by a path, render the path into a second mask and combine the two
+// with Blend_a8::multiply().
+struct Mask_blender_a8 : Blender_base<::std::uint8_t>
+{
+private:
+  using Base_ = Blender_base<Color>;
+
+public:
+  using Base_::Base_;
+
+  [[nodiscard]] Mask_mode mode() const noexcept
+  {
+    return mode_;
+  }
+
+  // Throws std::invalid_argument for Mask_mode::intersect.
+  void set_mode(Mask_mode const mode)
+  {
+    if(Mask_mode::intersect == mode)
+    {
+      throw ::std::invalid_argument(
+        "Mask_blender_a8 cannot intersect, use Blend_a8::multiply()");
+    }
+
+    mode_ = mode;
+  }
+
+  // Full coverage sets the mask value in replace and union modes, so a
+  // fully covered pixel never depends on what was there.
+  [[nodiscard]] bool is_opaque() const noexcept
+  {
+    return true;
+  }
+
+  void blend(Color const alpha) const noexcept
+  {
+    Color* const dst_alpha = pixel();
+    assert(dst_alpha);
+    if(Mask_mode::replace == mode_)
+    {
+      *dst_alpha = alpha;
+    }
+    else
+    {
+      *dst_alpha = Blend_a8::combine(*dst_alpha, alpha, mode_);
+    }
+  }
+
+  // Combines count pixels starting at the current one, each with its own
+  // coverage.
+  void blend_span(Color const* const coverage, Size const count) const noexcept
+  {
+    assert(pixel());
+    Blend_a8::blend_span(pixel(), coverage, count, mode_);
+  }
+
+  // Combines count pixels starting at the current one, all with the same
+  // coverage.
+  void blend_solid(Color const coverage, Size const count) const noexcept
+  {
+    assert(pixel());
+    Blend_a8::blend_solid(pixel(), coverage, count, mode_);
+  }
+
+private:
+  Mask_mode mode_ = Mask_mode::replace;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_MASKBLENDERA8_HH
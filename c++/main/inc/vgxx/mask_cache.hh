@@ -0,0 +1,342 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_MASKCACHE_HH
+#define VGXX_MASKCACHE_HH
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <vgxx/cell_processor.hh>
+#include <vgxx/damage_tracker.hh>
+#include <vgxx/fill_rule.hh>
+#include <vgxx/mask_blender_a8.hh>
+#include <vgxx/path.hh>
+#include <vgxx/pixel_box.hh>
+#include <vgxx/renderer.hh>
+#include <vgxx/util.hh>
+
+namespace vgxx
+{
+
+// Coverage mask cache for glyphs and icons. A path is rendered once per
+// key and subpixel phase into an 8-bit mask, and every occurrence after
+// that composites the mask through the blend_span() kernel of the target
+// blender. Masks are evicted in LRU order to stay within the byte budget.
+template<class K, class H = ::std::hash<K>>
+struct Mask_cache
+{
+  using Key = K;
+  using Hash = H;
+  using Int_32 = ::std::int32_t;
+  using Size = ::std::size_t;
+
+  static Int_32 constexpr subpixel_steps = 4;
+
+  Mask_cache(Mask_cache&&) = delete;
+  Mask_cache(Mask_cache const&) = delete;
+
+  explicit Mask_cache(Size const byte_budget = Size{4u} << 20u) :
+    mask_renderer_(1u, 1u, nullptr, Size{1u}),
+    byte_budget_(byte_budget),
+    byte_count_(0u),
+    hit_count_(0u),
+    miss_count_(0u)
+  {}
+
+  Mask_cache& operator =(Mask_cache&&) = delete;
+  Mask_cache& operator =(Mask_cache const&) = delete;
+
+  // Fills the path, given relative to its own origin, placed at (x, y).
+  // The key must identify the path and its size; the subpixel phase is
+  // added by the cache.
+  template<class Renderer>
+  Pixel_box fill(
+    Renderer& renderer,
+    Key const& key,
+    Path const& path,
+    float const x,
+    float const y,
+    Fill_rule const fill_rule)
+  {
+    Int_32 dx, dy, phase_x, phase_y;
+    Util::split_subpixel(x, subpixel_steps, dx, phase_x);
+    Util::split_subpixel(y, subpixel_steps, dy, phase_y);
+
+    Mask_ const* const mask = get_(key, path, phase_x, phase_y, fill_rule);
+    if(mask)
+    {
+      Pixel_box const box = composite_(
+        renderer.blender(),
+        static_cast<Int_32>(renderer.width()),
+        static_cast<Int_32>(renderer.height()),
+        *mask,
+        dx + mask->x,
+        dy + mask->y);
+
+      Damage_tracker* const damage_tracker = renderer.damage_tracker();
+      if(damage_tracker)
+      {
+        damage_tracker->add(box);
+      }
+
+      return box;
+    }
+
+    // Too large to be worth caching.
+    path.replay(renderer, x, y);
+    return renderer.fill(fill_rule);
+  }
+
+  [[nodiscard]] Size size() const noexcept
+  {
+    return entries_.size();
+  }
+
+  [[nodiscard]] Size byte_budget() const noexcept
+  {
+    return byte_budget_;
+  }
+
+  [[nodiscard]] Size byte_count() const noexcept
+  {
+    return byte_count_;
+  }
+
+  [[nodiscard]] Size hit_count() const noexcept
+  {
+    return hit_count_;
+  }
+
+  [[nodiscard]] Size miss_count() const noexcept
+  {
+    return miss_count_;
+  }
+
+  void clear() noexcept
+  {
+    index_.clear();
+    entries_.clear();
+    byte_count_ = 0u;
+  }
+
+private:
+  using Unt_8_ = ::std::uint8_t;
+  using Mask_renderer_ = Renderer<Mask_blender_a8, Cell_processor>;
+
+  template<class T>
+  using Vector_ = ::std::vector<T>;
+
+  struct Mask_
+  {
+    Int_32 x;
+    Int_32 y;
+    Int_32 width;
+    Int_32 height;
+    Vector_<Unt_8_> data;
+  };
+
+  struct Entry_key_
+  {
+    [[nodiscard]] bool operator ==(Entry_key_ const& other) const
+    {
+      return
+        phase_x == other.phase_x &&
+        phase_y == other.phase_y &&
+        key == other.key;
+    }
+
+    Key key;
+    Int_32 phase_x;
+    Int_32 phase_y;
+  };
+
+  struct Entry_key_hash_
+  {
+    [[nodiscard]] Size operator ()(Entry_key_ const& entry_key) const
+    {
+      auto const phase = static_cast<Size>(
+        entry_key.phase_y * subpixel_steps + entry_key.phase_x);
+      return Hash{}(entry_key.key) * 31u + phase;
+    }
+  };
+
+  struct Entry_
+  {
+    Entry_key_ key;
+    Mask_ mask;
+  };
+
+  using Entries_ = ::std::list<Entry_>;
+  using Index_ = ::std::unordered_map<
+    Entry_key_, typename Entries_::iterator, Entry_key_hash_>;
+
+  [[nodiscard]] Mask_ const* get_(
+    Key const& key,
+    Path const& path,
+    Int_32 const phase_x,
+    Int_32 const phase_y,
+    Fill_rule const fill_rule)
+  {
+    Entry_key_ entry_key{key, phase_x, phase_y};
+    auto const found = index_.find(entry_key);
+
+    if(index_.end() != found)
+    {
+      // Most recently used entries are kept at the front.
+      ++hit_count_;
+      entries_.splice(entries_.begin(), entries_, found->second);
+      return &found->second->mask;
+    }
+
+    ++miss_count_;
+    auto constexpr step = 1.f / static_cast<float>(subpixel_steps);
+    float const offset_x = static_cast<float>(phase_x) * step;
+    float const offset_y = static_cast<float>(phase_y) * step;
+    Mask_ mask{0, 0, 0, 0, {}};
+    auto const bounds = path.bounds();
+
+    if(bounds)
+    {
+      mask.x = static_cast<Int_32>(::std::floor(bounds.x_min + offset_x));
+      mask.y = static_cast<Int_32>(::std::floor(bounds.y_min + offset_y));
+      mask.width = static_cast<Int_32>(
+        ::std::ceil(bounds.x_max + offset_x)) - mask.x + 1;
+      mask.height = static_cast<Int_32>(
+        ::std::ceil(bounds.y_max + offset_y)) - mask.y + 1;
+
+      auto constexpr max_dimension =
+        static_cast<Int_32>(Cell_processor::max_dimension);
+      Size const byte_count =
+        static_cast<Size>(mask.width) * static_cast<Size>(mask.height);
+
+      if(
+        max_dimension < mask.width ||
+        max_dimension < mask.height ||
+        byte_budget_ < byte_count)
+      {
+        return nullptr;
+      }
+
+      mask.data.resize(byte_count);
+      mask_renderer_.resize(
+        static_cast<Cell_processor::Coord>(mask.width),
+        static_cast<Cell_processor::Coord>(mask.height));
+      mask_renderer_.blender().set_image(
+        mask.data.data(),
+        static_cast<Size>(mask.width));
+      path.replay(
+        mask_renderer_,
+        offset_x - static_cast<float>(mask.x),
+        offset_y - static_cast<float>(mask.y));
+      mask_renderer_.fill(fill_rule);
+
+      while(!entries_.empty() && byte_budget_ - byte_count < byte_count_)
+      {
+        byte_count_ -= entries_.back().mask.data.size();
+        index_.erase(entries_.back().key);
+        entries_.pop_back();
+      }
+
+      byte_count_ += byte_count;
+    }
+
+    entries_.push_front(Entry_{entry_key, ::std::move(mask)});
+    index_.emplace(::std::move(entry_key), entries_.begin());
+    return &entries_.front().mask;
+  }
+
+  // Returns the clipped bounds of the mask on the target.
+  template<class Blender>
+  static Pixel_box composite_(
+    Blender& blender,
+    Int_32 const width,
+    Int_32 const height,
+    Mask_ const& mask,
+    Int_32 const x,
+    Int_32 const y)
+  {
+    Int_32 const x_begin = 0 < x ? x : 0;
+    Int_32 const y_begin = 0 < y ? y : 0;
+    Int_32 x_end = x + mask.width;
+    Int_32 y_end = y + mask.height;
+
+    if(width < x_end)
+    {
+      x_end = width;
+    }
+    if(height < y_end)
+    {
+      y_end = height;
+    }
+
+    if(x_begin >= x_end || y_begin >= y_end)
+    {
+      return Pixel_box();
+    }
+
+    auto const count = static_cast<Size>(x_end - x_begin);
+    Unt_8_ const* row =
+      mask.data.data() +
+      static_cast<Size>(y_begin - y) * static_cast<Size>(mask.width) +
+      static_cast<Size>(x_begin - x);
+    blender.set_y(y_begin);
+
+    for(Int_32 row_y = y_begin;;)
+    {
+      blender.set_x(x_begin);
+      blender.blend_span(row, count);
+
+      if(y_end > ++row_y)
+      {
+        row += mask.width;
+        blender.inc_y();
+      }
+      else
+      {
+        break;
+      }
+    }
+
+    return Pixel_box(x_begin, y_begin, x_end - 1, y_end - 1);
+  }
+
+  Mask_renderer_ mask_renderer_;
+  Entries_ entries_;
+  Index_ index_;
+  Size const byte_budget_;
+  Size byte_count_;
+  Size hit_count_;
+  Size miss_count_;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_MASKCACHE_HH
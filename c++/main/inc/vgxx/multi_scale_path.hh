@@ -0,0 +1,310 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_MULTISCALEPATH_HH
+#define VGXX_MULTISCALEPATH_HH
+
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <vgxx/fill_rule.hh>
+#include <vgxx/pixel_box.hh>
+#include <vgxx/util.hh>
+
+namespace vgxx
+{
+
+// Outline that is flattened once and rendered at several scales. Curves
+// are subdivided as Renderer would subdivide them at the largest scale
+// the path is made for. Rendering at a smaller scale keeps an evenly
+// spaced subset of the curve points, as many as Renderer would generate
+// at that scale, so no curve is evaluated again. Targets must not be
+// larger than max_scale(): there would be too few points for them, which
+// is checked by an assertion rather than made up for by subdividing again.
+struct Multi_scale_path
+{
+  using Size = ::std::size_t;
+
+  // Sink with the scale and offset to play the path back at.
+  template<class Sink>
+  struct Target
+  {
+    Sink& sink;
+    float scale;
+    float dx;
+    float dy;
+  };
+
+  template<class Sink>
+  [[nodiscard]] static Target<Sink> target(
+    Sink& sink,
+    float const scale,
+    float const dx = 0.f,
+    float const dy = 0.f) noexcept
+  {
+    return Target<Sink>{sink, scale, dx, dy};
+  }
+
+  explicit Multi_scale_path(float const max_scale = 1.f) noexcept :
+    max_scale_(max_scale),
+    x_0_(0.f),
+    y_0_(0.f),
+    x_(0.f),
+    y_(0.f)
+  {
+    assert(0.f < max_scale);
+  }
+
+  [[nodiscard]] float max_scale() const noexcept
+  {
+    return max_scale_;
+  }
+
+  void move_to(float const x, float const y)
+  {
+    verbs_.push_back(Verb_::move_to);
+    coords_.push_back(x);
+    coords_.push_back(y);
+    x_0_ = x;
+    y_0_ = y;
+    x_ = x;
+    y_ = y;
+  }
+
+  void line_to(float const x, float const y)
+  {
+    verbs_.push_back(Verb_::line_to);
+    coords_.push_back(x);
+    coords_.push_back(y);
+    x_ = x;
+    y_ = y;
+  }
+
+  void bezier_to(
+    float const x_1,
+    float const y_1,
+    float const x_2,
+    float const y_2,
+    float const x_3,
+    float const y_3)
+  {
+    // Same length estimate as Util::subdivide_bezier().
+    float const length =
+      ::std::fabs(x_1 - x_) + ::std::fabs(y_1 - y_) +
+      ::std::fabs(x_2 - x_1) + ::std::fabs(y_2 - y_1) +
+      ::std::fabs(x_3 - x_2) + ::std::fabs(y_3 - y_2);
+    Size const coord_count = coords_.size();
+    float const s = max_scale_;
+    float const inv_s = 1.f / s;
+
+    Util::subdivide_bezier(
+      [this, inv_s](auto const& x, auto const& y)
+      {
+        coords_.push_back(x * inv_s);
+        coords_.push_back(y * inv_s);
+      },
+      x_ * s, y_ * s, x_1 * s, y_1 * s, x_2 * s, y_2 * s, x_3 * s, y_3 * s);
+
+    auto const point_count =
+      static_cast<Unt_32_>((coords_.size() - coord_count) / 2u);
+    if(0u < point_count)
+    {
+      // The last point is the end point exactly.
+      coords_[coords_.size() - 2u] = x_3;
+      coords_.back() = y_3;
+      verbs_.push_back(Verb_::curve);
+      curves_.push_back(Curve_{point_count, length});
+    }
+
+    x_ = x_3;
+    y_ = y_3;
+  }
+
+  void close_outline()
+  {
+    verbs_.push_back(Verb_::close_outline);
+    x_ = x_0_;
+    y_ = y_0_;
+  }
+
+  void clear() noexcept
+  {
+    verbs_.clear();
+    coords_.clear();
+    curves_.clear();
+    x_0_ = 0.f;
+    y_0_ = 0.f;
+    x_ = 0.f;
+    y_ = 0.f;
+  }
+
+  [[nodiscard]] bool empty() const noexcept
+  {
+    return verbs_.empty();
+  }
+
+  // Plays the path back into every target in a single pass over it. A
+  // target needs move_to/line_to/close_outline and a scale of at most
+  // max_scale().
+  template<class... Sinks>
+  void replay(Target<Sinks> const&... targets) const
+  {
+    assert(((max_scale_ >= targets.scale) && ...));
+
+    auto const* coord = coords_.data();
+    auto const* curve = curves_.data();
+
+    for(auto const verb : verbs_)
+    {
+      switch(verb)
+      {
+      case Verb_::move_to:
+        (move_to_(targets, coord[0], coord[1]), ...);
+        coord += 2;
+        break;
+      case Verb_::line_to:
+        (line_to_(targets, coord[0], coord[1]), ...);
+        coord += 2;
+        break;
+      case Verb_::curve:
+        (curve_to_(targets, coord, *curve), ...);
+        coord += 2u * curve->point_count;
+        ++curve;
+        break;
+      case Verb_::close_outline:
+        (targets.sink.close_outline(), ...);
+        break;
+      }
+    }
+  }
+
+  // Plays the path back into every target and fills it there. Returns the
+  // bounds of the pixels blended by each target.
+  template<class... Sinks>
+  auto fill(Fill_rule const fill_rule, Target<Sinks> const&... targets) const
+    -> ::std::array<Pixel_box, sizeof...(Sinks)>
+  {
+    replay(targets...);
+    return {{targets.sink.fill(fill_rule)...}};
+  }
+
+private:
+  using Unt_32_ = ::std::uint32_t;
+
+  enum class Verb_ : ::std::uint8_t
+  {
+    move_to,
+    line_to,
+    curve,
+    close_outline
+  };
+
+  // Flattened Bézier curve; its points follow in coords_.
+  struct Curve_
+  {
+    Unt_32_ point_count;
+    float length;
+  };
+
+  template<class T>
+  using Vector_ = ::std::vector<T>;
+
+  template<class Sink>
+  static void move_to_(
+    Target<Sink> const& target,
+    float const x,
+    float const y)
+  {
+    target.sink.move_to(
+      x * target.scale + target.dx,
+      y * target.scale + target.dy);
+  }
+
+  template<class Sink>
+  static void line_to_(
+    Target<Sink> const& target,
+    float const x,
+    float const y)
+  {
+    target.sink.line_to(
+      x * target.scale + target.dx,
+      y * target.scale + target.dy);
+  }
+
+  template<class Sink>
+  static void curve_to_(
+    Target<Sink> const& target,
+    float const* const coords,
+    Curve_ const& curve)
+  {
+    Unt_32_ const point_count = curve.point_count;
+    auto step_count =
+      static_cast<Unt_32_>(::std::ceil(curve.length * target.scale * 0.25f));
+    if(4u > step_count)
+    {
+      step_count = 4u;
+    }
+
+    if(point_count <= step_count)
+    {
+      for(Unt_32_ i = 0u; point_count > i; ++i)
+      {
+        line_to_(target, coords[2u * i], coords[2u * i + 1u]);
+      }
+    }
+    else
+    {
+      // Keeps point i when i * step_count / point_count steps up; the last
+      // point always does.
+      using Unt_64_ = ::std::uint64_t;
+      Unt_64_ kept = 0u;
+      for(Unt_32_ i = 0u; point_count > i; ++i)
+      {
+        Unt_64_ const keep =
+          (Unt_64_{i} + 1u) * step_count / point_count;
+        if(kept < keep)
+        {
+          kept = keep;
+          line_to_(target, coords[2u * i], coords[2u * i + 1u]);
+        }
+      }
+    }
+  }
+
+  Vector_<Verb_> verbs_;
+  Vector_<float> coords_;
+  Vector_<Curve_> curves_;
+  float max_scale_;
+  float x_0_;
+  float y_0_;
+  float x_;
+  float y_;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_MULTISCALEPATH_HH
@@ -0,0 +1,70 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_OFFSETBLENDER_HH
+#define VGXX_OFFSETBLENDER_HH
+
+#include <cstdint>
+
+namespace vgxx
+{
+
+// Blender adaptor for cell processors that cover only a part of the
+// canvas, such as a band or a tile. Adds the origin of that part to the
+// coordinates the swipe passes in.
+template<class B>
+struct Offset_blender : B
+{
+  using Blender = B;
+  using Int_32 = ::std::int32_t;
+
+  explicit Offset_blender(
+    Blender const& blender,
+    Int_32 const x_0,
+    Int_32 const y_0) :
+    Blender(blender),
+    x_0_(x_0),
+    y_0_(y_0)
+  {}
+
+  template<class X>
+  void set_x(X const& x) noexcept
+  {
+    Blender::set_x(static_cast<Int_32>(x) + x_0_);
+  }
+
+  template<class Y>
+  void set_y(Y const& y) noexcept
+  {
+    Blender::set_y(static_cast<Int_32>(y) + y_0_);
+  }
+
+private:
+  Int_32 x_0_;
+  Int_32 y_0_;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_OFFSETBLENDER_HH
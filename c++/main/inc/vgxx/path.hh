@@ -0,0 +1,190 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_PATH_HH
+#define VGXX_PATH_HH
+
+#include <cstdint>
+#include <vector>
+
+namespace vgxx
+{
+
+// Retained outline. Records the same commands Renderer accepts and plays
+// them back into anything that has move_to/line_to/bezier_to/close_outline.
+struct Path
+{
+  struct Bounds
+  {
+    [[nodiscard]] explicit operator bool() const noexcept
+    {
+      return x_min <= x_max && y_min <= y_max;
+    }
+
+    float x_min;
+    float y_min;
+    float x_max;
+    float y_max;
+  };
+
+  void move_to(float const x, float const y)
+  {
+    verbs_.push_back(Verb_::move_to);
+    coords_.push_back(x);
+    coords_.push_back(y);
+  }
+
+  void line_to(float const x, float const y)
+  {
+    verbs_.push_back(Verb_::line_to);
+    coords_.push_back(x);
+    coords_.push_back(y);
+  }
+
+  void bezier_to(
+    float const x_1,
+    float const y_1,
+    float const x_2,
+    float const y_2,
+    float const x_3,
+    float const y_3)
+  {
+    verbs_.push_back(Verb_::bezier_to);
+    coords_.push_back(x_1);
+    coords_.push_back(y_1);
+    coords_.push_back(x_2);
+    coords_.push_back(y_2);
+    coords_.push_back(x_3);
+    coords_.push_back(y_3);
+  }
+
+  void close_outline()
+  {
+    verbs_.push_back(Verb_::close_outline);
+  }
+
+  void clear() noexcept
+  {
+    verbs_.clear();
+    coords_.clear();
+  }
+
+  [[nodiscard]] bool empty() const noexcept
+  {
+    return verbs_.empty();
+  }
+
+  // Bounds of all points including Bézier control points, which contain
+  // the curves.
+  [[nodiscard]] Bounds bounds() const noexcept
+  {
+    Bounds bounds{1.f, 1.f, 0.f, 0.f};
+    auto const* coord = coords_.data();
+    auto const* const coords_end = coord + coords_.size();
+
+    if(coords_end != coord)
+    {
+      bounds = Bounds{coord[0], coord[1], coord[0], coord[1]};
+
+      for(; coords_end != coord; coord += 2)
+      {
+        if(bounds.x_min > coord[0])
+        {
+          bounds.x_min = coord[0];
+        }
+        if(bounds.x_max < coord[0])
+        {
+          bounds.x_max = coord[0];
+        }
+        if(bounds.y_min > coord[1])
+        {
+          bounds.y_min = coord[1];
+        }
+        if(bounds.y_max < coord[1])
+        {
+          bounds.y_max = coord[1];
+        }
+      }
+    }
+
+    return bounds;
+  }
+
+  template<class Sink>
+  void replay(Sink&& sink) const
+  {
+    replay(static_cast<Sink&&>(sink), 0.f, 0.f);
+  }
+
+  // Plays the path back translated by (dx, dy).
+  template<class Sink>
+  void replay(Sink&& sink, float const dx, float const dy) const
+  {
+    auto const* coord = coords_.data();
+
+    for(auto const verb : verbs_)
+    {
+      switch(verb)
+      {
+      case Verb_::move_to:
+        static_cast<Sink&&>(sink).move_to(coord[0] + dx, coord[1] + dy);
+        coord += 2;
+        break;
+      case Verb_::line_to:
+        static_cast<Sink&&>(sink).line_to(coord[0] + dx, coord[1] + dy);
+        coord += 2;
+        break;
+      case Verb_::bezier_to:
+        static_cast<Sink&&>(sink).bezier_to(
+          coord[0] + dx, coord[1] + dy,
+          coord[2] + dx, coord[3] + dy,
+          coord[4] + dx, coord[5] + dy);
+        coord += 6;
+        break;
+      case Verb_::close_outline:
+        static_cast<Sink&&>(sink).close_outline();
+        break;
+      }
+    }
+  }
+
+private:
+  enum class Verb_ : ::std::uint8_t
+  {
+    move_to,
+    line_to,
+    bezier_to,
+    close_outline
+  };
+
+  template<class T>
+  using Vector_ = ::std::vector<T>;
+
+  Vector_<Verb_> verbs_;
+  Vector_<float> coords_;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_PATH_HH
@@ -0,0 +1,320 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_PIPELINEDRENDERER_HH
+#define VGXX_PIPELINEDRENDERER_HH
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <vgxx/cell_processor.hh>
+#include <vgxx/damage_tracker.hh>
+#include <vgxx/fill_rule.hh>
+#include <vgxx/renderer.hh>
+
+namespace vgxx
+{
+
+// Renderer that swipes on a worker thread. While the worker blends path N
+// into the target, the caller flattens and rasterizes path N + 1 into the
+// next slot. Slots are handed over in order through a lock-free
+// single-producer single-consumer ring, so draw order is preserved.
+//
+// The blender state current at fill() time is captured with the outline.
+// The target must not be read before finish() returns. Every outline
+// should start with move_to(), because each slot keeps its own pen.
+template<class B, class P = Cell_processor>
+struct Pipelined_renderer
+{
+  using Blender = B;
+  using Cell_processor = P;
+  using Coord = typename Cell_processor::Coord;
+  using Size = ::std::size_t;
+
+  static Size constexpr slot_count = 2u;
+
+private:
+  template<class T, class... Args>
+  using Is_constructible_ = typename ::std::is_constructible<T, Args...>::type;
+
+  template<bool, class = void>
+  struct Enable_if_
+  {};
+
+  template<class T>
+  struct Enable_if_<true, T>
+  {
+    using Type = T;
+  };
+
+public:
+  template<
+    class... Blender_args,
+    bool e = Is_constructible_<Blender, Blender_args const&...>::value,
+    class = typename Enable_if_<e>::Type>
+  explicit Pipelined_renderer(
+    Coord const width,
+    Coord const height,
+    Blender_args const&... blender_args) :
+    blender_(blender_args...),
+    head_(0u),
+    produced_(0u),
+    consumed_(0u),
+    worker_sleeping_(false),
+    stopped_(false)
+  {
+    slots_.reserve(slot_count);
+    for(Size i = 0u; slot_count > i; ++i)
+    {
+      slots_.push_back(
+        Slot_{Renderer_(width, height, blender_args...), Fill_rule::non_zero});
+    }
+
+    worker_ = Thread_([this]() noexcept
+      {
+        work_();
+      });
+  }
+
+  Pipelined_renderer(Pipelined_renderer&&) = delete;
+  Pipelined_renderer(Pipelined_renderer const&) = delete;
+
+  ~Pipelined_renderer()
+  {
+    {
+      Lock_ lock(mutex_);
+      stopped_.store(true);
+    }
+
+    condition_.notify_one();
+    worker_.join();
+  }
+
+  Pipelined_renderer& operator =(Pipelined_renderer&&) = delete;
+  Pipelined_renderer& operator =(Pipelined_renderer const&) = delete;
+
+  [[nodiscard]] Blender& blender() noexcept
+  {
+    return blender_;
+  }
+
+  [[nodiscard]] Blender const& blender() const noexcept
+  {
+    return blender_;
+  }
+
+  // The tracker is updated from the worker thread, so read it and change
+  // it only after finish().
+  void set_damage_tracker(Damage_tracker* const damage_tracker) noexcept
+  {
+    assert(produced_.load() == consumed_.load());
+    for(auto& slot : slots_)
+    {
+      slot.renderer.set_damage_tracker(damage_tracker);
+    }
+  }
+
+  void move_to(float const x, float const y) noexcept
+  {
+    head_renderer_().move_to(x, y);
+  }
+
+  void line_to(float const x, float const y) noexcept
+  {
+    head_renderer_().line_to(x, y);
+  }
+
+  void bezier_to(
+    float const x_1,
+    float const y_1,
+    float const x_2,
+    float const y_2,
+    float const x_3,
+    float const y_3) noexcept
+  {
+    head_renderer_().bezier_to(x_1, y_1, x_2, y_2, x_3, y_3);
+  }
+
+  void close_outline() noexcept
+  {
+    head_renderer_().close_outline();
+  }
+
+  // Queues the current outline and returns as soon as the next slot is
+  // free for rasterization.
+  void fill(Fill_rule const fill_rule)
+  {
+    auto& slot = slots_[head_];
+    slot.renderer.close_outline();
+    slot.renderer.blender() = blender_;
+    slot.fill_rule = fill_rule;
+
+    auto const produced = produced_.load(::std::memory_order_relaxed) + 1u;
+    produced_.store(produced);
+    if(worker_sleeping_.load())
+    {
+      Lock_ lock(mutex_);
+      condition_.notify_one();
+    }
+
+    head_ = static_cast<Size>(produced % slot_count);
+    while(
+      slot_count <= produced - consumed_.load(::std::memory_order_acquire))
+    {
+      ::std::this_thread::yield();
+    }
+  }
+
+  // Waits until every queued fill has been blended. Rethrows the first
+  // exception thrown on the worker thread.
+  void finish()
+  {
+    auto const produced = produced_.load(::std::memory_order_relaxed);
+    while(consumed_.load(::std::memory_order_acquire) != produced)
+    {
+      ::std::this_thread::yield();
+    }
+
+    if(error_)
+    {
+      ::std::exception_ptr error;
+      error.swap(error_);
+      ::std::rethrow_exception(error);
+    }
+  }
+
+  // Finishes pending fills and changes the canvas size of every slot,
+  // which also drops the damage tracker.
+  void resize(Coord const width, Coord const height)
+  {
+    finish();
+    for(auto& slot : slots_)
+    {
+      slot.renderer.resize(width, height);
+    }
+  }
+
+private:
+  using Renderer_ = Renderer<Blender, Cell_processor>;
+  using Counter_ = ::std::atomic<::std::uint64_t>;
+  using Flag_ = ::std::atomic<bool>;
+  using Mutex_ = ::std::mutex;
+  using Lock_ = ::std::unique_lock<Mutex_>;
+  using Condition_ = ::std::condition_variable;
+  using Thread_ = ::std::thread;
+
+  template<class T>
+  using Vector_ = ::std::vector<T>;
+
+  struct Slot_
+  {
+    Renderer_ renderer;
+    Fill_rule fill_rule;
+  };
+
+  static unsigned constexpr spin_count_ = 256u;
+
+  [[nodiscard]] Renderer_& head_renderer_() noexcept
+  {
+    return slots_[head_].renderer;
+  }
+
+  void work_() noexcept
+  {
+    ::std::uint64_t consumed = 0u;
+
+    for(;;)
+    {
+      if(!wait_for_slot_(consumed))
+      {
+        break;
+      }
+
+      auto& slot = slots_[static_cast<Size>(consumed % slot_count)];
+      if(!error_)
+      {
+        try
+        {
+          slot.renderer.fill(slot.fill_rule);
+        }
+        catch(...)
+        {
+          error_ = ::std::current_exception();
+        }
+      }
+
+      consumed_.store(++consumed, ::std::memory_order_release);
+    }
+  }
+
+  // Spins for a while before going to sleep. Returns false once the
+  // renderer is being destroyed and the queue is drained.
+  [[nodiscard]] bool wait_for_slot_(::std::uint64_t const consumed) noexcept
+  {
+    for(unsigned i = 0u; spin_count_ > i; ++i)
+    {
+      if(produced_.load(::std::memory_order_acquire) != consumed)
+      {
+        return true;
+      }
+
+      ::std::this_thread::yield();
+    }
+
+    Lock_ lock(mutex_);
+    worker_sleeping_.store(true);
+    condition_.wait(lock, [this, consumed]() noexcept
+      {
+        return produced_.load() != consumed || stopped_.load();
+      });
+    worker_sleeping_.store(false);
+
+    return produced_.load() != consumed;
+  }
+
+  Vector_<Slot_> slots_;
+  Blender blender_;
+  ::std::exception_ptr error_;
+  Size head_;
+  alignas(64) Counter_ produced_;
+  alignas(64) Counter_ consumed_;
+  Flag_ worker_sleeping_;
+  Flag_ stopped_;
+  Mutex_ mutex_;
+  Condition_ condition_;
+  Thread_ worker_;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_PIPELINEDRENDERER_HH
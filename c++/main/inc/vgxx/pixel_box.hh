@@ -0,0 +1,114 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_PIXELBOX_HH
+#define VGXX_PIXELBOX_HH
+
+#include <cstdint>
+#include <limits>
+
+namespace vgxx
+{
+
+// Inclusive pixel bounds. Default constructed boxes are empty.
+struct Pixel_box
+{
+  using Int_32 = ::std::int32_t;
+
+  Pixel_box() noexcept :
+    x_min(int_32_max_),
+    y_min(int_32_max_),
+    x_max(int_32_min_),
+    y_max(int_32_min_)
+  {}
+
+  explicit Pixel_box(
+    Int_32 const box_x_min,
+    Int_32 const box_y_min,
+    Int_32 const box_x_max,
+    Int_32 const box_y_max) noexcept :
+    x_min(box_x_min),
+    y_min(box_y_min),
+    x_max(box_x_max),
+    y_max(box_y_max)
+  {}
+
+  [[nodiscard]] explicit operator bool() const noexcept
+  {
+    return x_min <= x_max && y_min <= y_max;
+  }
+
+  void reset() noexcept
+  {
+    *this = Pixel_box();
+  }
+
+  // Extends the box by pixels x_min..x_max of row y.
+  void add_row(
+    Int_32 const y,
+    Int_32 const row_x_min,
+    Int_32 const row_x_max) noexcept
+  {
+    if(y < y_min)
+    {
+      y_min = y;
+    }
+    if(y > y_max)
+    {
+      y_max = y;
+    }
+    if(row_x_min < x_min)
+    {
+      x_min = row_x_min;
+    }
+    if(row_x_max > x_max)
+    {
+      x_max = row_x_max;
+    }
+  }
+
+  void unite(Pixel_box const& other) noexcept
+  {
+    if(other)
+    {
+      add_row(other.y_min, other.x_min, other.x_max);
+      add_row(other.y_max, other.x_min, other.x_max);
+    }
+  }
+
+  Int_32 x_min;
+  Int_32 y_min;
+  Int_32 x_max;
+  Int_32 y_max;
+
+private:
+  using Int_32_limits_ = ::std::numeric_limits<Int_32>;
+
+  static Int_32 constexpr int_32_min_ = Int_32_limits_::min();
+  static Int_32 constexpr int_32_max_ = Int_32_limits_::max();
+};
+
+} // namespace vgxx
+
+#endif // VGXX_PIXELBOX_HH
@@ -25,6 +25,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define VGXX_RASTERIZER_HH
 
 #include <cstdint>
+#include <limits>
 #include <type_traits>
 
 #include <vgxx/util.hh>
@@ -35,6 +36,7 @@ namespace vgxx
 class Rasterizer
 {
   using Unt_32_ = ::std::uint32_t;
+  using Int_64_ = ::std::int64_t;
   using Unt_64_ = ::std::uint64_t;
 
   template<class T>
@@ -108,6 +110,37 @@ public:
     y_ = y;
   }
 
+  // Adds a single line without moving the pen.
+  template<class Cell_processor>
+  void add_line_fixed_24_dot_8(
+    Cell_processor&& cell_proc,
+    Int_32 const x_0,
+    Int_32 const y_0,
+    Int_32 const x_1,
+    Int_32 const y_1)
+  {
+    add_line_(static_cast<Cell_processor&&>(cell_proc), x_0, y_0, x_1, y_1);
+  }
+
+  // Adds only the part of a line within pixel rows row_min..row_max. The
+  // cells are exactly those the whole line gives in these rows: the rows
+  // before the range are stepped over in one go, not re-computed from a
+  // clipped line, whose rounding would differ.
+  template<class Cell_processor>
+  void add_line_fixed_24_dot_8(
+    Cell_processor&& cell_proc,
+    Int_32 const x_0,
+    Int_32 const y_0,
+    Int_32 const x_1,
+    Int_32 const y_1,
+    Int_32 const row_min,
+    Int_32 const row_max)
+  {
+    add_line_(
+      static_cast<Cell_processor&&>(cell_proc),
+      x_0, y_0, x_1, y_1, row_min, row_max);
+  }
+
   template<typename Cell_processor>
   void close(Cell_processor&& cell_proc)
   {
@@ -131,13 +164,20 @@ private:
     negative
   };
 
+  using Int_32_limits_ = ::std::numeric_limits<Int_32>;
+
+  static Int_32 constexpr int_32_min_ = Int_32_limits_::min();
+  static Int_32 constexpr int_32_max_ = Int_32_limits_::max();
+
   template<class Cell_processor>
   void add_line_(
     Cell_processor&& cell_proc,
     Int_32 const x_0,
     Int_32 const y_0,
     Int_32 const x_1,
-    Int_32 const y_1)
+    Int_32 const y_1,
+    Int_32 const row_min = int_32_min_,
+    Int_32 const row_max = int_32_max_)
   {
     if(y_0 == y_1)
     {
@@ -158,11 +198,14 @@ private:
 
       if(int_y_0 == int_y_1)
       {
-        cover = frac_y_1 - frac_y_0;
-        area = (cover * frac_x) << 1;
-        static_cast<Cell_processor&&>(cell_proc).set_x(int_x);
-        static_cast<Cell_processor&&>(cell_proc).set_y(int_y_0);
-        static_cast<Cell_processor&&>(cell_proc).set_cell(cover, area);
+        if(row_min <= int_y_0 && row_max >= int_y_0)
+        {
+          cover = frac_y_1 - frac_y_0;
+          area = (cover * frac_x) << 1;
+          static_cast<Cell_processor&&>(cell_proc).set_x(int_x);
+          static_cast<Cell_processor&&>(cell_proc).set_y(int_y_0);
+          static_cast<Cell_processor&&>(cell_proc).set_cell(cover, area);
+        }
         return;
       }
 
@@ -170,15 +213,18 @@ private:
       {
         if(frac_y_0)
         {
-          cover = 0x100 - frac_y_0;
-          area = (cover * frac_x) << 1u;
-          static_cast<Cell_processor&&>(cell_proc).set_x(int_x);
-          static_cast<Cell_processor&&>(cell_proc).set_y(int_y_0);
-          static_cast<Cell_processor&&>(cell_proc).set_cell(cover, area);
+          if(row_min <= int_y_0 && row_max >= int_y_0)
+          {
+            cover = 0x100 - frac_y_0;
+            area = (cover * frac_x) << 1u;
+            static_cast<Cell_processor&&>(cell_proc).set_x(int_x);
+            static_cast<Cell_processor&&>(cell_proc).set_y(int_y_0);
+            static_cast<Cell_processor&&>(cell_proc).set_cell(cover, area);
+          }
           ++int_y_0;
         }
 
-        if(frac_y_1)
+        if(frac_y_1 && row_min <= int_y_1 && row_max >= int_y_1)
         {
           cover = frac_y_1;
           area = (cover * frac_x) << 1u;
@@ -192,7 +238,7 @@ private:
       }
       else
       {
-        if(frac_y_0)
+        if(frac_y_0 && row_min <= int_y_0 && row_max >= int_y_0)
         {
           cover = -frac_y_0;
           area = (cover * frac_x) << 1u;
@@ -203,11 +249,14 @@ private:
 
         if(frac_y_1)
         {
-          cover = frac_y_1 - 0x100;
-          area = (cover * frac_x) << 1u;
-          static_cast<Cell_processor&&>(cell_proc).set_x(int_x);
-          static_cast<Cell_processor&&>(cell_proc).set_y(int_y_1);
-          static_cast<Cell_processor&&>(cell_proc).set_cell(cover, area);
+          if(row_min <= int_y_1 && row_max >= int_y_1)
+          {
+            cover = frac_y_1 - 0x100;
+            area = (cover * frac_x) << 1u;
+            static_cast<Cell_processor&&>(cell_proc).set_x(int_x);
+            static_cast<Cell_processor&&>(cell_proc).set_y(int_y_1);
+            static_cast<Cell_processor&&>(cell_proc).set_cell(cover, area);
+          }
           ++int_y_1;
         }
 
@@ -219,6 +268,15 @@ private:
         area = -(frac_x << 9u);  // (cover * fracX) * 2
       }
 
+      if(row_min > int_y_0)
+      {
+        int_y_0 = row_min;
+      }
+      if(row_max < int_y_1 - 1)
+      {
+        int_y_1 = row_max + 1;
+      }
+
       while(int_y_0 < int_y_1)
       {
         static_cast<Cell_processor&&>(cell_proc).set_x(int_x);
@@ -239,7 +297,7 @@ private:
           Direction_::positive,
           Direction_::positive>(
           static_cast<Cell_processor&&>(cell_proc),
-          x_0, y_0, x_1, y_1);
+          x_0, y_0, x_1, y_1, row_min, row_max);
       }
       else
       {
@@ -248,7 +306,7 @@ private:
           Direction_::negative,
           Direction_::negative>(
           static_cast<Cell_processor&&>(cell_proc),
-          x_1, y_1, x_0, y_0);
+          x_1, y_1, x_0, y_0, row_min, row_max);
       }
     }
     else
@@ -260,7 +318,7 @@ private:
           Direction_::positive,
           Direction_::negative>(
           static_cast<Cell_processor&&>(cell_proc),
-          x_0, y_0, x_1, y_1);
+          x_0, y_0, x_1, y_1, row_min, row_max);
       }
       else
       {
@@ -269,7 +327,7 @@ private:
           Direction_::negative,
           Direction_::positive>(
           static_cast<Cell_processor&&>(cell_proc),
-          x_1, y_1, x_0, y_0);
+          x_1, y_1, x_0, y_0, row_min, row_max);
       }
     }
   }
@@ -284,7 +342,9 @@ private:
     Int_32 const x_0,
     Int_32 const y_0,
     Int_32 const x_1,
-    Int_32 const y_1)
+    Int_32 const y_1,
+    Int_32 const row_min,
+    Int_32 const row_max)
   {
     Int_32 int_x_0 = x_0 >> 8u;
     Int_32 int_x_1 = x_1 >> 8u;
@@ -293,6 +353,11 @@ private:
     Int_32 frac_x_0 = x_0 & 0xff;
     Int_32 frac_x_1 = x_1 & 0xff;
 
+    if(row_min > int_y_1 || row_max < int_y_0)
+    {
+      return;
+    }
+
     if(int_y_0 == int_y_1)
     {
       // Only one scanline is involved.
@@ -372,17 +437,20 @@ private:
       int_x = x >> 8u;
       frac_x = x & 0xff;
 
-      if constexpr(Direction_::positive == x_y_direction)
-      {
-        add_scanline_<y_direction>(
-          static_cast<Cell_processor&&>(cell_proc),
-          int_y_0, int_x_0, int_x, frac_x_0, frac_x, x - x_0, delta_y);
-      }
-      else
+      if(row_min <= int_y_0)
       {
-        add_scanline_<y_direction>(
-          static_cast<Cell_processor&&>(cell_proc),
-          int_y_0, int_x, int_x_0, frac_x, frac_x_0, x_0 - x, delta_y);
+        if constexpr(Direction_::positive == x_y_direction)
+        {
+          add_scanline_<y_direction>(
+            static_cast<Cell_processor&&>(cell_proc),
+            int_y_0, int_x_0, int_x, frac_x_0, frac_x, x - x_0, delta_y);
+        }
+        else
+        {
+          add_scanline_<y_direction>(
+            static_cast<Cell_processor&&>(cell_proc),
+            int_y_0, int_x, int_x_0, frac_x, frac_x_0, x_0 - x, delta_y);
+        }
       }
 
       ++int_y;
@@ -428,9 +496,44 @@ private:
         annex = -1;
       }
 
+      if(row_min > int_y)
+      {
+        // Step over the rows before the range at once: k rows add k * mod
+        // to the remainder, and every d_y of it is one more annex.
+        Int_64_ rows = static_cast<Int_64_>(row_min) - int_y;
+        if(int_y_1 - int_y < rows)
+        {
+          rows = int_y_1 - int_y;
+        }
+
+        Unt_64_ const rem_total = rem + static_cast<Unt_64_>(rows) * mod;
+        Int_64_ const step = rows * inc_x +
+          static_cast<Int_64_>(rem_total / d_y) * annex;
+        rem = static_cast<Unt_32_>(rem_total % d_y);
+
+        if constexpr(Direction_::positive == x_y_direction)
+        {
+          x += static_cast<Int_32>(step);
+        }
+        else
+        {
+          x -= static_cast<Int_32>(step);
+        }
+
+        int_x = x >> 8u;
+        frac_x = x & 0xff;
+        int_y += static_cast<Int_32>(rows);
+      }
+
+      Int_32 int_y_end = int_y_1;
+      if(row_max < int_y_end - 1)
+      {
+        int_y_end = row_max + 1;
+      }
+
       Int_32 cover, area;
 
-      do
+      while(int_y < int_y_end)
       {
         delta_x = inc_x;
         rem += mod;
@@ -624,10 +727,9 @@ private:
         frac_x = frac_next_x;
         ++int_y;
       }
-      while(int_y < int_y_1);
     }
 
-    if(frac_y_1)
+    if(frac_y_1 && row_max >= int_y_1)
     {
       if constexpr(Direction_::positive == x_y_direction)
       {
@@ -28,7 +28,10 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <cstdint>
 #include <type_traits>
 
+#include <vgxx/cell_list.hh>
+#include <vgxx/damage_tracker.hh>
 #include <vgxx/fill_rule.hh>
+#include <vgxx/pixel_box.hh>
 #include <vgxx/rasterizer.hh>
 #include <vgxx/cell_processor.hh>
 #include <vgxx/util.hh>
@@ -36,10 +39,13 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 namespace vgxx
 {
 
-template<class B>
+template<class B, class P = Cell_processor>
 struct Renderer
 {
   using Blender = B;
+  using Cell_processor = P;
+  using Coord = typename Cell_processor::Coord;
+  using Int_32 = ::std::int32_t;
   using Unt_16 = ::std::uint16_t;
 
 private:
@@ -64,11 +70,12 @@ public:
     bool e = Is_constructible_<Blender, Blebder_args...>::value,
     class = typename Enable_if_<e>::Type>
   explicit Renderer(
-    Unt_16 const width,
-    Unt_16 const height,
+    Coord const width,
+    Coord const height,
     Blebder_args&&... blender_args) :
     cell_proc_(width, height),
     blender_(static_cast<Blebder_args&&>(blender_args)...),
+    damage_tracker_(nullptr),
     //height_(static_cast<float>(height)),
     //width_(static_cast<float>(width)),
     x_0_(0.f),
@@ -82,6 +89,16 @@ public:
     assert(0u < height);
   }
 
+  [[nodiscard]] Coord width() const noexcept
+  {
+    return cell_proc_.width();
+  }
+
+  [[nodiscard]] Coord height() const noexcept
+  {
+    return cell_proc_.height();
+  }
+
   [[nodiscard]] Blender& blender() noexcept
   {
     return blender_;
@@ -92,6 +109,24 @@ public:
     return blender_;
   }
 
+  // Discards the current outline and changes the canvas size, reusing the
+  // memory the cell processor has already allocated. The blender keeps
+  // its target, so point it at the new image as well. The damage tracker
+  // is dropped, as it was collecting rows of the old image.
+  void resize(Coord const width, Coord const height)
+  {
+    assert(0u < width);
+    assert(0u < height);
+
+    cell_proc_.resize(width, height);
+    rasterizer_.reset();
+    damage_tracker_ = nullptr;
+    x_0_ = 0.f;
+    y_0_ = 0.f;
+    x_ = 0.f;
+    y_ = 0.f;
+  }
+
   void move_to(float const x, float const y) noexcept
   {
     rasterizer_.move_to(cell_proc_, x, y);
@@ -172,26 +207,91 @@ public:
     //clip_flags_ = clip_flags_0_;
   }
 
+  // Fills the current outline and returns the bounds of the pixels it
+  // has blended.
   template<Fill_rule fill_rule>
-  void fill()
+  Pixel_box fill()
+  {
+    close_outline();
+    return swipe_<fill_rule>();
+  }
+
+  Pixel_box fill(Fill_rule const fill_rule)
   {
     close_outline();
-    cell_proc_.swipe<fill_rule>(blender_);
+    return swipe_(fill_rule);
   }
 
-  void fill(Fill_rule const fill_rule)
+  // Fills retained cells translated by whole pixels, without rasterizing
+  // them again.
+  template<Fill_rule fill_rule>
+  Pixel_box fill(Cell_list const& cells, Int_32 const dx, Int_32 const dy)
   {
     close_outline();
-    cell_proc_.swipe(blender_, fill_rule);
+    cells.replay(cell_proc_, dx, dy);
+    return swipe_<fill_rule>();
+  }
+
+  Pixel_box fill(
+    Cell_list const& cells,
+    Int_32 const dx,
+    Int_32 const dy,
+    Fill_rule const fill_rule)
+  {
+    close_outline();
+    cells.replay(cell_proc_, dx, dy);
+    return swipe_(fill_rule);
+  }
+
+  [[nodiscard]] Damage_tracker* damage_tracker() const noexcept
+  {
+    return damage_tracker_;
+  }
+
+  // Every subsequent fill adds the rows it touches to the tracker. Pass
+  // nullptr to stop tracking.
+  void set_damage_tracker(Damage_tracker* const damage_tracker) noexcept
+  {
+    damage_tracker_ = damage_tracker;
   }
 
 private:
+  struct Damage_
+  {
+    void add_row(Int_32 const y, Int_32 const x_min, Int_32 const x_max)
+    {
+      box.add_row(y, x_min, x_max);
+      if(tracker)
+      {
+        tracker->add_row(y, x_min, x_max);
+      }
+    }
+
+    Pixel_box box;
+    Damage_tracker* tracker;
+  };
+
   template<class T>
   void line_to_(T const& x, T const& y) noexcept
   {
     rasterizer_.line_to(cell_proc_, x, y);
   }
 
+  template<Fill_rule fill_rule>
+  Pixel_box swipe_()
+  {
+    Damage_ damage{Pixel_box(), damage_tracker_};
+    cell_proc_.template swipe<fill_rule>(blender_, damage);
+    return damage.box;
+  }
+
+  Pixel_box swipe_(Fill_rule const fill_rule)
+  {
+    Damage_ damage{Pixel_box(), damage_tracker_};
+    cell_proc_.swipe(blender_, fill_rule, damage);
+    return damage.box;
+  }
+
   /*
   template<class T>
   [[nodiscard]] Clip_flags_ compute_clip_flags_(
@@ -224,6 +324,7 @@ private:
   Rasterizer rasterizer_;
   Cell_processor cell_proc_;
   Blender blender_;
+  Damage_tracker* damage_tracker_;
   //float height_;
   //float width_;
   float x_0_;
@@ -234,6 +335,9 @@ private:
   //Clip_flags_ clip_flags_;
 };
 
+template<class B>
+using Large_renderer = Renderer<B, Large_cell_processor>;
+
 } // namespace vgxx
 
 #endif // VGXX_RENDERER_HH
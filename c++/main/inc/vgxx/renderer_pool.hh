@@ -0,0 +1,163 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef VGXX_RENDERERPOOL_HH
+#define VGXX_RENDERERPOOL_HH
+
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace vgxx
+{
+
+// Keeps renderers that have already been used so that their rows and
+// cell stash are warm when they are handed out again. Safe to share
+// between threads.
+template<class R>
+struct Renderer_pool
+{
+  using Renderer = R;
+  using Blender = typename Renderer::Blender;
+  using Coord = typename Renderer::Coord;
+  using Size = ::std::size_t;
+
+  // Owns a renderer for as long as it lives and gives it back to the pool
+  // on destruction.
+  struct Lease
+  {
+    Lease(Lease const&) = delete;
+
+    Lease(Lease&& other) noexcept :
+      pool_(other.pool_),
+      renderer_(::std::move(other.renderer_))
+    {
+      other.pool_ = nullptr;
+    }
+
+    ~Lease()
+    {
+      if(pool_)
+      {
+        pool_->release_(::std::move(renderer_));
+      }
+    }
+
+    Lease& operator =(Lease&&) = delete;
+    Lease& operator =(Lease const&) = delete;
+
+    [[nodiscard]] Renderer& operator *() noexcept
+    {
+      return renderer_;
+    }
+
+    [[nodiscard]] Renderer* operator ->() noexcept
+    {
+      return &renderer_;
+    }
+
+  private:
+    friend Renderer_pool;
+
+    explicit Lease(Renderer_pool& pool, Renderer&& renderer) noexcept :
+      pool_(&pool),
+      renderer_(::std::move(renderer))
+    {}
+
+    Renderer_pool* pool_;
+    Renderer renderer_;
+  };
+
+  Renderer_pool(Renderer_pool&&) = delete;
+  Renderer_pool(Renderer_pool const&) = delete;
+
+  explicit Renderer_pool(Size const max_idle_count = 16u) :
+    max_idle_count_(max_idle_count)
+  {
+    // Reserved up front so that returning a renderer never allocates.
+    idle_.reserve(max_idle_count);
+  }
+
+  Renderer_pool& operator =(Renderer_pool&&) = delete;
+  Renderer_pool& operator =(Renderer_pool const&) = delete;
+
+  // Hands out an idle renderer resized to the requested canvas, or
+  // constructs a new one if none is idle. Either way the renderer has a
+  // fresh blender and no damage tracker, whatever the previous lease set.
+  template<class... Blender_args>
+  [[nodiscard]] Lease acquire(
+    Coord const width,
+    Coord const height,
+    Blender_args&&... blender_args)
+  {
+    {
+      Lock_ lock(mutex_);
+      if(!idle_.empty())
+      {
+        Renderer renderer(::std::move(idle_.back()));
+        idle_.pop_back();
+        lock.unlock();
+
+        renderer.resize(width, height);
+        renderer.blender() =
+          Blender(static_cast<Blender_args&&>(blender_args)...);
+        return Lease(*this, ::std::move(renderer));
+      }
+    }
+
+    return Lease(
+      *this,
+      Renderer(width, height, static_cast<Blender_args&&>(blender_args)...));
+  }
+
+  [[nodiscard]] Size idle_count() const
+  {
+    Lock_ lock(mutex_);
+    return idle_.size();
+  }
+
+private:
+  using Mutex_ = ::std::mutex;
+  using Lock_ = ::std::unique_lock<Mutex_>;
+
+  template<class T>
+  using Vector_ = ::std::vector<T>;
+
+  void release_(Renderer&& renderer) noexcept
+  {
+    Lock_ lock(mutex_);
+    if(max_idle_count_ > idle_.size())
+    {
+      idle_.push_back(::std::move(renderer));
+    }
+  }
+
+  mutable Mutex_ mutex_;
+  Vector_<Renderer> idle_;
+  Size const max_idle_count_;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_RENDERERPOOL_HH
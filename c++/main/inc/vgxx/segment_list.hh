@@ -0,0 +1,332 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_SEGMENTLIST_HH
+#define VGXX_SEGMENTLIST_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <vgxx/rasterizer.hh>
+#include <vgxx/util.hh>
+
+namespace vgxx
+{
+
+// Outline flattened into 24.8 fixed-point lines. Accepts the same commands
+// as Renderer and produces exactly the lines Renderer would hand to its
+// rasterizer, so rasterizing the list gives bit-identical cells. Unlike a
+// Renderer, it can be rasterized any number of times, translated by whole
+// pixels and restricted to a range of rows.
+struct Segment_list
+{
+  using Int_32 = ::std::int32_t;
+  using Size = ::std::size_t;
+
+  struct Segment
+  {
+    Int_32 x_0;
+    Int_32 y_0;
+    Int_32 x_1;
+    Int_32 y_1;
+  };
+
+  Segment_list() noexcept :
+    fixed_x_0_(0),
+    fixed_y_0_(0),
+    fixed_x_(0),
+    fixed_y_(0),
+    x_min_(int_32_max_),
+    x_max_(int_32_min_),
+    y_min_(int_32_max_),
+    y_max_(int_32_min_),
+    x_0_(0.f),
+    y_0_(0.f),
+    x_(0.f),
+    y_(0.f)
+  {}
+
+  void move_to(float const x, float const y)
+  {
+    // Close the previous contour.
+    add_(fixed_x_, fixed_y_, fixed_x_0_, fixed_y_0_);
+    fixed_x_0_ = Util::to_fixed_24_dot_8(x);
+    fixed_y_0_ = Util::to_fixed_24_dot_8(y);
+    fixed_x_ = fixed_x_0_;
+    fixed_y_ = fixed_y_0_;
+    x_0_ = x;
+    y_0_ = y;
+    x_ = x;
+    y_ = y;
+  }
+
+  void line_to(float const x, float const y)
+  {
+    line_to_(x, y);
+    x_ = x;
+    y_ = y;
+  }
+
+  void bezier_to(
+    float const x_1,
+    float const y_1,
+    float const x_2,
+    float const y_2,
+    float const x_3,
+    float const y_3)
+  {
+    Util::subdivide_bezier(
+      [this](auto const& x, auto const& y)
+      {
+        line_to_(x, y);
+      },
+      x_, y_, x_1, y_1, x_2, y_2, x_3, y_3);
+
+    x_ = x_3;
+    y_ = y_3;
+  }
+
+  void close_outline()
+  {
+    add_(fixed_x_, fixed_y_, fixed_x_0_, fixed_y_0_);
+    fixed_x_ = fixed_x_0_;
+    fixed_y_ = fixed_y_0_;
+    x_ = x_0_;
+    y_ = y_0_;
+  }
+
+  // Forgets all lines, keeping the capacity.
+  void clear() noexcept
+  {
+    segments_.clear();
+    fixed_x_0_ = 0;
+    fixed_y_0_ = 0;
+    fixed_x_ = 0;
+    fixed_y_ = 0;
+    x_min_ = int_32_max_;
+    x_max_ = int_32_min_;
+    y_min_ = int_32_max_;
+    y_max_ = int_32_min_;
+    x_0_ = 0.f;
+    y_0_ = 0.f;
+    x_ = 0.f;
+    y_ = 0.f;
+  }
+
+  [[nodiscard]] bool empty() const noexcept
+  {
+    return segments_.empty();
+  }
+
+  [[nodiscard]] Size size() const noexcept
+  {
+    return segments_.size();
+  }
+
+  [[nodiscard]] Segment const* data() const noexcept
+  {
+    return segments_.data();
+  }
+
+  // First pixel column touched by the lines, valid if the list is not
+  // empty.
+  [[nodiscard]] Int_32 column_min() const noexcept
+  {
+    return x_min_ >> 8u;
+  }
+
+  // Last pixel column touched by the lines, valid if the list is not
+  // empty. May be one past the actual last column for lines that end on
+  // a pixel boundary.
+  [[nodiscard]] Int_32 column_max() const noexcept
+  {
+    return x_max_ >> 8u;
+  }
+
+  // First pixel row touched by the lines, valid if the list is not empty.
+  [[nodiscard]] Int_32 row_min() const noexcept
+  {
+    return y_min_ >> 8u;
+  }
+
+  // Last pixel row touched by the lines, valid if the list is not empty.
+  [[nodiscard]] Int_32 row_max() const noexcept
+  {
+    return (y_max_ - 1) >> 8u;
+  }
+
+  // Rasterizes the parts of the lines within pixel rows row_min..row_max,
+  // moved by (dx, dy) pixels. Lines that cross the range only produce the
+  // cells of its rows, which are exactly the cells they give there when
+  // rasterized in full, so the cost of a band follows its height.
+  template<class Cell_processor>
+  void rasterize(
+    Rasterizer& rasterizer,
+    Cell_processor&& cell_proc,
+    Int_32 const dx,
+    Int_32 const dy,
+    Int_32 const row_min,
+    Int_32 const row_max) const
+  {
+    Int_32 const shift_x = dx * 0x100;
+    Int_32 const shift_y = dy * 0x100;
+    Int_32 const y_min = row_min * 0x100;
+    Int_32 const y_max = (row_max + 1) * 0x100;
+
+    for(auto const& segment : segments_)
+    {
+      Int_32 seg_y_min, seg_y_max;
+      if(segment.y_0 < segment.y_1)
+      {
+        seg_y_min = segment.y_0;
+        seg_y_max = segment.y_1;
+      }
+      else
+      {
+        seg_y_min = segment.y_1;
+        seg_y_max = segment.y_0;
+      }
+
+      if(seg_y_max > y_min && seg_y_min < y_max)
+      {
+        rasterizer.add_line_fixed_24_dot_8(
+          static_cast<Cell_processor&&>(cell_proc),
+          segment.x_0 + shift_x,
+          segment.y_0 + shift_y,
+          segment.x_1 + shift_x,
+          segment.y_1 + shift_y,
+          row_min + dy,
+          row_max + dy);
+      }
+    }
+  }
+
+  template<class Cell_processor>
+  void rasterize(Rasterizer& rasterizer, Cell_processor&& cell_proc) const
+  {
+    for(auto const& segment : segments_)
+    {
+      rasterizer.add_line_fixed_24_dot_8(
+        static_cast<Cell_processor&&>(cell_proc),
+        segment.x_0, segment.y_0, segment.x_1, segment.y_1);
+    }
+  }
+
+private:
+  template<class T>
+  using Vector_ = ::std::vector<T>;
+
+  using Int_32_limits_ = ::std::numeric_limits<Int_32>;
+
+  static Int_32 constexpr int_32_min_ = Int_32_limits_::min();
+  static Int_32 constexpr int_32_max_ = Int_32_limits_::max();
+
+  void line_to_(float const x, float const y)
+  {
+    Int_32 const fixed_x = Util::to_fixed_24_dot_8(x);
+    Int_32 const fixed_y = Util::to_fixed_24_dot_8(y);
+    add_(fixed_x_, fixed_y_, fixed_x, fixed_y);
+    fixed_x_ = fixed_x;
+    fixed_y_ = fixed_y;
+  }
+
+  void add_(
+    Int_32 const x_0,
+    Int_32 const y_0,
+    Int_32 const x_1,
+    Int_32 const y_1)
+  {
+    // Horizontal lines do not contribute any coverage.
+    if(y_0 != y_1)
+    {
+      segments_.push_back(Segment{x_0, y_0, x_1, y_1});
+
+      if(x_0 < x_1)
+      {
+        if(x_min_ > x_0)
+        {
+          x_min_ = x_0;
+        }
+        if(x_max_ < x_1)
+        {
+          x_max_ = x_1;
+        }
+      }
+      else
+      {
+        if(x_min_ > x_1)
+        {
+          x_min_ = x_1;
+        }
+        if(x_max_ < x_0)
+        {
+          x_max_ = x_0;
+        }
+      }
+
+      if(y_0 < y_1)
+      {
+        if(y_min_ > y_0)
+        {
+          y_min_ = y_0;
+        }
+        if(y_max_ < y_1)
+        {
+          y_max_ = y_1;
+        }
+      }
+      else
+      {
+        if(y_min_ > y_1)
+        {
+          y_min_ = y_1;
+        }
+        if(y_max_ < y_0)
+        {
+          y_max_ = y_0;
+        }
+      }
+    }
+  }
+
+  Vector_<Segment> segments_;
+  Int_32 fixed_x_0_;
+  Int_32 fixed_y_0_;
+  Int_32 fixed_x_;
+  Int_32 fixed_y_;
+  Int_32 x_min_;
+  Int_32 x_max_;
+  Int_32 y_min_;
+  Int_32 y_max_;
+  float x_0_;
+  float y_0_;
+  float x_;
+  float y_;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_SEGMENTLIST_HH
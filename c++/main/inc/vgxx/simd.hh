@@ -0,0 +1,178 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_SIMD_HH
+#define VGXX_SIMD_HH
+
+#if defined(__x86_64__) || defined(_M_X64) || \
+  defined(__i386__) || defined(_M_IX86)
+#define VGXX_SIMD_X86 1
+#endif
+
+#if defined(VGXX_SIMD_X86)
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+// Marks a function that may use the instructions of the given ISA level
+// even if the translation unit is compiled for a lower one. Callers must
+// check Simd::level() first.
+#if defined(__GNUC__) || defined(__clang__)
+#define VGXX_SIMD_TARGET(isa) __attribute__((target(isa)))
+#else
+#define VGXX_SIMD_TARGET(isa)
+#endif
+
+namespace vgxx
+{
+
+// Instruction set levels the pixel kernels have variants for, in
+// increasing order. All variants of a kernel give bit-identical results
+// for valid input, so the level only changes speed; the overloads that
+// take an explicit level exist to compare the variants.
+enum class Simd_level : unsigned char
+{
+  scalar,
+  sse2,
+  ssse3,
+  avx2
+};
+
+class Simd
+{
+public:
+  // Highest level supported by the CPU running the program, detected on
+  // the first call.
+  [[nodiscard]] static Simd_level level() noexcept
+  {
+    static Simd_level const detected_level = detect_();
+    return detected_level;
+  }
+
+  // The lower of the requested level and the supported one.
+  [[nodiscard]] static Simd_level clamp(Simd_level const level) noexcept
+  {
+    Simd_level const max_level = Simd::level();
+    return max_level < level ? max_level : level;
+  }
+
+  // True if the CPU converts between half and single precision floats
+  // (F16C). Independent of the level, though every AVX2 CPU has it.
+  [[nodiscard]] static bool has_f16c() noexcept
+  {
+    static bool const detected = detect_f16c_();
+    return detected;
+  }
+
+  [[nodiscard]] static char const* name(Simd_level const level) noexcept
+  {
+    switch(level)
+    {
+    case Simd_level::sse2:
+      return "sse2";
+    case Simd_level::ssse3:
+      return "ssse3";
+    case Simd_level::avx2:
+      return "avx2";
+    default:
+      return "scalar";
+    }
+  }
+
+private:
+  [[nodiscard]] static Simd_level detect_() noexcept
+  {
+#if defined(VGXX_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+    {
+      return Simd_level::avx2;
+    }
+    if(__builtin_cpu_supports("ssse3"))
+    {
+      return Simd_level::ssse3;
+    }
+    if(__builtin_cpu_supports("sse2"))
+    {
+      return Simd_level::sse2;
+    }
+    return Simd_level::scalar;
+#elif defined(VGXX_SIMD_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int const max_leaf = info[0];
+
+    __cpuid(info, 1);
+    bool const sse2 = 0 != (info[3] & (1 << 26));
+    bool const ssse3 = 0 != (info[2] & (1 << 9));
+
+    // AVX state must be enabled by the OS as well.
+    bool avx = 0 != (info[2] & (1 << 27)) && 0 != (info[2] & (1 << 28));
+    if(avx)
+    {
+      avx = 6u == (_xgetbv(0) & 6u);
+    }
+
+    bool avx2 = false;
+    if(avx && 7 <= max_leaf)
+    {
+      __cpuidex(info, 7, 0);
+      avx2 = 0 != (info[1] & (1 << 5));
+    }
+
+    if(avx2)
+    {
+      return Simd_level::avx2;
+    }
+    if(ssse3)
+    {
+      return Simd_level::ssse3;
+    }
+    return sse2 ? Simd_level::sse2 : Simd_level::scalar;
+#else
+    return Simd_level::scalar;
+#endif
+  }
+
+  [[nodiscard]] static bool detect_f16c_() noexcept
+  {
+#if defined(VGXX_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("f16c");
+#elif defined(VGXX_SIMD_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool const avx = 0 != (info[2] & (1 << 27)) && 0 != (info[2] & (1 << 28));
+    return avx && 6u == (_xgetbv(0) & 6u) && 0 != (info[2] & (1 << 29));
+#else
+    return false;
+#endif
+  }
+};
+
+} // namespace vgxx
+
+#endif // VGXX_SIMD_HH
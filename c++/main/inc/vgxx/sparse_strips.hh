@@ -0,0 +1,502 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_SPARSESTRIPS_HH
+#define VGXX_SPARSESTRIPS_HH
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <vgxx/pixel_box.hh>
+
+namespace vgxx
+{
+
+// Coverage of a filled path kept as runs of pixels rather than a mask.
+// Along the edges a run is a strip with one alpha value per pixel; inside
+// the path it is a solid span with one coverage for all of its pixels.
+// The size follows the length of the outline, not its area, so a list is
+// cheap to cache, clip and composite at whole-pixel offsets.
+//
+// Runs are sorted by row and then by x and do not overlap.
+struct Strip_list
+{
+  using Int_32 = ::std::int32_t;
+  using Unt_8 = ::std::uint8_t;
+  using Size = ::std::size_t;
+
+  struct Run
+  {
+    [[nodiscard]] bool is_solid() const noexcept
+    {
+      return 0u < coverage;
+    }
+
+    Int_32 y;
+    Int_32 x;
+    Int_32 length;
+
+    // Coverage of every pixel of a solid span, 0 for a strip.
+    Unt_8 coverage;
+
+    // Index of the first alpha value of a strip in alphas().
+    Size alpha_offset;
+  };
+
+  [[nodiscard]] bool empty() const noexcept
+  {
+    return runs_.empty();
+  }
+
+  [[nodiscard]] Size size() const noexcept
+  {
+    return runs_.size();
+  }
+
+  [[nodiscard]] Run const* data() const noexcept
+  {
+    return runs_.data();
+  }
+
+  [[nodiscard]] Run const* begin() const noexcept
+  {
+    return runs_.data();
+  }
+
+  [[nodiscard]] Run const* end() const noexcept
+  {
+    return runs_.data() + runs_.size();
+  }
+
+  [[nodiscard]] Run const& operator [](Size const i) const noexcept
+  {
+    assert(runs_.size() > i);
+    return runs_[i];
+  }
+
+  [[nodiscard]] Unt_8 const* alphas() const noexcept
+  {
+    return alphas_.data();
+  }
+
+  // Bounds of all the runs, empty for an empty list.
+  [[nodiscard]] Pixel_box bounds() const noexcept
+  {
+    Pixel_box box;
+    for(auto const& run : runs_)
+    {
+      box.add_row(run.y, run.x, run.x + run.length - 1);
+    }
+
+    return box;
+  }
+
+  // Memory taken by the runs and alpha values, for cache budgets.
+  [[nodiscard]] Size byte_count() const noexcept
+  {
+    return runs_.size() * sizeof(Run) + alphas_.size();
+  }
+
+  void clear() noexcept
+  {
+    runs_.clear();
+    alphas_.clear();
+  }
+
+  // Drops the parts of the runs outside the box. Alpha values of trimmed
+  // strips stay in place; only their offsets move.
+  void clip(Pixel_box const& box)
+  {
+    auto dst = runs_.begin();
+    for(auto const& src : runs_)
+    {
+      if(box.y_min > src.y || box.y_max < src.y)
+      {
+        continue;
+      }
+
+      Int_32 const x_min = box.x_min > src.x ? box.x_min : src.x;
+      Int_32 const src_x_max = src.x + src.length - 1;
+      Int_32 const x_max = box.x_max < src_x_max ? box.x_max : src_x_max;
+      if(x_min > x_max)
+      {
+        continue;
+      }
+
+      Run run = src;
+      if(!run.is_solid())
+      {
+        run.alpha_offset += static_cast<Size>(x_min - src.x);
+      }
+
+      run.x = x_min;
+      run.length = x_max - x_min + 1;
+      *dst++ = run;
+    }
+
+    runs_.erase(dst, runs_.end());
+  }
+
+  // Blends the runs offset by (dx, dy) and returns the bounds of the
+  // blended pixels. Solid spans go to blend_solid(coverage, count) and
+  // strips to blend_span(alphas, count) if the blender has them.
+  template<class Blender>
+  Pixel_box composite(
+    Blender&& blender,
+    Int_32 const dx,
+    Int_32 const dy) const
+  {
+    Pixel_box box;
+    Int_32 y = 0;
+    bool has_y = false;
+
+    for(auto const& run : runs_)
+    {
+      Int_32 const run_y = run.y + dy;
+      if(!has_y || y != run_y)
+      {
+        static_cast<Blender&&>(blender).set_y(run_y);
+        y = run_y;
+        has_y = true;
+      }
+
+      Int_32 const x = run.x + dx;
+      static_cast<Blender&&>(blender).set_x(x);
+      if(run.is_solid())
+      {
+        blend_solid_(
+          static_cast<Blender&&>(blender),
+          run.coverage,
+          static_cast<Size>(run.length));
+      }
+      else
+      {
+        blend_span_(
+          static_cast<Blender&&>(blender),
+          alphas_.data() + run.alpha_offset,
+          static_cast<Size>(run.length));
+      }
+
+      box.add_row(y, x, x + run.length - 1);
+    }
+
+    return box;
+  }
+
+  // Same as above, blending only the pixels inside the clip box, which is
+  // given in destination coordinates.
+  template<class Blender>
+  Pixel_box composite(
+    Blender&& blender,
+    Int_32 const dx,
+    Int_32 const dy,
+    Pixel_box const& clip_box) const
+  {
+    Pixel_box box;
+    Int_32 y = 0;
+    bool has_y = false;
+
+    for(auto const& run : runs_)
+    {
+      Int_32 const run_y = run.y + dy;
+      if(clip_box.y_min > run_y || clip_box.y_max < run_y)
+      {
+        continue;
+      }
+
+      Int_32 const run_x = run.x + dx;
+      Int_32 const x_min = clip_box.x_min > run_x ? clip_box.x_min : run_x;
+      Int_32 const run_x_max = run_x + run.length - 1;
+      Int_32 const x_max =
+        clip_box.x_max < run_x_max ? clip_box.x_max : run_x_max;
+      if(x_min > x_max)
+      {
+        continue;
+      }
+
+      if(!has_y || y != run_y)
+      {
+        static_cast<Blender&&>(blender).set_y(run_y);
+        y = run_y;
+        has_y = true;
+      }
+
+      auto const count = static_cast<Size>(x_max - x_min + 1);
+      static_cast<Blender&&>(blender).set_x(x_min);
+      if(run.is_solid())
+      {
+        blend_solid_(static_cast<Blender&&>(blender), run.coverage, count);
+      }
+      else
+      {
+        blend_span_(
+          static_cast<Blender&&>(blender),
+          alphas_.data() + run.alpha_offset +
+            static_cast<Size>(x_min - run_x),
+          count);
+      }
+
+      box.add_row(y, x_min, x_max);
+    }
+
+    return box;
+  }
+
+private:
+  friend struct Strip_builder;
+
+  template<class T>
+  using Vector_ = ::std::vector<T>;
+
+  template<class T>
+  using Decay_ = typename ::std::decay<T>::type;
+
+  template<class Blender, class = void>
+  struct Has_blend_solid_ : ::std::false_type
+  {};
+
+  template<class Blender>
+  struct Has_blend_solid_<
+    Blender,
+    decltype(void(::std::declval<Blender&>().blend_solid(
+      ::std::declval<Unt_8>(), ::std::declval<Size>())))> :
+    ::std::true_type
+  {};
+
+  template<class Blender, class = void>
+  struct Has_blend_span_ : ::std::false_type
+  {};
+
+  template<class Blender>
+  struct Has_blend_span_<
+    Blender,
+    decltype(void(::std::declval<Blender&>().blend_span(
+      ::std::declval<Unt_8 const*>(), ::std::declval<Size>())))> :
+    ::std::true_type
+  {};
+
+  template<class Blender>
+  static void blend_solid_(
+    Blender&& blender,
+    Unt_8 const coverage,
+    Size count)
+  {
+    if constexpr(Has_blend_solid_<Decay_<Blender>>::value)
+    {
+      static_cast<Blender&&>(blender).blend_solid(coverage, count);
+    }
+    else
+    {
+      for(;;)
+      {
+        static_cast<Blender&&>(blender).blend(coverage);
+        if(0u < --count)
+        {
+          static_cast<Blender&&>(blender).inc_x();
+        }
+        else
+        {
+          break;
+        }
+      }
+    }
+  }
+
+  template<class Blender>
+  static void blend_span_(
+    Blender&& blender,
+    Unt_8 const* alpha,
+    Size count)
+  {
+    if constexpr(Has_blend_span_<Decay_<Blender>>::value)
+    {
+      static_cast<Blender&&>(blender).blend_span(alpha, count);
+    }
+    else
+    {
+      for(;;)
+      {
+        if(0u < *alpha)
+        {
+          static_cast<Blender&&>(blender).blend(*alpha);
+        }
+
+        if(0u < --count)
+        {
+          ++alpha;
+          static_cast<Blender&&>(blender).inc_x();
+        }
+        else
+        {
+          break;
+        }
+      }
+    }
+  }
+
+  Vector_<Run> runs_;
+  Vector_<Unt_8> alphas_;
+};
+
+// Blender that records what a cell processor swipes as a Strip_list, so a
+// path can be rasterized once and composited many times:
+//
+//   Renderer<Strip_builder> renderer(width, height);
+//   ...
+//   renderer.fill(Fill_rule::non_zero);
+//   Strip_list strips = renderer.blender().take();
+//
+// The canvas size only bounds the recorded runs; no pixels are stored.
+struct Strip_builder
+{
+  using Int_32 = ::std::int32_t;
+  using Unt_8 = ::std::uint8_t;
+  using Size = ::std::size_t;
+
+  // Solid runs shorter than this are stored as strips, where they are
+  // cheaper than a run of their own.
+  static Size constexpr min_solid_length = 8u;
+
+  [[nodiscard]] Strip_list const& strips() const noexcept
+  {
+    return strips_;
+  }
+
+  // Hands out the recorded runs and starts a new list.
+  [[nodiscard]] Strip_list take() noexcept
+  {
+    Strip_list strips(::std::move(strips_));
+    strips_.clear();
+    return strips;
+  }
+
+  void clear() noexcept
+  {
+    strips_.clear();
+  }
+
+  template<class X>
+  void set_x(X const& x) noexcept
+  {
+    x_ = static_cast<Int_32>(x);
+  }
+
+  template<class Y>
+  void set_y(Y const& y) noexcept
+  {
+    y_ = static_cast<Int_32>(y);
+  }
+
+  void inc_x() noexcept
+  {
+    ++x_;
+  }
+
+  void inc_y() noexcept
+  {
+    ++y_;
+  }
+
+  void blend(Unt_8 const coverage)
+  {
+    strip_run_().length += 1;
+    strips_.alphas_.push_back(coverage);
+  }
+
+  // Records count pixels from the current one, all with the same
+  // coverage.
+  void blend_solid(Unt_8 const coverage, Size const count)
+  {
+    if(0u == count)
+    {
+      return;
+    }
+
+    if(min_solid_length > count)
+    {
+      strip_run_().length += static_cast<Int_32>(count);
+      strips_.alphas_.insert(strips_.alphas_.end(), count, coverage);
+      return;
+    }
+
+    auto& runs = strips_.runs_;
+    if(!runs.empty())
+    {
+      auto& last = runs.back();
+      if(last.y == y_ && last.x + last.length == x_ &&
+        last.coverage == coverage)
+      {
+        last.length += static_cast<Int_32>(count);
+        return;
+      }
+    }
+
+    Run_ run;
+    run.y = y_;
+    run.x = x_;
+    run.length = static_cast<Int_32>(count);
+    run.coverage = coverage;
+    run.alpha_offset = 0u;
+    runs.push_back(run);
+  }
+
+private:
+  using Run_ = Strip_list::Run;
+
+  // Strip that the pixel at the current position extends, started anew
+  // unless the last run is a strip ending right before it.
+  [[nodiscard]] Run_& strip_run_()
+  {
+    auto& runs = strips_.runs_;
+    if(!runs.empty())
+    {
+      auto& last = runs.back();
+      if(last.y == y_ && last.x + last.length == x_ && !last.is_solid())
+      {
+        return last;
+      }
+    }
+
+    Run_ run;
+    run.y = y_;
+    run.x = x_;
+    run.length = 0;
+    run.coverage = 0u;
+    run.alpha_offset = strips_.alphas_.size();
+    runs.push_back(run);
+    return runs.back();
+  }
+
+  Strip_list strips_;
+  Int_32 x_ = 0;
+  Int_32 y_ = 0;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_SPARSESTRIPS_HH
@@ -0,0 +1,102 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_SRGB_HH
+#define VGXX_SRGB_HH
+
+#include <cmath>
+#include <cstdint>
+
+namespace vgxx
+{
+
+// Conversions between 8-bit sRGB values and 16-bit linear light through
+// lookup tables built on first use. Linear values go back through a table
+// of 4096 entries indexed by their top 12 bits, fine enough that every
+// sRGB value survives the round trip.
+class Srgb
+{
+public:
+  using Unt_8 = ::std::uint8_t;
+  using Unt_16 = ::std::uint16_t;
+
+  // Tables for the span kernels. Both are padded so that a 32-bit load
+  // at any entry stays inside them.
+  struct Tables
+  {
+    Unt_16 to_linear[256u + 2u];
+    Unt_8 from_linear[4096u + 4u];
+  };
+
+  [[nodiscard]] static Tables const& tables() noexcept
+  {
+    static Tables const tables = make_tables_();
+    return tables;
+  }
+
+  [[nodiscard]] static Unt_16 to_linear(Unt_8 const value) noexcept
+  {
+    return tables().to_linear[value];
+  }
+
+  [[nodiscard]] static Unt_8 from_linear(Unt_16 const value) noexcept
+  {
+    return tables().from_linear[value >> 4u];
+  }
+
+private:
+  [[nodiscard]] static double decode_(double const v) noexcept
+  {
+    return 0.04045 >= v ? v / 12.92 : ::std::pow((v + 0.055) / 1.055, 2.4);
+  }
+
+  [[nodiscard]] static double encode_(double const v) noexcept
+  {
+    return 0.0031308 >= v ?
+      v * 12.92 :
+      1.055 * ::std::pow(v, 1.0 / 2.4) - 0.055;
+  }
+
+  [[nodiscard]] static Tables make_tables_() noexcept
+  {
+    Tables tables{};
+    for(unsigned i = 0u; 256u > i; ++i)
+    {
+      tables.to_linear[i] = static_cast<Unt_16>(
+        ::std::lround(decode_(i / 255.0) * 65535.0));
+    }
+
+    // Each entry covers 16 linear values; take the one in the middle.
+    for(unsigned i = 0u; 4096u > i; ++i)
+    {
+      tables.from_linear[i] = static_cast<Unt_8>(
+        ::std::lround(encode_((i * 16u + 7.5) / 65535.0) * 255.0));
+    }
+    return tables;
+  }
+};
+
+} // namespace vgxx
+
+#endif // VGXX_SRGB_HH
@@ -0,0 +1,230 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_STREAMINGRENDERER_HH
+#define VGXX_STREAMINGRENDERER_HH
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <vgxx/cell_processor.hh>
+#include <vgxx/display_list.hh>
+#include <vgxx/offset_blender.hh>
+#include <vgxx/pixel_box.hh>
+#include <vgxx/rasterizer.hh>
+
+namespace vgxx
+{
+
+// Renders display lists into images that need not fit in memory. The
+// image is produced one band of rows at a time in a band-sized buffer,
+// using a cell processor only as tall as a band, and every finished band
+// is handed to a sink. The blenders of the list are pointed at the band
+// buffer with set_image(), so they must derive from Blender_base. They
+// still see canvas coordinates, so rows are computed exactly as Renderer
+// computes them, gradients and patterns included. Each band rasterizes
+// only its own rows of the lines crossing it, so thin bands do not
+// multiply the rasterization work.
+template<class B, class P = Cell_processor>
+struct Streaming_renderer
+{
+  using Blender = B;
+  using Cell_processor = P;
+  using Color = typename Blender::Color;
+  using Coord = typename Cell_processor::Coord;
+  using Int_32 = ::std::int32_t;
+  using Size = ::std::size_t;
+
+  explicit Streaming_renderer(
+    Coord const width,
+    Coord const height,
+    Coord const band_height) :
+    cell_proc_(width, band_height),
+    width_(width),
+    height_(height),
+    band_height_(band_height)
+  {
+    assert(0u < width);
+    assert(0u < height);
+    assert(0u < band_height);
+  }
+
+  [[nodiscard]] Coord width() const noexcept
+  {
+    return width_;
+  }
+
+  [[nodiscard]] Coord height() const noexcept
+  {
+    return height_;
+  }
+
+  [[nodiscard]] Coord band_height() const noexcept
+  {
+    return band_height_;
+  }
+
+  // Renders the list band by band over the background colour. After each
+  // band, calls sink(rows, bytes_per_row, y, row_count), where rows points
+  // at the first of row_count rows starting at image row y. The rows stay
+  // valid until the sink returns. Returns the bounds of the pixels that
+  // have been blended.
+  template<class Sink>
+  Pixel_box render(
+    Display_list<Blender> const& list,
+    Color const& background,
+    Sink&& sink)
+  {
+    Int_32 const height = static_cast<Int_32>(height_);
+    Int_32 const band_height = static_cast<Int_32>(band_height_);
+    Size const bytes_per_row = static_cast<Size>(width_) * sizeof(Color);
+    auto const band_count = static_cast<Size>(
+      (height + band_height - 1) / band_height);
+
+    band_.resize(static_cast<Size>(width_) * static_cast<Size>(band_height));
+
+    // Commands by the band they start in, in list order.
+    if(starts_.size() < band_count)
+    {
+      starts_.resize(band_count);
+    }
+    for(Size i = 0u; band_count > i; ++i)
+    {
+      starts_[i].clear();
+    }
+    for(Size k = 0u; list.size() > k; ++k)
+    {
+      auto const& segments = list[k].segments;
+      if(segments.row_max() < 0 || segments.row_min() >= height)
+      {
+        continue;
+      }
+
+      Int_32 const row_min = 0 > segments.row_min() ? 0 : segments.row_min();
+      starts_[static_cast<Size>(row_min / band_height)].push_back(k);
+    }
+
+    Pixel_box box;
+    active_.clear();
+
+    for(Size band = 0u; band_count > band; ++band)
+    {
+      Int_32 const band_y = static_cast<Int_32>(band) * band_height;
+      Int_32 const row_count =
+        height - band_y < band_height ? height - band_y : band_height;
+      Int_32 const band_y_max = band_y + row_count - 1;
+
+      // Keep the commands still reaching this band and add the ones that
+      // start in it, both in list order.
+      next_active_.clear();
+      auto active = active_.cbegin();
+      auto const active_end = active_.cend();
+      auto start = starts_[band].cbegin();
+      auto const starts_end = starts_[band].cend();
+      for(;;)
+      {
+        Size k;
+        if(
+          active_end != active &&
+          (starts_end == start || *active < *start))
+        {
+          k = *active++;
+          if(list[k].segments.row_max() < band_y)
+          {
+            continue;
+          }
+        }
+        else if(starts_end != start)
+        {
+          k = *start++;
+        }
+        else
+        {
+          break;
+        }
+
+        next_active_.push_back(k);
+      }
+      active_.swap(next_active_);
+
+      // The last band may be shorter.
+      if(static_cast<Int_32>(cell_proc_.height()) != row_count)
+      {
+        cell_proc_.resize(width_, static_cast<Coord>(row_count));
+      }
+
+      Color* const rows = band_.data();
+      for(Size i = static_cast<Size>(width_) * static_cast<Size>(row_count);
+        0u < i;)
+      {
+        rows[--i] = background;
+      }
+
+      for(auto const k : active_)
+      {
+        // Lines crossing the band only produce its rows, see
+        // Segment_list::rasterize().
+        auto const& command = list[k];
+        command.segments.rasterize(
+          rasterizer_, cell_proc_, 0, -band_y, band_y, band_y_max);
+
+        // The blender sees canvas rows, the swipe band rows.
+        Offset_blender<Blender> blender(command.blender, 0, band_y);
+        blender.set_image(rows, bytes_per_row, band_y);
+        Pixel_box command_box = cell_proc_.swipe(blender, command.fill_rule);
+        if(command_box)
+        {
+          command_box.y_min += band_y;
+          command_box.y_max += band_y;
+          box.unite(command_box);
+        }
+      }
+
+      static_cast<Sink&&>(sink)(
+        static_cast<Color const*>(rows), bytes_per_row, band_y, row_count);
+    }
+
+    return box;
+  }
+
+private:
+  template<class T>
+  using Vector_ = ::std::vector<T>;
+
+  Cell_processor cell_proc_;
+  Rasterizer rasterizer_;
+  Vector_<Color> band_;
+  Vector_<Vector_<Size>> starts_;
+  Vector_<Size> active_;
+  Vector_<Size> next_active_;
+  Coord width_;
+  Coord height_;
+  Coord band_height_;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_STREAMINGRENDERER_HH
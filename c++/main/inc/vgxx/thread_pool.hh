@@ -0,0 +1,351 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_THREADPOOL_HH
+#define VGXX_THREADPOOL_HH
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace vgxx
+{
+
+// Fork-join pool for the parallel renderers. run() spreads a number of
+// independent tasks over the worker threads and the calling thread and
+// returns once all of them are done. Every task learns the index of the
+// worker running it, so callers can keep per-worker state such as cell
+// processors without locking.
+//
+// Each worker starts on its own contiguous range of task indices, so
+// neighbouring tasks tend to run on the same thread. A worker that runs
+// out of tasks steals the back half of the largest remaining range.
+struct Thread_pool
+{
+  using Size = ::std::size_t;
+
+  Thread_pool(Thread_pool&&) = delete;
+  Thread_pool(Thread_pool const&) = delete;
+
+  // Uses one thread per hardware thread, counting the caller.
+  Thread_pool() :
+    Thread_pool(default_thread_count_())
+  {}
+
+  explicit Thread_pool(Size const thread_count) :
+    task_fn_(nullptr),
+    task_ctx_(nullptr),
+    ranges_(new Range_[thread_count + 1u]),
+    cancelled_(false),
+    busy_count_(0u),
+    generation_(0u),
+    stopped_(false)
+  {
+    threads_.reserve(thread_count);
+    for(Size i = 0u; thread_count > i; ++i)
+    {
+      threads_.emplace_back([this, i]() noexcept
+        {
+          work_(i);
+        });
+    }
+  }
+
+  ~Thread_pool()
+  {
+    {
+      Lock_ lock(mutex_);
+      stopped_ = true;
+    }
+
+    start_condition_.notify_all();
+    for(auto& thread : threads_)
+    {
+      thread.join();
+    }
+  }
+
+  Thread_pool& operator =(Thread_pool&&) = delete;
+  Thread_pool& operator =(Thread_pool const&) = delete;
+
+  // Number of workers including the calling thread. Worker indices passed
+  // to tasks are below this number.
+  [[nodiscard]] Size worker_count() const noexcept
+  {
+    return threads_.size() + 1u;
+  }
+
+  // Calls task(task_index, worker_index) for every task index below
+  // task_count, which must fit in 32 bits. Rethrows the first exception
+  // thrown by a task.
+  template<class Task>
+  void run(Size const task_count, Task&& task)
+  {
+    if(0u == task_count)
+    {
+      return;
+    }
+
+    assert(0xffffffffu >= task_count);
+    using Task_ = typename ::std::remove_reference<Task>::type;
+
+    Lock_ run_lock(run_mutex_);
+    auto const task_fn = [](void* const ctx, Size const i, Size const worker)
+      {
+        (*static_cast<Task_*>(ctx))(i, worker);
+      };
+
+    {
+      Lock_ lock(mutex_);
+      task_fn_ = task_fn;
+      task_ctx_ = const_cast<void*>(static_cast<void const*>(&task));
+      cancelled_.store(false, ::std::memory_order_relaxed);
+
+      Size const worker_count = threads_.size() + 1u;
+      for(Size i = 0u; worker_count > i; ++i)
+      {
+        ranges_[i].tasks.store(
+          pack_range_(
+            task_count * i / worker_count,
+            task_count * (i + 1u) / worker_count),
+          ::std::memory_order_relaxed);
+      }
+
+      busy_count_ = threads_.size();
+      ++generation_;
+    }
+
+    start_condition_.notify_all();
+    execute_(threads_.size());
+
+    Lock_ lock(mutex_);
+    done_condition_.wait(lock, [this]() noexcept
+      {
+        return 0u == busy_count_;
+      });
+
+    if(error_)
+    {
+      ::std::exception_ptr error;
+      error.swap(error_);
+      lock.unlock();
+      ::std::rethrow_exception(error);
+    }
+  }
+
+private:
+  using Task_fn_ = void (*)(void*, Size, Size);
+  using Unt_32_ = ::std::uint32_t;
+  using Unt_64_ = ::std::uint64_t;
+  using Mutex_ = ::std::mutex;
+  using Lock_ = ::std::unique_lock<Mutex_>;
+  using Condition_ = ::std::condition_variable;
+  using Thread_ = ::std::thread;
+
+  template<class T>
+  using Unique_ptr_ = ::std::unique_ptr<T>;
+
+  template<class T>
+  using Vector_ = ::std::vector<T>;
+
+  // Half-open range of task indices, begin in the low half. The owner
+  // takes tasks from the front, thieves split off the back.
+  struct alignas(64) Range_
+  {
+    ::std::atomic<Unt_64_> tasks{0u};
+  };
+
+  [[nodiscard]] static Unt_64_ pack_range_(
+    Size const begin,
+    Size const end) noexcept
+  {
+    return static_cast<Unt_64_>(begin) | (static_cast<Unt_64_>(end) << 32u);
+  }
+
+  [[nodiscard]] static Size range_begin_(Unt_64_ const range) noexcept
+  {
+    return static_cast<Size>(static_cast<Unt_32_>(range));
+  }
+
+  [[nodiscard]] static Size range_end_(Unt_64_ const range) noexcept
+  {
+    return static_cast<Size>(range >> 32u);
+  }
+
+  [[nodiscard]] static Size default_thread_count_() noexcept
+  {
+    Size const count = Thread_::hardware_concurrency();
+    return 1u < count ? count - 1u : 0u;
+  }
+
+  void work_(Size const worker) noexcept
+  {
+    ::std::uint64_t generation = 0u;
+
+    for(;;)
+    {
+      {
+        Lock_ lock(mutex_);
+        start_condition_.wait(lock, [this, generation]() noexcept
+          {
+            return stopped_ || generation_ != generation;
+          });
+
+        if(stopped_)
+        {
+          break;
+        }
+
+        generation = generation_;
+      }
+
+      execute_(worker);
+
+      Lock_ lock(mutex_);
+      if(0u == --busy_count_)
+      {
+        done_condition_.notify_one();
+      }
+    }
+  }
+
+  void execute_(Size const worker) noexcept
+  {
+    auto& tasks = ranges_[worker].tasks;
+
+    for(;;)
+    {
+      Unt_64_ range = tasks.load(::std::memory_order_relaxed);
+      Size begin = range_begin_(range);
+      Size end = range_end_(range);
+
+      if(begin < end)
+      {
+        if(!tasks.compare_exchange_weak(range, pack_range_(begin + 1u, end)))
+        {
+          continue;
+        }
+
+        if(!cancelled_.load(::std::memory_order_relaxed))
+        {
+          run_task_(begin, worker);
+        }
+      }
+      else if(!steal_(worker))
+      {
+        break;
+      }
+    }
+  }
+
+  // Moves the back half of the largest range of another worker to the
+  // range of this one. Fails once all the ranges are empty.
+  [[nodiscard]] bool steal_(Size const worker) noexcept
+  {
+    Size const worker_count = threads_.size() + 1u;
+
+    for(;;)
+    {
+      Size victim = worker;
+      Unt_64_ victim_range = 0u;
+      Size victim_size = 0u;
+
+      for(Size i = 1u; worker_count > i; ++i)
+      {
+        Size const candidate = (worker + i) % worker_count;
+        Unt_64_ const range =
+          ranges_[candidate].tasks.load(::std::memory_order_relaxed);
+        Size const begin = range_begin_(range);
+        Size const end = range_end_(range);
+        if(begin < end && victim_size < end - begin)
+        {
+          victim = candidate;
+          victim_range = range;
+          victim_size = end - begin;
+        }
+      }
+
+      if(0u == victim_size)
+      {
+        return false;
+      }
+
+      Size const begin = range_begin_(victim_range);
+      Size const end = range_end_(victim_range);
+      Size const split = end - (victim_size + 1u) / 2u;
+      if(ranges_[victim].tasks.compare_exchange_weak(
+          victim_range,
+          pack_range_(begin, split)))
+      {
+        ranges_[worker].tasks.store(pack_range_(split, end));
+        return true;
+      }
+    }
+  }
+
+  void run_task_(Size const i, Size const worker) noexcept
+  {
+    try
+    {
+      task_fn_(task_ctx_, i, worker);
+    }
+    catch(...)
+    {
+      Lock_ lock(mutex_);
+      if(!error_)
+      {
+        error_ = ::std::current_exception();
+      }
+
+      // Skip the tasks nobody has started yet.
+      cancelled_.store(true, ::std::memory_order_relaxed);
+    }
+  }
+
+  Vector_<Thread_> threads_;
+  Task_fn_ task_fn_;
+  void* task_ctx_;
+  Unique_ptr_<Range_[]> ranges_;
+  ::std::atomic<bool> cancelled_;
+  Size busy_count_;
+  ::std::uint64_t generation_;
+  bool stopped_;
+  ::std::exception_ptr error_;
+  Mutex_ mutex_;
+  Mutex_ run_mutex_;
+  Condition_ start_condition_;
+  Condition_ done_condition_;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_THREADPOOL_HH
@@ -0,0 +1,566 @@
+/*
+The MIT License (MIT) https://opensource.org/license/mit
+
+Copyright (c) 2013-2024 Roman Panov roman.a.panov@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef VGXX_TILERENDERER_HH
+#define VGXX_TILERENDERER_HH
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <vgxx/cell_processor.hh>
+#include <vgxx/display_list.hh>
+#include <vgxx/offset_blender.hh>
+#include <vgxx/pixel_box.hh>
+#include <vgxx/rasterizer.hh>
+#include <vgxx/segment_list.hh>
+#include <vgxx/thread_pool.hh>
+
+namespace vgxx
+{
+
+// Renders display lists on all workers of a thread pool. The canvas is
+// split into square tiles. First every line is handed to the bands of
+// tiles its rows touch, in list order. Then every band is binned in
+// parallel: each command hands a tile the lines that touch it, plus the
+// per-row cover of the lines that lie entirely to its left. Finally the
+// tiles are rendered independently, each into a tile-sized cell processor
+// that stays in cache, running the commands in list order. Bands and
+// tiles only rasterize their own rows of a line, so a line costs about as
+// much as in Renderer however many tiles it crosses. Pixel coverage is
+// computed exactly as Renderer computes it, so the output is bit-identical
+// to filling the commands one by one.
+template<class B, class P = Cell_processor>
+struct Tile_renderer
+{
+  using Blender = B;
+  using Cell_processor = P;
+  using Coord = typename Cell_processor::Coord;
+  using Int_32 = ::std::int32_t;
+  using Size = ::std::size_t;
+
+  static Int_32 constexpr tile_size = 64;
+
+  explicit Tile_renderer(
+    Thread_pool& pool,
+    Coord const width,
+    Coord const height) :
+    pool_(pool),
+    width_(width),
+    height_(height)
+  {
+    assert(0u < width);
+    assert(0u < height);
+
+    workers_.reserve(pool.worker_count());
+    for(Size i = pool.worker_count(); 0u < i; --i)
+    {
+      workers_.push_back(
+        Worker_{
+          Rasterizer(),
+          Cell_processor(tile_size, tile_size),
+          Vector_<Vector_<Segment_>>(),
+          Vector_<Int_32>()});
+    }
+  }
+
+  [[nodiscard]] Coord width() const noexcept
+  {
+    return width_;
+  }
+
+  [[nodiscard]] Coord height() const noexcept
+  {
+    return height_;
+  }
+
+  // Changes the canvas size. The blenders of the display lists rendered
+  // afterwards should target an image of the new size.
+  void resize(Coord const width, Coord const height) noexcept
+  {
+    assert(0u < width);
+    assert(0u < height);
+
+    width_ = width;
+    height_ = height;
+  }
+
+  // Renders the commands of the list in order and returns the bounds of
+  // the pixels that have been blended.
+  Pixel_box render(Display_list<Blender> const& list)
+  {
+    Pixel_box box;
+
+    if(!list.empty())
+    {
+      Size const band_count = tile_count_(height_);
+      Size const column_count = tile_count_(width_);
+      if(bands_.size() < band_count)
+      {
+        bands_.resize(band_count);
+      }
+      for(Size i = 0u; band_count > i; ++i)
+      {
+        bands_[i].binned.clear();
+      }
+      bin_segments_(list, column_count);
+
+      pool_.run(
+        band_count,
+        [&](Size const i, Size const worker_index)
+        {
+          bin_(list, i, column_count, workers_[worker_index]);
+        });
+
+      tile_boxes_.assign(band_count * column_count, Pixel_box());
+      pool_.run(
+        band_count * column_count,
+        [&](Size const i, Size const worker_index)
+        {
+          tile_boxes_[i] = render_tile_(
+            list,
+            i / column_count,
+            i % column_count,
+            workers_[worker_index]);
+        });
+
+      for(auto const& tile_box : tile_boxes_)
+      {
+        box.unite(tile_box);
+      }
+    }
+
+    return box;
+  }
+
+private:
+  using Segment_ = Segment_list::Segment;
+
+  template<class T>
+  using Vector_ = ::std::vector<T>;
+
+  static Size constexpr no_covers_ = ~Size{0u};
+  static unsigned constexpr tile_bits_ = 6u;
+
+  static_assert((Int_32{1} << tile_bits_) == tile_size);
+
+  // Part of a command that falls into a tile. Refers to the lines and the
+  // per-row left covers stored in the band.
+  struct Tile_command_
+  {
+    Size command;
+    Size segment_begin;
+    Size segment_end;
+    Size covers;
+  };
+
+  // Line of a command whose rows touch a band.
+  struct Binned_segment_
+  {
+    Size command;
+    Segment_ const* segment;
+  };
+
+  struct Band_
+  {
+    Vector_<Binned_segment_> binned;
+    Vector_<Vector_<Tile_command_>> tiles;
+    Vector_<Segment_> segments;
+    Vector_<Int_32> covers;
+  };
+
+  struct Worker_
+  {
+    Rasterizer rasterizer;
+    Cell_processor cell_proc;
+    Vector_<Vector_<Segment_>> columns;
+    Vector_<Int_32> covers;
+  };
+
+  // Cell sink that sums the cover of every row of a band. Rasterizing a
+  // line gives the same per-row cover wherever its cells end up.
+  struct Cover_sink_
+  {
+    explicit Cover_sink_(Int_32* const covers, Int_32 const y_0) noexcept :
+      covers_(covers),
+      y_0_(y_0),
+      y_(0)
+    {}
+
+    void inc_x() noexcept
+    {}
+
+    void set_x(Int_32) noexcept
+    {}
+
+    void set_y(Int_32 const y) noexcept
+    {
+      y_ = y - y_0_;
+    }
+
+    void set_cell(Int_32 const cover, Int_32) noexcept
+    {
+      if(0 <= y_ && tile_size > y_)
+      {
+        covers_[y_] += cover;
+      }
+    }
+
+  private:
+    Int_32* covers_;
+    Int_32 y_0_;
+    Int_32 y_;
+  };
+
+  [[nodiscard]] static Size tile_count_(Coord const length) noexcept
+  {
+    return (static_cast<Size>(length) + tile_size - 1u) >> tile_bits_;
+  }
+
+  // Hands every line on the canvas to the bands its rows touch, so that
+  // each band later sees only its own lines, grouped by command in list
+  // order.
+  void bin_segments_(
+    Display_list<Blender> const& list,
+    Size const column_count)
+  {
+    Int_32 const last_row = static_cast<Int_32>(height_) - 1;
+    Int_32 const last_column = static_cast<Int_32>(column_count) - 1;
+
+    for(Size k = 0u; list.size() > k; ++k)
+    {
+      auto const& segments = list[k].segments;
+      if(
+        segments.empty() ||
+        segments.row_max() < 0 ||
+        segments.row_min() > last_row ||
+        0 > segments.column_max() >> tile_bits_ ||
+        last_column < segments.column_min() >> tile_bits_)
+      {
+        // Off the canvas; the covers of a closed outline cancel out in
+        // every row.
+        continue;
+      }
+
+      auto const* const segment_end = segments.data() + segments.size();
+      for(auto const* segment = segments.data(); segment_end != segment;
+        ++segment)
+      {
+        Int_32 seg_y_min, seg_y_max;
+        if(segment->y_0 < segment->y_1)
+        {
+          seg_y_min = segment->y_0;
+          seg_y_max = segment->y_1;
+        }
+        else
+        {
+          seg_y_min = segment->y_1;
+          seg_y_max = segment->y_0;
+        }
+
+        Int_32 row_min = seg_y_min >> 8u;
+        Int_32 row_max = (seg_y_max - 1) >> 8u;
+        if(0 > row_min)
+        {
+          row_min = 0;
+        }
+        if(last_row < row_max)
+        {
+          row_max = last_row;
+        }
+
+        for(Int_32 b = row_min >> tile_bits_; row_max >> tile_bits_ >= b;
+          ++b)
+        {
+          bands_[static_cast<Size>(b)].binned.push_back(
+            Binned_segment_{k, segment});
+        }
+      }
+    }
+  }
+
+  void bin_(
+    Display_list<Blender> const& list,
+    Size const band_index,
+    Size const column_count,
+    Worker_& worker)
+  {
+    auto& band = bands_[band_index];
+    band.segments.clear();
+    band.covers.clear();
+    if(band.tiles.size() < column_count)
+    {
+      band.tiles.resize(column_count);
+    }
+    for(Size i = 0u; column_count > i; ++i)
+    {
+      band.tiles[i].clear();
+    }
+
+    Int_32 const band_y = static_cast<Int_32>(band_index) * tile_size;
+    Int_32 const band_y_max = band_y + tile_size - 1;
+    Int_32 const last_column = static_cast<Int_32>(column_count) - 1;
+    auto const& binned = band.binned;
+
+    for(Size group_end = 0u; binned.size() > group_end;)
+    {
+      // The lines of one command are consecutive.
+      Size const group_begin = group_end;
+      Size const k = binned[group_begin].command;
+      while(binned.size() > group_end && k == binned[group_end].command)
+      {
+        ++group_end;
+      }
+
+      auto const& segments = list[k].segments;
+      Int_32 column_min = segments.column_min() >> tile_bits_;
+      Int_32 column_max = segments.column_max() >> tile_bits_;
+      if(0 > column_min)
+      {
+        column_min = 0;
+      }
+      if(last_column < column_max)
+      {
+        column_max = last_column;
+      }
+
+      auto const column_span = static_cast<Size>(column_max - column_min + 1);
+      if(worker.columns.size() < column_span)
+      {
+        worker.columns.resize(column_span);
+      }
+      for(Size i = 0u; column_span > i; ++i)
+      {
+        worker.columns[i].clear();
+      }
+      worker.covers.assign(column_span * tile_size, 0);
+      bool has_covers = false;
+
+      for(Size j = group_begin; group_end > j; ++j)
+      {
+        Segment_ const* const segment = binned[j].segment;
+        Int_32 seg_x_min, seg_x_max;
+        if(segment->x_0 < segment->x_1)
+        {
+          seg_x_min = segment->x_0;
+          seg_x_max = segment->x_1;
+        }
+        else
+        {
+          seg_x_min = segment->x_1;
+          seg_x_max = segment->x_0;
+        }
+
+        Int_32 const seg_column_min = (seg_x_min >> 8u) >> tile_bits_;
+        Int_32 const seg_column_max = (seg_x_max >> 8u) >> tile_bits_;
+        if(column_max < seg_column_min)
+        {
+          // Right of the canvas; cannot affect any pixel on it.
+          continue;
+        }
+
+        for(
+          Int_32 c = column_min < seg_column_min ? seg_column_min : column_min,
+            c_end = column_max < seg_column_max ? column_max : seg_column_max;
+          c_end >= c;
+          ++c)
+        {
+          worker.columns[static_cast<Size>(c - column_min)].push_back(
+            *segment);
+        }
+
+        // Tiles right of the line only see its cover.
+        Int_32 const c = column_min <= seg_column_max ?
+          seg_column_max + 1 : column_min;
+        if(column_max >= c)
+        {
+          Cover_sink_ sink(
+            worker.covers.data() +
+              static_cast<Size>(c - column_min) * tile_size,
+            band_y);
+          worker.rasterizer.add_line_fixed_24_dot_8(
+            sink, 0, segment->y_0, 0, segment->y_1, band_y, band_y_max);
+          has_covers = true;
+        }
+      }
+
+      for(Size i = 0u; column_span > i; ++i)
+      {
+        Int_32* const covers = worker.covers.data() + i * tile_size;
+        bool covered = false;
+        if(has_covers)
+        {
+          for(Int_32 r = 0; tile_size > r; ++r)
+          {
+            if(0u < i)
+            {
+              covers[r] += covers[r - tile_size];
+            }
+            if(0 != covers[r])
+            {
+              covered = true;
+            }
+          }
+        }
+
+        auto const& column = worker.columns[i];
+        if(column.empty() && !covered)
+        {
+          continue;
+        }
+
+        Tile_command_ tile_command{
+          k,
+          band.segments.size(),
+          band.segments.size() + column.size(),
+          covered ? band.covers.size() : no_covers_};
+        band.segments.insert(band.segments.end(), column.begin(),
+          column.end());
+        if(covered)
+        {
+          band.covers.insert(band.covers.end(), covers, covers + tile_size);
+        }
+
+        band.tiles[static_cast<Size>(column_min) + i].push_back(
+          tile_command);
+      }
+    }
+  }
+
+  Pixel_box render_tile_(
+    Display_list<Blender> const& list,
+    Size const band_index,
+    Size const column,
+    Worker_& worker)
+  {
+    Pixel_box box;
+    auto const& band = bands_[band_index];
+    auto const& tile_commands = band.tiles[column];
+    if(tile_commands.empty())
+    {
+      return box;
+    }
+
+    Int_32 const x_0 = static_cast<Int_32>(column) * tile_size;
+    Int_32 const y_0 = static_cast<Int_32>(band_index) * tile_size;
+    Int_32 const tile_width = static_cast<Int_32>(width_) - x_0 < tile_size ?
+      static_cast<Int_32>(width_) - x_0 : tile_size;
+    Int_32 const tile_height = static_cast<Int_32>(height_) - y_0 <
+      tile_size ? static_cast<Int_32>(height_) - y_0 : tile_size;
+    Int_32 const shift_x = x_0 * 0x100;
+    Int_32 const shift_y = y_0 * 0x100;
+
+    auto& cell_proc = worker.cell_proc;
+    if(
+      static_cast<Int_32>(cell_proc.width()) != tile_width ||
+      static_cast<Int_32>(cell_proc.height()) != tile_height)
+    {
+      cell_proc.resize(
+        static_cast<Coord>(tile_width),
+        static_cast<Coord>(tile_height));
+    }
+
+    for(auto const& tile_command : tile_commands)
+    {
+      auto const& command = list[tile_command.command];
+
+      for(Size i = tile_command.segment_begin; tile_command.segment_end > i;
+        ++i)
+      {
+        auto const& segment = band.segments[i];
+        worker.rasterizer.add_line_fixed_24_dot_8(
+          cell_proc,
+          segment.x_0 - shift_x,
+          segment.y_0 - shift_y,
+          segment.x_1 - shift_x,
+          segment.y_1 - shift_y,
+          0,
+          tile_height - 1);
+      }
+
+      if(no_covers_ != tile_command.covers)
+      {
+        Int_32 const* const covers = band.covers.data() + tile_command.covers;
+        for(Int_32 r = 0; tile_height > r; ++r)
+        {
+          if(0 != covers[r])
+          {
+            cell_proc.set_y(r);
+            cell_proc.set_x(-1);
+            cell_proc.set_cell(covers[r], 0);
+          }
+        }
+      }
+
+      // The swipe stops at the last cell of a row. Lines right of the tile
+      // were not rasterized, so extend the rows they could still cover.
+      auto const& segments = command.segments;
+      if(static_cast<Int_32>(column) < segments.column_max() >> tile_bits_)
+      {
+        Int_32 r = segments.row_min() - y_0;
+        Int_32 r_last = segments.row_max() - y_0;
+        if(0 > r)
+        {
+          r = 0;
+        }
+        if(tile_height <= r_last)
+        {
+          r_last = tile_height - 1;
+        }
+
+        for(; r_last >= r; ++r)
+        {
+          cell_proc.set_y(r);
+          cell_proc.set_x(tile_width);
+          cell_proc.set_cell(0, 0);
+        }
+      }
+
+      Offset_blender<Blender> blender(command.blender, x_0, y_0);
+      Pixel_box command_box = cell_proc.swipe(blender, command.fill_rule);
+      if(command_box)
+      {
+        command_box.x_min += x_0;
+        command_box.x_max += x_0;
+        command_box.y_min += y_0;
+        command_box.y_max += y_0;
+        box.unite(command_box);
+      }
+    }
+
+    return box;
+  }
+
+  Thread_pool& pool_;
+  Vector_<Worker_> workers_;
+  Vector_<Band_> bands_;
+  Vector_<Pixel_box> tile_boxes_;
+  Coord width_;
+  Coord height_;
+};
+
+} // namespace vgxx
+
+#endif // VGXX_TILERENDERER_HH
@@ -72,6 +72,26 @@ public:
     return to_fixed_<64u>(x);
   }
 
+  // Splits a coordinate into whole pixels and a subpixel phase in
+  // 1/steps of a pixel, rounding to the nearest phase.
+  static void split_subpixel(
+    float const v,
+    Int_32 const steps,
+    Int_32& whole,
+    Int_32& phase) noexcept
+  {
+    float const floor_v = ::std::floor(v);
+    whole = static_cast<Int_32>(floor_v);
+    phase = static_cast<Int_32>(
+      (v - floor_v) * static_cast<float>(steps) + 0.5f);
+
+    if(steps <= phase)
+    {
+      phase = 0;
+      ++whole;
+    }
+  }
+
   [[nodiscard]] static Int_32 blend(
     Int_32 const src,
     Int_32 const dst,
@@ -178,8 +198,10 @@ public:
     }
   }
 
+  // Covered part of a cell after applying the fill rule, from 0 to
+  // 0x20000 for the whole cell.
   template<Fill_rule fill_rule>
-  [[nodiscard]] static Unt_8 compute_cell_coverage(
+  [[nodiscard]] static Int_32 compute_cell_area(
     Int_32 const cover,
     Int_32 const area) noexcept
   {
@@ -214,11 +236,26 @@ public:
       }
     }
 
+    return c;
+  }
+
+  // Converts a cell area from compute_cell_area() to coverage.
+  [[nodiscard]] static Unt_8 cell_area_to_coverage(Int_32 c) noexcept
+  {
     c >>= 9u;
     c = ((c << 8u) - c) >> 8u;  // c * 255 / 256
     return static_cast<Unt_8>(c);
   }
 
+  template<Fill_rule fill_rule>
+  [[nodiscard]] static Unt_8 compute_cell_coverage(
+    Int_32 const cover,
+    Int_32 const area) noexcept
+  {
+    return cell_area_to_coverage(
+      compute_cell_area<fill_rule>(cover, area));
+  }
+
   [[nodiscard]] static Unt_8 compute_cell_coverage(
     Int_32 const cover,
     Int_32 const area,